@@ -1,36 +1,77 @@
-// AudioClasses.cpp : This file contains the 'main' function. Program execution begins and ends there.
-//
-#include <iostream>
-#include <fstream>
-#include <cmath>
-
-#include "BQfilter.h"
-#include "DelayLine.h"
-#include "LPAPfilter.h"
-#include "LPcombfilter.h"
-#include "SOSfilter.h"
-#include "SSfilter.h"
-
-int main()
-{
-	std::ofstream impresp;
-	double roomLength = 10.0;
-	double samplingRate = 44100.0;
-	double absCoef = 0.2;
-	double speedSound = 343.0;
-	double timeIR = 1.0;
-
-	impresp.open("impresp.txt", std::ofstream::out);
-	double damping = (1.0 - pow(10, -absCoef * roomLength / 20.0))/ (1.0 + pow(10, -absCoef * roomLength / 20.0));
-	unsigned int sampDelay = round(roomLength * samplingRate / speedSound);
-	unsigned int numSamp = round(samplingRate * timeIR);
-
-	SOSfilter filt;
-	filt.initsos(2, samplingRate);
-	filt.updateSection(0, FilterType::PEAK, 1.0, 100.0, 2.0);
-	filt.updateSection(1, FilterType::PEAK, -1.0, 1000.0, 2.0);
-	impresp << filt.step(1.0) << std::endl;
-	for (auto n = 1; n < numSamp; n++)
-		impresp << filt.step(0.0) << std::endl;
-
+// AudioClasses.cpp : This file contains the 'main' function. Program execution begins and ends there.
+//
+#include <iostream>
+#include <cmath>
+#include <vector>
+
+#include "BQfilter.h"
+#include "DelayLine.h"
+#include "LPAPfilter.h"
+#include "LPcombfilter.h"
+#include "SOSfilter.h"
+#include "SSfilter.h"
+#include "WavFile.h"
+
+// Usage: AudioClasses [input.wav output.wav]
+// With no arguments, the impulse response of the filter is written to impresp.wav. Given two
+// file names, the input file is streamed through the filter, one block at a time.
+int main(int argc, char* argv[])
+{
+	double roomLength = 10.0;
+	double samplingRate = 44100.0;
+	double absCoef = 0.2;
+	double speedSound = 343.0;
+	double timeIR = 1.0;
+
+	double damping = (1.0 - pow(10, -absCoef * roomLength / 20.0))/ (1.0 + pow(10, -absCoef * roomLength / 20.0));
+	unsigned int sampDelay = round(roomLength * samplingRate / speedSound);
+	unsigned int numSamp = round(samplingRate * timeIR);
+
+	if (argc == 3)
+	{
+		WavReader infile;
+		if (!infile.open(argv[1]))
+		{
+			std::cerr << "cannot read " << argv[1] << std::endl;
+			return 1;
+		}
+		std::vector<SOSfilter> filts(infile.getnumchannels());
+		for (auto& filt : filts)
+		{
+			filt.initsos(2, infile.getsamplerate());
+			filt.updateSection(0, FilterType::PEAK, 1.0, 100.0, 2.0);
+			filt.updateSection(1, FilterType::PEAK, -1.0, 1000.0, 2.0);
+		}
+		WavWriter outfile;
+		if (!outfile.open(argv[2], infile.getnumchannels(), infile.getsamplerate(), infile.getformat()))
+		{
+			std::cerr << "cannot write " << argv[2] << std::endl;
+			return 1;
+		}
+		renderfile(infile, outfile, [&](float* const* channels, int numframes) {
+			for (size_t ch = 0; ch < filts.size(); ch++)
+				filts[ch].procblock(channels[ch], numframes);
+		});
+		return outfile.close() ? 0 : 1;
+	}
+
+	SOSfilter filt;
+	filt.initsos(2, samplingRate);
+	filt.updateSection(0, FilterType::PEAK, 1.0, 100.0, 2.0);
+	filt.updateSection(1, FilterType::PEAK, -1.0, 1000.0, 2.0);
+	WavWriter impresp;
+	if (!impresp.open("impresp.wav", 1, samplingRate))
+		return 1;
+	const int blockSize = 4096;
+	std::vector<float> block(blockSize, 0.0f);
+	block[0] = 1.0f;
+	for (unsigned int start = 0; start < numSamp; start += blockSize)
+	{
+		int len = numSamp - start < blockSize ? numSamp - start : blockSize;
+		float* channel = block.data();
+		filt.procblock(channel, len);
+		impresp.write(&channel, len);
+		block.assign(blockSize, 0.0f);
+	}
+	return impresp.close() ? 0 : 1;
 }
\ No newline at end of file
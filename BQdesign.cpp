@@ -0,0 +1,131 @@
+/*
+  ==============================================================================
+
+    BQdesign.cpp
+
+  ==============================================================================
+*/
+
+#include <cmath>
+#include <cstring>
+#include "BQdesign.h"
+
+void designbq(FilterType ftype, double Gain, double f0, double Q, double fs, double* bcoefs, double* acoefs)
+{
+	const double PI = 3.141592653589793238463;
+	double gain = pow(10.0, std::abs(Gain) / 20.0);
+	double w0 = 2.0 * PI * f0;
+	double w0sq = w0 * w0;
+
+	// compute analog filter coefficients
+	double B[3]{};
+	double A[3]{};
+	A[0] = 1.0;
+	switch (ftype)
+	{
+	case FilterType::BASS:
+		B[0] = 1.0;
+		B[1] = 2.0 * sqrt(gain) * w0 / Q;
+		B[2] = gain * w0sq;
+		A[1] = 2.0 * w0 / Q;
+		A[2] = w0sq;
+		break;
+	case FilterType::TREBLE:
+		B[0] = gain;
+		B[1] = 2.0 * gain * w0 / Q;
+		B[2] = gain * w0sq;
+		A[1] = 2.0 * sqrt(gain) * w0 / Q;
+		A[2] = gain * w0sq;
+		break;
+	case FilterType::PEAK:
+		B[0] = 1.0;
+		B[1] = gain * w0 / Q;
+		B[2] = w0sq;
+		A[1] = w0 / Q;
+		A[2] = w0sq;
+		break;
+	default:
+		break;
+	}
+	if (Gain < 0.0) // invert analog transfer function
+	{
+		double x;
+		for (int n = 0; n < 3; n++)
+		{
+			x = B[n];
+			B[n] = A[n];
+			A[n] = x;
+		}
+	}
+
+	// Use bilinear transform to compute digital filter coefficients
+	double K = w0 / tan(PI * f0 / fs);
+	double Ksq = K * K;
+	double D = A[0] * Ksq + A[1] * K + A[2];
+
+	acoefs[0] = 1.0;
+	acoefs[1] = 2.0 * (A[2] - A[0] * Ksq) / D;
+	acoefs[2] = (A[0] * Ksq - A[1] * K + A[2]) / D;
+	bcoefs[0] = (B[0] * Ksq + B[1] * K + B[2]) / D;
+	bcoefs[1] = 2.0 * (B[2] - B[0] * Ksq) / D;
+	bcoefs[2] = (B[0] * Ksq - B[1] * K + B[2]) / D;
+}
+
+bool BQcoefcache::Key::operator==(const Key& other) const
+{
+	return ftype == other.ftype && Gain == other.Gain && f0 == other.f0 && Q == other.Q && fs == other.fs;
+}
+
+size_t BQcoefcache::KeyHash::operator()(const Key& key) const
+{
+	// FNV-1a style mix of the bit patterns of the parameters. -0.0 == +0.0, so zeros are
+	// hashed as +0.0 to keep equal keys in the same bucket
+	unsigned long long h = 14695981039346656037ULL ^ (unsigned long long)key.ftype;
+	for (double x : { key.Gain, key.f0, key.Q, key.fs })
+	{
+		if (x == 0.0)
+			x = 0.0;
+		unsigned long long bits;
+		std::memcpy(&bits, &x, sizeof(bits));
+		h = (h ^ bits) * 1099511628211ULL;
+		h ^= h >> 29;
+	}
+	return size_t(h);
+}
+
+BQcoefcache::BQcoefcache(unsigned int maxentries)
+{
+	maxsize = maxentries;
+	hits = 0;
+	misses = 0;
+	table.reserve(maxentries);
+}
+
+void BQcoefcache::design(FilterType ftype, double Gain, double f0, double Q, double fs, double* bcoefs, double* acoefs)
+{
+	// A NaN key never compares equal to itself, so it could only fill the table with misses
+	if (std::isnan(Gain) || std::isnan(f0) || std::isnan(Q) || std::isnan(fs))
+	{
+		misses++;
+		designbq(ftype, Gain, f0, Q, fs, bcoefs, acoefs);
+		return;
+	}
+	Key key{ ftype, Gain, f0, Q, fs };
+	auto found = table.find(key);
+	if (found == table.end())
+	{
+		misses++;
+		Coefs coefs;
+		designbq(ftype, Gain, f0, Q, fs, coefs.b, coefs.a);
+		if (table.size() >= maxsize)
+			table.clear();
+		found = table.emplace(key, coefs).first;
+	}
+	else
+		hits++;
+	for (int n = 0; n < 3; n++)
+	{
+		bcoefs[n] = found->second.b[n];
+		acoefs[n] = found->second.a[n];
+	}
+}
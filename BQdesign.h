@@ -0,0 +1,107 @@
+/*
+  ==============================================================================
+
+    BQdesign.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <unordered_map>
+#include "BQfilter.h"
+
+/// <summary>
+/// Design biquadratic filter coefficients
+///
+/// Computes the digital filter coefficients used by BQfilter::update(). The analog prototype is
+/// mapped to the digital domain with the bilinear transform, prewarped at f0.
+/// </summary>
+/// <param name="ftype">filter type (BASS, TREBLE, PEAK)</param>
+/// <param name="Gain">gain (dB)</param>
+/// <param name="f0">center or cutoff frequency (Hz)</param>
+/// <param name="Q">Q factor (no units)</param>
+/// <param name="fs">sampling frequency (Hz)</param>
+/// <param name="bcoefs">array of 3 numerator coefficients (output)</param>
+/// <param name="acoefs">array of 3 denominator coefficients (output)</param>
+void designbq(FilterType ftype, double Gain, double f0, double Q, double fs, double* bcoefs, double* acoefs);
+
+/// <summary>
+/// Memoizing biquad coefficient designer
+///
+/// Designed coefficients are remembered, keyed on (FilterType, Gain, f0, Q, fs), so that
+/// automating a parameter through a small set of values (e.g. a control quantized to a slider
+/// resolution, or many sections sharing settings) costs a hash lookup rather than a redesign.
+/// When the table reaches its maximum size it is cleared. The cache is not thread safe; use one
+/// per thread.
+/// </summary>
+class BQcoefcache
+{
+public:
+	/// <summary>
+	/// Constructor
+	/// </summary>
+	/// <param name="maxentries">maximum number of designs remembered</param>
+	BQcoefcache(unsigned int maxentries = 4096);
+	~BQcoefcache() {}
+
+	/// <summary>
+	/// Look up or design filter coefficients
+	/// 
+	/// Parameters that include a NaN are designed directly and not cached.
+	/// </summary>
+	/// <param name="ftype">filter type (BASS, TREBLE, PEAK)</param>
+	/// <param name="Gain">gain (dB)</param>
+	/// <param name="f0">center or cutoff frequency (Hz)</param>
+	/// <param name="Q">Q factor (no units)</param>
+	/// <param name="fs">sampling frequency (Hz)</param>
+	/// <param name="bcoefs">array of 3 numerator coefficients (output)</param>
+	/// <param name="acoefs">array of 3 denominator coefficients (output)</param>
+	void design(FilterType ftype, double Gain, double f0, double Q, double fs, double* bcoefs, double* acoefs);
+
+	/// <summary>
+	/// Forget all remembered designs
+	/// </summary>
+	void clear() { table.clear(); }
+
+	/// <summary>
+	/// Get number of remembered designs
+	/// </summary>
+	/// <returns>number of entries</returns>
+	unsigned int size() { return table.size(); }
+
+	/// <summary>
+	/// Get number of lookups that found a remembered design
+	/// </summary>
+	/// <returns>number of hits</returns>
+	unsigned long gethits() { return hits; }
+
+	/// <summary>
+	/// Get number of lookups that required a new design
+	/// </summary>
+	/// <returns>number of misses</returns>
+	unsigned long getmisses() { return misses; }
+
+private:
+	struct Key
+	{
+		FilterType ftype;
+		double Gain, f0, Q, fs;
+		bool operator==(const Key& other) const;
+	};
+	struct KeyHash
+	{
+		size_t operator()(const Key& key) const;
+	};
+	struct Coefs
+	{
+		double b[3];
+		double a[3];
+	};
+
+	std::unordered_map<Key, Coefs, KeyHash> table;
+	unsigned int maxsize;
+	unsigned long hits;
+	unsigned long misses;
+};
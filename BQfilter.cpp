@@ -1,114 +1,237 @@
-/*
-  ==============================================================================
-
-    BQfilter.cpp
-    Created: 10 Jan 2018 9:40:18am
-    Author:  profw
-
-  ==============================================================================
-*/
-
-#include <cmath>
-#include "BQfilter.h"
-
-BQfilter::BQfilter()
-{
-	// initialize state and coefficients
-	s1 = 0.0;
-	s2 = 0.0;
-	for (int n = 0; n < 3; n++)
-	{
-		a[n] = 0.0;
-		b[n] = 0.0;
-	}
-}
-
-void BQfilter::update(FilterType ftype, double Gain, double f0, double Q, double fs)
-{
-	const double PI = 3.141592653589793238463;
-	double gain = pow(10.0, abs(Gain) / 20.0);
-	double w0 = 2.0 * PI * f0;
-
-	// compute analog filter coefficients
-	double B[3]{};
-	double A[3]{};
-	A[0] = 1.0;
-	switch (ftype)
-	{
-	case FilterType::BASS:
-		B[0] = 1.0;
-		B[1] = 2.0 * sqrt(gain) * w0 / Q;
-		B[2] = gain * pow(w0, 2.0);
-		A[1] = 2.0 * w0 / Q;
-		A[2] = pow(w0, 2.0);
-		break;
-	case FilterType::TREBLE:
-		B[0] = gain;
-		B[1] = 2.0 * gain * w0 / Q;
-		B[2] = gain * pow(w0, 2.0);
-		A[1] = 2.0 * sqrt(gain) * w0 / Q;
-		A[2] = gain * pow(w0, 2.0);
-		break;
-	case FilterType::PEAK:
-		B[0] = 1.0f;
-		B[1] = gain * w0 / Q;
-		B[2] = pow(w0, 2);
-		A[1] = w0 / Q;
-		A[2] = pow(w0, 2.0);
-		break;
-	default:
-		break;
-	}
-	if (Gain < 0.0) // invert analog transfer function
-	{
-		double x;
-		for (int n = 0; n < 3; n++)
-		{
-			x = B[n];
-			B[n] = A[n];
-			A[n] = x;
-		}
-	}
-
-	// Use bilinear transform to compute digital filter coefficients
-	double K = w0 / tan(PI * f0 / fs);
-	double D = A[0] * pow(K, 2.0) + A[1] * K + A[2];
-
-	a[0] = 1.0;
-	a[1] = 2.0 * (A[2] - A[0] * pow(K, 2.0)) / D;
-	a[2] = (A[0] * pow(K, 2.0) - A[1] * K + A[2]) / D;
-	b[0] = (B[0] * pow(K, 2.0) + B[1] * K + B[2]) / D;
-	b[1] = 2.0f * (B[2] - B[0] * pow(K, 2.0)) / D;
-	b[2] = (B[0] * pow(K, 2.0) - B[1] * K + B[2]) / D;
-}
-
-double BQfilter::step(double sample)
-{
-	double y = b[0] * sample + s1;
-	s1 = s2 + b[1] * sample - a[1] * y;
-	s2 = b[2] * sample - a[2] * y;
-	return y;
-}
-
-void BQfilter::resetstate(void)
-{
-	s1 = 0.0;
-	s2 = 0.0;
-}
-
-double BQfilter::freqresp(double freq, float fs)
-{
-	// Compute magnitude of frequency response at frequency theta (radians/sample)
-	// Double precision apparently necessary
-	const double PI = 3.141592653589793238463;
-	double B0 = pow(b[0], 2.0) + pow(b[1], 2.0) + pow(b[2], 2.0);
-	double B1 = 2.0 * (b[0] * b[1] + b[1] * b[2]);
-	double B2 = 2.0 * b[0] * b[2];
-	double A0 = 1.0 + pow(a[1], 2.0) + pow(a[2], 2.0);
-	double A1 = 2.0 * (a[1] + a[1] * a[2]);
-	double A2 = 2.0 * a[2];
-	double theta = 2.0 * PI * freq / fs;
-
-	double h = abs((B0 + B1 * cos(theta) + B2 * cos(2.0 * theta)) / (A0 + A1 * cos(theta) + A2 * cos(2.0 * theta)));
-	return (isnan(h) ? 0.0 : 10.0 * log10(h)); // in case of 0.0 / 0.0
-}
\ No newline at end of file
+/*
+  ==============================================================================
+
+    BQfilter.cpp
+    Created: 10 Jan 2018 9:40:18am
+    Author:  profw
+
+  ==============================================================================
+*/
+
+#include <cmath>
+#include "BQfilter.h"
+#include "BQdesign.h"
+#include "FreqGrid.h"
+#include "StateSnapshot.h"
+
+template <typename C>
+BQfilterT<C>::BQfilterT()
+{
+	// initialize state and coefficients
+	s1 = 0.0;
+	s2 = 0.0;
+	for (int n = 0; n < 3; n++)
+	{
+		a[n] = 0.0;
+		b[n] = 0.0;
+		atarget[n] = 0.0;
+		btarget[n] = 0.0;
+		astep[n] = 0.0;
+		bstep[n] = 0.0;
+	}
+	smoothing = 0;
+	rampcount = 0;
+}
+
+template <typename C>
+void BQfilterT<C>::update(FilterType ftype, double Gain, double f0, double Q, double fs)
+{
+	double bcoefs[3], acoefs[3];
+	designbq(ftype, Gain, f0, Q, fs, bcoefs, acoefs);
+	setcoefs(bcoefs, acoefs);
+}
+
+template <typename C>
+void BQfilterT<C>::update(FilterType ftype, double Gain, double f0, double Q, double fs, BQcoefcache& cache)
+{
+	double bcoefs[3], acoefs[3];
+	cache.design(ftype, Gain, f0, Q, fs, bcoefs, acoefs);
+	setcoefs(bcoefs, acoefs);
+}
+
+template <typename C>
+void BQfilterT<C>::advanceramp()
+{
+	if (--rampcount == 0)
+	{
+		// land exactly on the target
+		for (int n = 0; n < 3; n++)
+		{
+			b[n] = btarget[n];
+			a[n] = atarget[n];
+		}
+	}
+	else
+	{
+		for (int n = 0; n < 3; n++)
+		{
+			b[n] += bstep[n];
+			a[n] += astep[n];
+		}
+	}
+}
+
+template <typename C>
+template <typename SampleType>
+void BQfilterT<C>::procsamples(const SampleType* insamples, SampleType* outsamples, int numsamples)
+{
+	// Samples during a coefficient interpolation go through step()
+	int start = 0;
+	for (; start < numsamples && rampcount > 0; start++)
+		outsamples[start] = SampleType(step(C(insamples[start])));
+
+	// Same recursion as step(), with state and coefficients held in registers
+	const C b0 = b[0], b1 = b[1], b2 = b[2];
+	const C a1 = a[1], a2 = a[2];
+	C z1 = s1;
+	C z2 = s2;
+	for (int n = start; n < numsamples; n++)
+	{
+		C x = C(insamples[n]);
+		C y = b0 * x + z1;
+		z1 = z2 + b1 * x - a1 * y;
+		z2 = b2 * x - a2 * y;
+		outsamples[n] = SampleType(y);
+	}
+	s1 = z1;
+	s2 = z2;
+}
+
+template <typename C>
+void BQfilterT<C>::procblock(const float* insamples, float* outsamples, int numsamples)
+{
+	procsamples(insamples, outsamples, numsamples);
+}
+
+template <typename C>
+void BQfilterT<C>::procblock(const double* insamples, double* outsamples, int numsamples)
+{
+	procsamples(insamples, outsamples, numsamples);
+}
+
+template <typename C>
+void BQfilterT<C>::resetstate(void)
+{
+	s1 = 0.0;
+	s2 = 0.0;
+}
+
+template <typename C>
+void BQfilterT<C>::setcoefs(const double* bcoefs, const double* acoefs)
+{
+	// a[0] is zero only before the first design
+	if (smoothing > 0 && a[0] != 0.0)
+	{
+		for (int n = 0; n < 3; n++)
+		{
+			btarget[n] = C(bcoefs[n]);
+			atarget[n] = C(acoefs[n]);
+			bstep[n] = C((bcoefs[n] - b[n]) / smoothing);
+			astep[n] = C((acoefs[n] - a[n]) / smoothing);
+		}
+		rampcount = smoothing;
+	}
+	else
+	{
+		for (int n = 0; n < 3; n++)
+		{
+			b[n] = C(bcoefs[n]);
+			a[n] = C(acoefs[n]);
+		}
+		rampcount = 0;
+	}
+}
+
+template <typename C>
+void BQfilterT<C>::getcoefs(double* bcoefs, double* acoefs) const
+{
+	for (int n = 0; n < 3; n++)
+	{
+		bcoefs[n] = b[n];
+		acoefs[n] = a[n];
+	}
+}
+
+template <typename C>
+double BQfilterT<C>::freqresp(double freq, float fs)
+{
+	// Compute magnitude of frequency response at frequency theta (radians/sample)
+	// Double precision apparently necessary
+	const double PI = 3.141592653589793238463;
+	double B0 = pow(b[0], 2.0) + pow(b[1], 2.0) + pow(b[2], 2.0);
+	double B1 = 2.0 * (b[0] * b[1] + b[1] * b[2]);
+	double B2 = 2.0 * b[0] * b[2];
+	double A0 = 1.0 + pow(a[1], 2.0) + pow(a[2], 2.0);
+	double A1 = 2.0 * (a[1] + a[1] * a[2]);
+	double A2 = 2.0 * a[2];
+	double theta = 2.0 * PI * freq / fs;
+
+	double h = std::abs((B0 + B1 * cos(theta) + B2 * cos(2.0 * theta)) / (A0 + A1 * cos(theta) + A2 * cos(2.0 * theta)));
+	return (std::isnan(h) ? 0.0 : 10.0 * log10(h)); // in case of 0.0 / 0.0
+}
+
+template <typename C>
+void BQfilterT<C>::freqresp(const FreqGrid& grid, double* magdB, double* phase, double* grpdelay,
+	FreqScratch* scratch) const
+{
+	// the grid evaluates double precision sections
+	double bcoefs[3], acoefs[3];
+	getcoefs(bcoefs, acoefs);
+	BQfilter section;
+	section.setcoefs(bcoefs, acoefs);
+	grid.cascaderesp(&section, 1, magdB, phase, grpdelay, scratch);
+}
+
+template <typename C>
+void BQfilterT<C>::savestate(SnapshotWriter& writer) const
+{
+	writer.begin(snapshottag("BQFL"));
+	writer.put(std::uint32_t(sizeof(C)));
+	writer.put(s1);
+	writer.put(s2);
+	writer.put(std::int32_t(smoothing));
+	writer.put(std::int32_t(rampcount));
+	for (int n = 0; n < 3; n++)
+	{
+		writer.put(b[n]);
+		writer.put(a[n]);
+		writer.put(btarget[n]);
+		writer.put(atarget[n]);
+		writer.put(bstep[n]);
+		writer.put(astep[n]);
+	}
+	writer.end();
+}
+
+template <typename C>
+bool BQfilterT<C>::loadstate(SnapshotReader& reader)
+{
+	// Read into a copy, so the filter is unchanged if the record does not match
+	BQfilterT<C> saved;
+	std::uint32_t size;
+	std::int32_t smooth = 0, ramp = 0;
+	if (!reader.begin(snapshottag("BQFL")) || !reader.get(size) || size != sizeof(C))
+		return false;
+	reader.get(saved.s1);
+	reader.get(saved.s2);
+	reader.get(smooth);
+	reader.get(ramp);
+	for (int n = 0; n < 3; n++)
+	{
+		reader.get(saved.b[n]);
+		reader.get(saved.a[n]);
+		reader.get(saved.btarget[n]);
+		reader.get(saved.atarget[n]);
+		reader.get(saved.bstep[n]);
+		reader.get(saved.astep[n]);
+	}
+	if (!reader.end())
+		return false;
+	saved.smoothing = smooth;
+	saved.rampcount = ramp;
+	*this = saved;
+	return true;
+}
+
+template class BQfilterT<float>;
+template class BQfilterT<double>;
@@ -1,76 +1,222 @@
-/*
-  ==============================================================================
-
-    BQfilter.h
-    Created: 10 Jan 2018 9:40:18am
-    Author:  profw
-
-  ==============================================================================
-*/
-
-#pragma once
-
-/// <summary>
-/// This class enumerates the filter types
-/// </summary>
-enum class FilterType { 
-	BASS, ///< bass shelf filter
-	TREBLE, ///< treble shelf filter
-	PEAK /// <peak filter
-};
-
-
-
-
-/// <summary>
-/// Biquadratic filter (aka SOS)
-/// 
-/// The class implements a biquadratic digital filter, sometimes known as a second order section (SOS).
-/// </summary>
-class BQfilter
-{
-public:
-	BQfilter();
-	~BQfilter() {}
-
-	/// <summary>
-	/// Update filter coefficients
-	/// 
-	/// This method sets the filter coefficients based on parameters provided by the caller
-	/// </summary>
-	/// <param name="ftype">filter type (BASS, TREBLE, PEAK)</param>
-	/// <param name="Gain">gain (dB)</param>
-	/// <param name="f0">center or cutoff frequency (Hz)</param>
-	/// <param name="Q">Q factor (no units)</param>
-	/// <param name="fs">sampling frequency (Hz)</param>
-	void update(FilterType ftype, double Gain, double f0, double Q, double fs);
-
-	/// <summary>
-	/// Step the filter through one sample period
-	/// </summary>
-	/// <param name="sample">input sample</param>
-	/// <returns>output sample</returns>
-	double step(double sample);
-
-	/// <summary>
-	/// Reset the filter state variables
-	/// </summary>
-	/// <param name=""></param>
-	void resetstate();
-
-	/// <summary>
-	/// Magnitude of frequency response at a given frequency.
-	/// </summary>
-	/// <param name="freq">frequency (Hz)</param>
-	/// <param name="fs">sampling frequency (Hz)</param>
-	/// <returns>magnitude of frequency response (dB)</returns>
-	double freqresp(double freq, float fs);
-
-private:
-	// state variables
-	double s1;
-	double s2;
-	// coefficients
-	double b[3];
-	double a[3];
-};
\ No newline at end of file
+/*
+  ==============================================================================
+
+    BQfilter.h
+    Created: 10 Jan 2018 9:40:18am
+    Author:  profw
+
+  ==============================================================================
+*/
+
+#pragma once
+
+class BQcoefcache;
+class FreqGrid;
+class FreqScratch;
+class SnapshotReader;
+class SnapshotWriter;
+
+/// <summary>
+/// This class enumerates the filter types
+/// </summary>
+enum class FilterType { 
+	BASS, ///< bass shelf filter
+	TREBLE, ///< treble shelf filter
+	PEAK /// <peak filter
+};
+
+
+
+
+/// <summary>
+/// Biquadratic filter (aka SOS)
+/// 
+/// The class implements a biquadratic digital filter, sometimes known as a second order section (SOS).
+/// The template parameter is the type of the coefficients and state variables (float or double).
+/// Coefficients are always designed in double precision and rounded when they are set, so a
+/// single precision filter trades accuracy (mostly at low frequencies) for half the memory and
+/// twice the SIMD width. BQfilter is the double precision filter.
+/// </summary>
+template <typename C>
+class BQfilterT
+{
+public:
+	BQfilterT();
+	~BQfilterT() {}
+
+	/// <summary>
+	/// Update filter coefficients
+	/// 
+	/// This method sets the filter coefficients based on parameters provided by the caller
+	/// </summary>
+	/// <param name="ftype">filter type (BASS, TREBLE, PEAK)</param>
+	/// <param name="Gain">gain (dB)</param>
+	/// <param name="f0">center or cutoff frequency (Hz)</param>
+	/// <param name="Q">Q factor (no units)</param>
+	/// <param name="fs">sampling frequency (Hz)</param>
+	void update(FilterType ftype, double Gain, double f0, double Q, double fs);
+
+	/// <summary>
+	/// Update filter coefficients using a coefficient cache
+	/// 
+	/// Same as update(), but the design is looked up in (or added to) the given cache.
+	/// </summary>
+	/// <param name="ftype">filter type (BASS, TREBLE, PEAK)</param>
+	/// <param name="Gain">gain (dB)</param>
+	/// <param name="f0">center or cutoff frequency (Hz)</param>
+	/// <param name="Q">Q factor (no units)</param>
+	/// <param name="fs">sampling frequency (Hz)</param>
+	/// <param name="cache">coefficient cache</param>
+	void update(FilterType ftype, double Gain, double f0, double Q, double fs, BQcoefcache& cache);
+
+	/// <summary>
+	/// Set coefficient smoothing
+	/// 
+	/// When smoothing is enabled, new coefficients from update() or setcoefs() are reached by
+	/// linear interpolation over the given number of samples, which avoids zipper noise when
+	/// parameters are updated at a coarse control rate. Since the stability region of the
+	/// denominator coefficients is convex, interpolating between two stable filters is stable.
+	/// The first design of a new filter is always applied immediately.
+	/// </summary>
+	/// <param name="numsamples">length of the interpolation (0 disables smoothing)</param>
+	void setsmoothing(int numsamples) { smoothing = numsamples; }
+
+	/// <summary>
+	/// Check whether a coefficient interpolation is in progress
+	/// </summary>
+	/// <returns>true while coefficients are being interpolated</returns>
+	bool isramping() const { return rampcount > 0; }
+
+	/// <summary>
+	/// Step the filter through one sample period
+	/// </summary>
+	/// <param name="sample">input sample</param>
+	/// <returns>output sample</returns>
+	C step(C sample);
+
+	/// <summary>
+	/// Process a block of samples
+	/// 
+	/// The state variables are kept in local variables for the duration of the block, so this
+	/// is considerably faster than calling step() for each sample.
+	/// </summary>
+	/// <param name="insamples">pointer to first input sample</param>
+	/// <param name="outsamples">pointer to first output sample (may be the same as insamples)</param>
+	/// <param name="numsamples">number of samples in the block</param>
+	void procblock(const float* insamples, float* outsamples, int numsamples);
+
+	/// <summary>
+	/// Process a block of double precision samples
+	/// </summary>
+	/// <param name="insamples">pointer to first input sample</param>
+	/// <param name="outsamples">pointer to first output sample (may be the same as insamples)</param>
+	/// <param name="numsamples">number of samples in the block</param>
+	void procblock(const double* insamples, double* outsamples, int numsamples);
+
+	/// <summary>
+	/// Process a block of samples in place
+	/// 
+	/// Note: this method modifies the input samples - they become the output samples.
+	/// </summary>
+	/// <param name="samples">pointer to first audio sample</param>
+	/// <param name="numsamples">number of samples in the block</param>
+	void procblock(float* samples, int numsamples) { procblock(samples, samples, numsamples); }
+
+	/// <summary>
+	/// Process a block of double precision samples in place
+	/// </summary>
+	/// <param name="samples">pointer to first audio sample</param>
+	/// <param name="numsamples">number of samples in the block</param>
+	void procblock(double* samples, int numsamples) { procblock(samples, samples, numsamples); }
+
+	/// <summary>
+	/// Reset the filter state variables
+	/// </summary>
+	/// <param name=""></param>
+	void resetstate();
+
+	/// <summary>
+	/// Magnitude of frequency response at a given frequency.
+	/// </summary>
+	/// <param name="freq">frequency (Hz)</param>
+	/// <param name="fs">sampling frequency (Hz)</param>
+	/// <returns>magnitude of frequency response (dB)</returns>
+	double freqresp(double freq, float fs);
+
+	/// <summary>
+	/// Frequency response at every frequency of a grid
+	/// </summary>
+	/// <param name="grid">frequency grid</param>
+	/// <param name="magdB">magnitude of frequency response (dB) (output)</param>
+	/// <param name="phase">phase (radians) (output, optional)</param>
+	/// <param name="grpdelay">group delay (samples) (output, optional)</param>
+	/// <param name="scratch">scratch arrays for the phase (see FreqScratch) (optional)</param>
+	void freqresp(const FreqGrid& grid, double* magdB, double* phase = nullptr, double* grpdelay = nullptr,
+		FreqScratch* scratch = nullptr) const;
+
+	/// <summary>
+	/// Set filter coefficients directly
+	/// 
+	/// The coefficients are interpolated if smoothing is enabled.
+	/// </summary>
+	/// <param name="bcoefs">array of 3 numerator coefficients</param>
+	/// <param name="acoefs">array of 3 denominator coefficients (acoefs[0] is assumed to be 1)</param>
+	void setcoefs(const double* bcoefs, const double* acoefs);
+
+	/// <summary>
+	/// Get filter coefficients
+	/// </summary>
+	/// <param name="bcoefs">array of 3 numerator coefficients (output)</param>
+	/// <param name="acoefs">array of 3 denominator coefficients (output)</param>
+	void getcoefs(double* bcoefs, double* acoefs) const;
+
+	/// <summary>
+	/// Write the state variables, coefficients and any interpolation in progress to a snapshot
+	/// </summary>
+	/// <param name="writer">snapshot</param>
+	void savestate(SnapshotWriter& writer) const;
+
+	/// <summary>
+	/// Restore everything written by savestate()
+	/// </summary>
+	/// <param name="reader">snapshot</param>
+	/// <returns>false if the next record is not a filter of this type</returns>
+	bool loadstate(SnapshotReader& reader);
+
+private:
+	friend class SOSfilter;
+	template <int N> friend class FixedSOSfilter;
+
+	template <typename SampleType>
+	void procsamples(const SampleType* insamples, SampleType* outsamples, int numsamples);
+
+	void advanceramp();
+
+	// state variables
+	C s1;
+	C s2;
+	// coefficients
+	C b[3];
+	C a[3];
+	// coefficient interpolation
+	int smoothing;
+	int rampcount;
+	C btarget[3];
+	C atarget[3];
+	C bstep[3];
+	C astep[3];
+};
+
+typedef BQfilterT<double> BQfilter;
+
+// Defined here so that it can be inlined into SOS cascades
+template <typename C>
+inline C BQfilterT<C>::step(C sample)
+{
+	if (rampcount > 0)
+		advanceramp();
+	C y = b[0] * sample + s1;
+	s1 = s2 + b[1] * sample - a[1] * y;
+	s2 = b[2] * sample - a[2] * y;
+	return y;
+}
\ No newline at end of file
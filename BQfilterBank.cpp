@@ -0,0 +1,123 @@
+/*
+  ==============================================================================
+
+    BQfilterBank.cpp
+
+  ==============================================================================
+*/
+
+#include "BQfilterBank.h"
+#include "DSPkernels.h"
+
+// Channels are processed in groups of DSPkernels::banklanes; numlanes is a multiple of the
+// largest group size, so it suits every instruction set level.
+// Samples per pass of procblock
+constexpr int BANKCHUNK = 256;
+
+BQfilterBank::BQfilterBank()
+{
+	numchans = 0;
+	numlanes = 0;
+}
+
+void BQfilterBank::setnumchannels(int numchannels)
+{
+	numchans = numchannels;
+	numlanes = (numchannels + MAXBANKLANES - 1) / MAXBANKLANES * MAXBANKLANES;
+	// unused lanes keep zero coefficients, so their output stays zero
+	for (auto* v : { &b0, &b1, &b2, &a1, &a2, &s1, &s2 })
+	{
+		v->resize(numlanes, 0.0);
+		for (int n = numchans; n < numlanes; n++)
+			(*v)[n] = 0.0;
+	}
+}
+
+void BQfilterBank::update(int channel, FilterType ftype, double Gain, double f0, double Q, double fs)
+{
+	BQfilter bq;
+	bq.update(ftype, Gain, f0, Q, fs);
+	setcoefs(channel, bq);
+}
+
+void BQfilterBank::updateall(FilterType ftype, double Gain, double f0, double Q, double fs)
+{
+	BQfilter bq;
+	bq.update(ftype, Gain, f0, Q, fs);
+	for (int ch = 0; ch < numchans; ch++)
+		setcoefs(ch, bq);
+}
+
+void BQfilterBank::setcoefs(int channel, const BQfilter& filt)
+{
+	double b[3], a[3];
+	filt.getcoefs(b, a);
+	b0[channel] = b[0];
+	b1[channel] = b[1];
+	b2[channel] = b[2];
+	a1[channel] = a[1];
+	a2[channel] = a[2];
+}
+
+void BQfilterBank::resetstate()
+{
+	for (int n = 0; n < numlanes; n++)
+	{
+		s1[n] = 0.0;
+		s2[n] = 0.0;
+	}
+}
+
+void BQfilterBank::step(double* frame)
+{
+	const int width = getkernels().banklanes;
+	for (int group = 0; group < numchans; group += width)
+	{
+		const int used = numchans - group < width ? numchans - group : width;
+		const DSPkernels& kernels = getbankkernels(used);
+		const double* coefs[5] = { &b0[group], &b1[group], &b2[group], &a1[group], &a2[group] };
+		if (used == kernels.banklanes)
+			kernels.biquadbank(frame + group, 1, coefs, &s1[group], &s2[group]);
+		else
+		{
+			// unused lanes are fed zeros
+			double last[MAXBANKLANES] = {};
+			for (int k = 0; k < used; k++)
+				last[k] = frame[group + k];
+			kernels.biquadbank(last, 1, coefs, &s1[group], &s2[group]);
+			for (int k = 0; k < used; k++)
+				frame[group + k] = last[k];
+		}
+	}
+}
+
+void BQfilterBank::procblock(const float* const* inchannels, float* const* outchannels, int numsamples)
+{
+	const int groupwidth = getkernels().banklanes;
+	alignas(64) double frames[BANKCHUNK * MAXBANKLANES];
+	for (int group = 0; group < numchans; group += groupwidth)
+	{
+		const int used = numchans - group < groupwidth ? numchans - group : groupwidth;
+		const DSPkernels& kernels = getbankkernels(used);
+		const int width = kernels.banklanes;
+		const double* coefs[5] = { &b0[group], &b1[group], &b2[group], &a1[group], &a2[group] };
+		for (int start = 0; start < numsamples; start += BANKCHUNK)
+		{
+			int len = numsamples - start < BANKCHUNK ? numsamples - start : BANKCHUNK;
+			// gather the group into interleaved frames; unused lanes are fed zeros
+			for (int k = 0; k < width; k++)
+			{
+				const float* in = k < used ? inchannels[group + k] + start : nullptr;
+				for (int n = 0; n < len; n++)
+					frames[n * width + k] = in ? in[n] : 0.0;
+			}
+			kernels.biquadbank(frames, len, coefs, &s1[group], &s2[group]);
+			for (int k = 0; k < used; k++)
+			{
+				float* out = outchannels[group + k] + start;
+				for (int n = 0; n < len; n++)
+					out[n] = float(frames[n * width + k]);
+			}
+		}
+	}
+}
@@ -0,0 +1,120 @@
+/*
+  ==============================================================================
+
+    CPUfeatures.cpp
+
+  ==============================================================================
+*/
+
+#include "CPUfeatures.h"
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CPUID_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#if defined(CPUID_X86)
+// registers returned by the cpuid instruction: eax, ebx, ecx, edx
+static void cpuid(unsigned int leaf, unsigned int subleaf, unsigned int* regs)
+{
+#if defined(_MSC_VER)
+	int r[4];
+	__cpuidex(r, int(leaf), int(subleaf));
+	for (int k = 0; k < 4; k++)
+		regs[k] = unsigned(r[k]);
+#else
+	__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// register state enabled by the operating system
+static unsigned long long xgetbv()
+{
+#if defined(_MSC_VER)
+	return _xgetbv(0);
+#else
+	unsigned int lo, hi;
+	__asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+	return (static_cast<unsigned long long>(hi) << 32) | lo;
+#endif
+}
+#endif
+
+ISAlevel detectisa()
+{
+#if defined(CPUID_X86)
+	unsigned int regs[4];
+	cpuid(0, 0, regs);
+	const unsigned int maxleaf = regs[0];
+	cpuid(1, 0, regs);
+	if (!(regs[3] & (1u << 26))) // SSE2
+		return ISAlevel::SCALAR;
+	const bool osxsave = (regs[2] & (1u << 27)) != 0;
+	const bool avx = (regs[2] & (1u << 28)) != 0;
+	if (!osxsave || !avx || maxleaf < 7)
+		return ISAlevel::SIMD128;
+	// the operating system must save the xmm and ymm registers (and opmask, zmm for AVX-512)
+	const unsigned long long xcr0 = xgetbv();
+	if ((xcr0 & 0x6) != 0x6)
+		return ISAlevel::SIMD128;
+	cpuid(7, 0, regs);
+	const bool avx2 = (regs[1] & (1u << 5)) != 0;
+	const bool avx512f = (regs[1] & (1u << 16)) != 0;
+	if (!avx2)
+		return ISAlevel::SIMD128;
+	if (avx512f && (xcr0 & 0xe6) == 0xe6)
+		return ISAlevel::AVX512;
+	return ISAlevel::AVX2;
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	return ISAlevel::SIMD128;
+#else
+	return ISAlevel::SCALAR;
+#endif
+}
+
+ISAlevel getisa()
+{
+	static const ISAlevel isa = []() {
+		ISAlevel level = detectisa();
+		const char* request = std::getenv("AUDIOCLASSES_ISA");
+		if (request)
+		{
+			ISAlevel wanted = level;
+			if (!std::strcmp(request, "scalar"))
+				wanted = ISAlevel::SCALAR;
+			else if (!std::strcmp(request, "sse2") || !std::strcmp(request, "neon"))
+				wanted = ISAlevel::SIMD128;
+			else if (!std::strcmp(request, "avx2"))
+				wanted = ISAlevel::AVX2;
+			else if (!std::strcmp(request, "avx512"))
+				wanted = ISAlevel::AVX512;
+			if (int(wanted) < int(level))
+				level = wanted;
+		}
+		return level;
+	}();
+	return isa;
+}
+
+const char* isaname(ISAlevel isa)
+{
+	switch (isa)
+	{
+	case ISAlevel::SCALAR: return "scalar";
+#if defined(__ARM_NEON) && defined(__aarch64__)
+	case ISAlevel::SIMD128: return "neon";
+#else
+	case ISAlevel::SIMD128: return "sse2";
+#endif
+	case ISAlevel::AVX2: return "avx2";
+	case ISAlevel::AVX512: return "avx512";
+	}
+	return "unknown";
+}
@@ -0,0 +1,37 @@
+/*
+  ==============================================================================
+
+    CPUfeatures.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+/// <summary>
+/// Instruction set levels for which the DSP kernels are compiled
+/// </summary>
+enum class ISAlevel { SCALAR, SIMD128, AVX2, AVX512 };
+
+/// <summary>
+/// Detect the highest instruction set level supported by the processor and operating system
+/// </summary>
+/// <returns>instruction set level</returns>
+ISAlevel detectisa();
+
+/// <summary>
+/// Get the instruction set level used by the DSP kernels
+/// 
+/// This is chosen once, on first use: the detected level, or the level named by the
+/// AUDIOCLASSES_ISA environment variable ("scalar", "sse2", "neon", "avx2" or "avx512") if
+/// that is lower. Requests for unsupported levels fall back to the detected level.
+/// </summary>
+/// <returns>instruction set level</returns>
+ISAlevel getisa();
+
+/// <summary>
+/// Get the name of an instruction set level
+/// </summary>
+/// <param name="isa">instruction set level</param>
+/// <returns>name (e.g. "avx2")</returns>
+const char* isaname(ISAlevel isa);
@@ -0,0 +1,165 @@
+/*
+  ==============================================================================
+
+    Convolver.cpp
+
+  ==============================================================================
+*/
+
+#include "Convolver.h"
+#include "DSPkernels.h"
+#include <algorithm>
+#include <cstring>
+
+// Ratio of partition sizes of successive parts of a non-uniform partitioning
+constexpr int PARTGROWTH = 4;
+
+Convolver::Convolver()
+{
+	blocksize = 0;
+	blockpos = 0;
+}
+
+void Convolver::init(const float* ir, int irlength, int blocksize, int maxpartition)
+{
+	this->blocksize = blocksize;
+	stages.clear();
+	if (maxpartition < blocksize)
+		maxpartition = blocksize;
+
+	// Cut the response into parts: [0, P1) in partitions of blocksize, then [P, 4P) in
+	// partitions of P, and the rest in partitions of maxpartition
+	int start = 0;
+	int partsize = blocksize;
+	while (start < irlength || stages.empty())
+	{
+		int nextsize = partsize * PARTGROWTH <= maxpartition ? partsize * PARTGROWTH : partsize;
+		int end = nextsize > partsize ? nextsize : irlength;
+		if (end > irlength)
+			end = irlength;
+		Stage stage;
+		stage.partsize = partsize;
+		stage.offset = start;
+		stage.numparts = end > start ? (end - start + partsize - 1) / partsize : 1;
+		stages.push_back(std::move(stage));
+		start = end;
+		partsize = nextsize;
+	}
+
+	for (auto& stage : stages)
+	{
+		const int P = stage.partsize;
+		const int bins = P + 1;
+		stage.fft.init(2 * P);
+		stage.irre.assign(std::size_t(stage.numparts) * bins, 0.0f);
+		stage.irim.assign(std::size_t(stage.numparts) * bins, 0.0f);
+		std::vector<float> padded(2 * P);
+		for (int k = 0; k < stage.numparts; k++)
+		{
+			std::fill(padded.begin(), padded.end(), 0.0f);
+			for (int n = 0; n < P; n++)
+			{
+				int index = stage.offset + k * P + n;
+				if (index < irlength)
+					padded[n] = ir[index];
+			}
+			stage.fft.forward(padded.data(), &stage.irre[std::size_t(k) * bins], &stage.irim[std::size_t(k) * bins]);
+		}
+		stage.fdlre.resize(std::size_t(stage.numparts) * bins);
+		stage.fdlim.resize(std::size_t(stage.numparts) * bins);
+		stage.input.resize(2 * P);
+		stage.accre.resize(bins);
+		stage.accim.resize(bins);
+		stage.time.resize(2 * P);
+		stage.pending.resize(P);
+	}
+	inblock.resize(blocksize);
+	outblock.resize(blocksize);
+	reset();
+}
+
+void Convolver::reset()
+{
+	for (auto& stage : stages)
+	{
+		std::fill(stage.fdlre.begin(), stage.fdlre.end(), 0.0f);
+		std::fill(stage.fdlim.begin(), stage.fdlim.end(), 0.0f);
+		std::fill(stage.input.begin(), stage.input.end(), 0.0f);
+		std::fill(stage.pending.begin(), stage.pending.end(), 0.0f);
+		stage.fdlpos = 0;
+		stage.fill = 0;
+		stage.readpos = 0;
+	}
+	std::fill(inblock.begin(), inblock.end(), 0.0f);
+	std::fill(outblock.begin(), outblock.end(), 0.0f);
+	blockpos = 0;
+}
+
+void Convolver::procblock(const float* insamples, float* outsamples, int numsamples)
+{
+	while (numsamples > 0)
+	{
+		// the output of the previous block goes out as the current block comes in
+		int len = blocksize - blockpos < numsamples ? blocksize - blockpos : numsamples;
+		std::memcpy(&inblock[blockpos], insamples, len * sizeof(float));
+		std::memcpy(outsamples, &outblock[blockpos], len * sizeof(float));
+		insamples += len;
+		outsamples += len;
+		numsamples -= len;
+		blockpos += len;
+		if (blockpos == blocksize)
+		{
+			processblock();
+			blockpos = 0;
+		}
+	}
+}
+
+void Convolver::processblock()
+{
+	std::fill(outblock.begin(), outblock.end(), 0.0f);
+	for (auto& stage : stages)
+	{
+		const int P = stage.partsize;
+		std::memcpy(&stage.input[P + stage.fill], inblock.data(), blocksize * sizeof(float));
+		stage.fill += blocksize;
+		// the first part contributes to this block; later parts were computed in advance
+		if (stage.offset == 0)
+			runstage(stage);
+		for (int n = 0; n < blocksize; n++)
+			outblock[n] += stage.pending[stage.readpos + n];
+		stage.readpos += blocksize;
+		if (stage.offset > 0 && stage.fill == P)
+			runstage(stage);
+	}
+}
+
+void Convolver::runstage(Stage& stage)
+{
+	const int P = stage.partsize;
+	const int bins = P + 1;
+	const DSPkernels& kernels = getkernels();
+
+	// Newest input spectrum goes into the delay line, overwriting the oldest
+	float* xre = &stage.fdlre[std::size_t(stage.fdlpos) * bins];
+	float* xim = &stage.fdlim[std::size_t(stage.fdlpos) * bins];
+	stage.fft.forward(stage.input.data(), xre, xim);
+	std::fill(stage.accre.begin(), stage.accre.end(), 0.0f);
+	std::fill(stage.accim.begin(), stage.accim.end(), 0.0f);
+	int slot = stage.fdlpos;
+	for (int k = 0; k < stage.numparts; k++)
+	{
+		kernels.complexmac(&stage.fdlre[std::size_t(slot) * bins], &stage.fdlim[std::size_t(slot) * bins],
+			&stage.irre[std::size_t(k) * bins], &stage.irim[std::size_t(k) * bins], stage.accre.data(),
+			stage.accim.data(), bins);
+		slot = slot > 0 ? slot - 1 : stage.numparts - 1;
+	}
+	stage.fdlpos = stage.fdlpos + 1 < stage.numparts ? stage.fdlpos + 1 : 0;
+
+	// Overlap-save: the second half of the circular convolution is the output
+	stage.fft.inverse(stage.accre.data(), stage.accim.data(), stage.time.data());
+	std::memcpy(stage.pending.data(), &stage.time[P], P * sizeof(float));
+	stage.readpos = 0;
+	std::memcpy(stage.input.data(), &stage.input[P], P * sizeof(float));
+	stage.fill = 0;
+}
@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    Convolver.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <vector>
+#include "FFT.h"
+
+/// <summary>
+/// Partitioned FFT convolution with an impulse response
+///
+/// The impulse response is cut into partitions, each transformed once when it is set. Input
+/// blocks are transformed as they arrive and kept in a frequency-domain delay line, so each
+/// block costs one forward and one inverse FFT plus one spectral multiply-accumulate per
+/// partition (uniformly partitioned overlap-save). The latency is one block.
+///
+/// With a maximum partition larger than the block, the response is split non-uniformly: the
+/// first part uses partitions of one block, and later parts use partitions four times larger
+/// each time, up to the maximum. A part with partitions of P samples starts P samples into
+/// the response, so its output is computed once every P samples and is ready before it is
+/// needed. Long responses then cost far fewer multiply-accumulates per sample. The larger
+/// partitions are computed on the block where they become due, so the work per block is
+/// uneven.
+/// </summary>
+class Convolver
+{
+public:
+	Convolver();
+	~Convolver() {}
+
+	/// <summary>
+	/// Set impulse response and partitioning
+	///
+	/// The state is cleared.
+	/// </summary>
+	/// <param name="ir">impulse response</param>
+	/// <param name="irlength">length of the impulse response</param>
+	/// <param name="blocksize">block size and smallest partition (a power of two)</param>
+	/// <param name="maxpartition">largest partition (a power of two; blocksize or less for uniform partitions)</param>
+	void init(const float* ir, int irlength, int blocksize, int maxpartition = 0);
+
+	/// <summary>
+	/// Clear the delay lines
+	/// </summary>
+	void reset();
+
+	/// <summary>
+	/// Get latency
+	/// </summary>
+	/// <returns>delay of the output (samples)</returns>
+	int getlatency() const { return blocksize; }
+
+	/// <summary>
+	/// Process a block of samples
+	///
+	/// Any number of samples may be passed; the output is delayed by getlatency() samples.
+	/// </summary>
+	/// <param name="insamples">pointer to first input sample</param>
+	/// <param name="outsamples">pointer to first output sample (may be the same as insamples)</param>
+	/// <param name="numsamples">number of samples in the block</param>
+	void procblock(const float* insamples, float* outsamples, int numsamples);
+
+	/// <summary>
+	/// Process a block of samples in place
+	///
+	/// Note: this method modifies the input samples - they become the output samples.
+	/// </summary>
+	/// <param name="samples">pointer to first audio sample</param>
+	/// <param name="numsamples">number of samples in the block</param>
+	void procblock(float* samples, int numsamples) { procblock(samples, samples, numsamples); }
+
+private:
+	// Uniformly partitioned part of the response
+	struct Stage
+	{
+		int partsize;
+		int numparts;
+		int offset; // 0 or partsize
+		FFT fft;
+		std::vector<float> irre, irim; // numparts spectra of partsize+1 bins
+		std::vector<float> fdlre, fdlim; // the last numparts input spectra
+		int fdlpos;
+		std::vector<float> input; // previous and current input block
+		int fill;
+		std::vector<float> accre, accim;
+		std::vector<float> time;
+		std::vector<float> pending; // output not yet used
+		int readpos;
+	};
+
+	void processblock();
+	void runstage(Stage& stage);
+
+	int blocksize;
+	std::vector<Stage> stages;
+	std::vector<float> inblock, outblock;
+	int blockpos;
+};
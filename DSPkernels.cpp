@@ -0,0 +1,641 @@
+/*
+  ==============================================================================
+
+    DSPkernels.cpp
+
+  ==============================================================================
+*/
+
+// Results must not depend on the instruction set, so multiply-add contraction is turned off
+// for every kernel (GCC would otherwise fuse them in the AVX-512 versions). Loops the kernels
+// leave to the compiler are vectorized at -O2 as well.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize ("fp-contract=off", "tree-vectorize")
+#elif defined(__clang__)
+#pragma clang fp contract(off)
+#endif
+
+#include "DSPkernels.h"
+#include "SIMDlanes.h"
+#include <cmath>
+#include <cstddef>
+
+// Kernels are written once as templates over the lane type (double for the scalar version)
+// and instantiated inside functions compiled for each instruction set.
+
+template <typename V>
+LANES_INLINE void biquadbankT(double* frames, int numsamples, const double* const* coefs, double* s1, double* s2)
+{
+	// two vectors, so that two independent recursions are in flight at once
+	constexpr int L = lanecount<V>::value;
+	constexpr int G = 2 * L;
+	V b0A = laneload<V>(coefs[0]), b0B = laneload<V>(coefs[0] + L);
+	V b1A = laneload<V>(coefs[1]), b1B = laneload<V>(coefs[1] + L);
+	V b2A = laneload<V>(coefs[2]), b2B = laneload<V>(coefs[2] + L);
+	V a1A = laneload<V>(coefs[3]), a1B = laneload<V>(coefs[3] + L);
+	V a2A = laneload<V>(coefs[4]), a2B = laneload<V>(coefs[4] + L);
+	V z1A = laneload<V>(s1), z1B = laneload<V>(s1 + L);
+	V z2A = laneload<V>(s2), z2B = laneload<V>(s2 + L);
+	for (int n = 0; n < numsamples; n++)
+	{
+		double* frame = frames + n * G;
+		V xA = laneload<V>(frame);
+		V xB = laneload<V>(frame + L);
+		V yA = b0A * xA + z1A;
+		V yB = b0B * xB + z1B;
+		z1A = z2A + b1A * xA - a1A * yA;
+		z1B = z2B + b1B * xB - a1B * yB;
+		z2A = b2A * xA - a2A * yA;
+		z2B = b2B * xB - a2B * yB;
+		lanestore(frame, yA);
+		lanestore(frame + L, yB);
+	}
+	lanestore(s1, z1A);
+	lanestore(s1 + L, z1B);
+	lanestore(s2, z2A);
+	lanestore(s2 + L, z2B);
+}
+
+template <typename V>
+LANES_INLINE void ssfilterbankT(double* frames, double* bpframes, double* lpframes, int numsamples,
+	const double* const* coefs, double* const* state)
+{
+	// two vectors, as in biquadbankT(); F1 steps before each sample as in SSfilterT::procramp()
+	constexpr int L = lanecount<V>::value;
+	constexpr int G = 2 * L;
+	V dA = laneload<V>(coefs[0]), dB = laneload<V>(coefs[0] + L);
+	V df1A = laneload<V>(coefs[1]), df1B = laneload<V>(coefs[1] + L);
+	V f1A = laneload<V>(state[0]), f1B = laneload<V>(state[0] + L);
+	V bpA = laneload<V>(state[1]), bpB = laneload<V>(state[1] + L);
+	V lpA = laneload<V>(state[2]), lpB = laneload<V>(state[2] + L);
+	for (int n = 0; n < numsamples; n++)
+	{
+		double* frame = frames + n * G;
+		f1A = f1A + df1A;
+		f1B = f1B + df1B;
+		V hpA = laneload<V>(frame) - (lpA + dA * bpA);
+		V hpB = laneload<V>(frame + L) - (lpB + dB * bpB);
+		bpA = bpA + f1A * hpA;
+		bpB = bpB + f1B * hpB;
+		lpA = lpA + f1A * bpA;
+		lpB = lpB + f1B * bpB;
+		lanestore(frame, hpA);
+		lanestore(frame + L, hpB);
+		lanestore(bpframes + n * G, bpA);
+		lanestore(bpframes + n * G + L, bpB);
+		lanestore(lpframes + n * G, lpA);
+		lanestore(lpframes + n * G + L, lpB);
+	}
+	lanestore(state[0], f1A);
+	lanestore(state[0] + L, f1B);
+	lanestore(state[1], bpA);
+	lanestore(state[1] + L, bpB);
+	lanestore(state[2], lpA);
+	lanestore(state[2] + L, lpB);
+}
+
+template <int K>
+LANES_INLINE void soscascadeT(double* samples, int numsamples, const double* coefs, double* state)
+{
+	// Running K sections per sample lets the recursions of successive sections overlap
+	double b0[K], b1[K], b2[K], a1[K], a2[K], z1[K], z2[K];
+	for (int k = 0; k < K; k++)
+	{
+		b0[k] = coefs[k];
+		b1[k] = coefs[4 + k];
+		b2[k] = coefs[8 + k];
+		a1[k] = coefs[12 + k];
+		a2[k] = coefs[16 + k];
+		z1[k] = state[k];
+		z2[k] = state[4 + k];
+	}
+	for (int n = 0; n < numsamples; n++)
+	{
+		double x = samples[n];
+		for (int k = 0; k < K; k++)
+		{
+			double y = b0[k] * x + z1[k];
+			z1[k] = z2[k] + b1[k] * x - a1[k] * y;
+			z2[k] = b2[k] * x - a2[k] * y;
+			x = y;
+		}
+		samples[n] = x;
+	}
+	for (int k = 0; k < K; k++)
+	{
+		state[k] = z1[k];
+		state[4 + k] = z2[k];
+	}
+}
+
+LANES_INLINE void soscascadeN(double* samples, int numsamples, const double* coefs, double* state, int numsects)
+{
+	switch (numsects)
+	{
+	case 1: soscascadeT<1>(samples, numsamples, coefs, state); break;
+	case 2: soscascadeT<2>(samples, numsamples, coefs, state); break;
+	case 3: soscascadeT<3>(samples, numsamples, coefs, state); break;
+	default: soscascadeT<4>(samples, numsamples, coefs, state); break;
+	}
+}
+
+template <typename V>
+LANES_INLINE void sosparallelT(const double* in, double* out, double* frames, int numsamples, int numsects,
+	const double* const* coefs, double* s1, double* s2, double direct)
+{
+	// Slices of eight sections, as in combbankT(): the sections share the input, so their
+	// recursions are independent and run side by side in the lanes
+	constexpr int S = 8;
+	constexpr int L = lanecount<V>::value;
+	constexpr int K = S / L;
+	const V zero = lanebroadcast<V>(0.0);
+	for (int n = 0; n < numsamples; n++)
+		out[n] = direct * in[n];
+	for (int slice = 0; slice < numsects; slice += S)
+	{
+		V b0[K], b1[K], a1[K], a2[K], z1[K], z2[K];
+		for (int k = 0; k < K; k++)
+		{
+			b0[k] = laneload<V>(coefs[0] + slice + k * L);
+			b1[k] = laneload<V>(coefs[1] + slice + k * L);
+			a1[k] = laneload<V>(coefs[2] + slice + k * L);
+			a2[k] = laneload<V>(coefs[3] + slice + k * L);
+			z1[k] = laneload<V>(s1 + slice + k * L);
+			z2[k] = laneload<V>(s2 + slice + k * L);
+		}
+		for (int n = 0; n < numsamples; n++)
+		{
+			const V u = lanebroadcast<V>(in[n]);
+			double* frame = frames + std::size_t(n) * S;
+			for (int k = 0; k < K; k++)
+			{
+				const V y = b0[k] * u + z1[k];
+				z1[k] = z2[k] + b1[k] * u - a1[k] * y;
+				z2[k] = zero - a2[k] * y;
+				lanestore(frame + k * L, y);
+			}
+		}
+		for (int k = 0; k < K; k++)
+		{
+			lanestore(s1 + slice + k * L, z1[k]);
+			lanestore(s2 + slice + k * L, z2[k]);
+		}
+		// section by section, so that the additions for successive samples are independent
+		const int count = numsects - slice < S ? numsects - slice : S;
+		for (int c = 0; c < count; c++)
+			for (int n = 0; n < numsamples; n++)
+				out[n] += frames[std::size_t(n) * S + c];
+	}
+}
+
+LANES_INLINE void combT(const float* delayed, const float* in, float* out, int numsamples, double damping,
+	double feedback, double* state)
+{
+	double st = *state;
+	for (int n = 0; n < numsamples; n++)
+	{
+		st = damping * st + feedback * delayed[n];
+		out[n] = float(st + in[n]);
+	}
+	*state = st;
+}
+
+// Combs in lanes, eight at a time. Each slice of eight runs through the whole block before
+// the next, adding its outputs to the running sums in comb order.
+template <typename V>
+LANES_INLINE void combbankT(const double* delayed, float* combout, int numsamples, int numcombs, int width,
+	const double* const* coefs, double* state, const double* in, double* out)
+{
+	constexpr int S = 8;
+	constexpr int L = lanecount<V>::value;
+	constexpr int K = S / L;
+	for (int n = 0; n < numsamples; n++)
+		out[n] = 0.0;
+	for (int slice = 0; slice < width; slice += S)
+	{
+		V damping[K], feedback[K], st[K];
+		for (int k = 0; k < K; k++)
+		{
+			damping[k] = laneload<V>(coefs[0] + slice + k * L);
+			feedback[k] = laneload<V>(coefs[1] + slice + k * L);
+			st[k] = laneload<V>(state + slice + k * L);
+		}
+		const int count = numcombs - slice < S ? numcombs - slice : S;
+		for (int n = 0; n < numsamples; n++)
+		{
+			const double* x = delayed + std::size_t(n) * width + slice;
+			const V u = lanebroadcast<V>(in[n]);
+			double y[S];
+			for (int k = 0; k < K; k++)
+			{
+				st[k] = damping[k] * st[k] + feedback[k] * laneload<V>(x + k * L);
+				lanestore(y + k * L, st[k] + u);
+			}
+			float* frame = combout + std::size_t(n) * width + slice;
+			for (int c = 0; c < S; c++)
+				frame[c] = float(y[c]);
+		}
+		for (int k = 0; k < K; k++)
+			lanestore(state + slice + k * L, st[k]);
+		// comb by comb, so that the additions for successive samples are independent
+		for (int c = slice; c < slice + count; c++)
+			for (int n = 0; n < numsamples; n++)
+				out[n] += combout[std::size_t(n) * width + c];
+	}
+}
+
+LANES_INLINE void allpassT(const float* xdelayed, const float* ydelayed, const float* in, float* out,
+	int numsamples, double damping, double reflection, float* xprev, float* yprev)
+{
+	// same expression as LPAPfilter::step()
+	float xp = *xprev;
+	float yp = *yprev;
+	for (int n = 0; n < numsamples; n++)
+	{
+		double sample = in[n];
+		float outsample = damping * yp + reflection * (1.0 - damping) * ydelayed[n] - reflection * sample
+			+ reflection * damping * xp + (1 - damping) * xdelayed[n];
+		yp = outsample;
+		xp = float(sample);
+		out[n] = outsample;
+	}
+	*xprev = xp;
+	*yprev = yp;
+}
+
+// Feedback delay network with N lines. The lowpass recursions run along each row, and
+// everything else works on whole columns, so it is vectorized across samples.
+template <typename T, int N>
+LANES_INLINE void fdnmixT(double* lines, int stride, const double* const* coefs, const double* in, double* out,
+	bool householder, int n)
+{
+	T x[N];
+	for (int i = 0; i < N; i++)
+		x[i] = laneload<T>(lines + i * stride + n);
+	T y = lanebroadcast<T>(coefs[3][0]) * x[0];
+	for (int i = 1; i < N; i++)
+		y = y + lanebroadcast<T>(coefs[3][i]) * x[i];
+	lanestore(out + n, y);
+	if (householder)
+	{
+		// I - 2/N (1 1^T)
+		T sum = x[0];
+		for (int i = 1; i < N; i++)
+			sum = sum + x[i];
+		T mean = lanebroadcast<T>(2.0 / N) * sum;
+		for (int i = 0; i < N; i++)
+			x[i] = x[i] - mean;
+	}
+	else
+	{
+		// fast Walsh-Hadamard transform, scaled by 1/sqrt(N) to be orthogonal
+		for (int h = 1; h < N; h *= 2)
+		{
+			for (int start = 0; start < N; start += 2 * h)
+			{
+				for (int j = start; j < start + h; j++)
+				{
+					T a = x[j];
+					T b = x[j + h];
+					x[j] = a + b;
+					x[j + h] = a - b;
+				}
+			}
+		}
+		T scale = lanebroadcast<T>(1.0 / std::sqrt(double(N)));
+		for (int i = 0; i < N; i++)
+			x[i] = scale * x[i];
+	}
+	T u = laneload<T>(in + n);
+	for (int i = 0; i < N; i++)
+		lanestore(lines + i * stride + n, x[i] + lanebroadcast<T>(coefs[2][i]) * u);
+}
+
+template <typename V, int N>
+LANES_INLINE void fdnfeedbackT(double* lines, int stride, int numsamples, const double* const* coefs, double* state,
+	const double* in, double* out, bool householder)
+{
+	double damping[N], feedback[N], s[N];
+	for (int i = 0; i < N; i++)
+	{
+		damping[i] = coefs[0][i];
+		feedback[i] = coefs[1][i];
+		s[i] = state[i];
+	}
+	for (int n = 0; n < numsamples; n++)
+	{
+		for (int i = 0; i < N; i++)
+		{
+			s[i] = damping[i] * s[i] + feedback[i] * lines[i * stride + n];
+			lines[i * stride + n] = s[i];
+		}
+	}
+	for (int i = 0; i < N; i++)
+		state[i] = s[i];
+
+	constexpr int L = lanecount<V>::value;
+	int n = 0;
+	for (; n + L <= numsamples; n += L)
+		fdnmixT<V, N>(lines, stride, coefs, in, out, householder, n);
+	for (; n < numsamples; n++)
+		fdnmixT<double, N>(lines, stride, coefs, in, out, householder, n);
+}
+
+template <typename V>
+LANES_INLINE void fdnfeedbackN(double* lines, int stride, int numlines, int numsamples, const double* const* coefs,
+	double* state, const double* in, double* out, bool householder)
+{
+	switch (numlines)
+	{
+	case 2: fdnfeedbackT<V, 2>(lines, stride, numsamples, coefs, state, in, out, householder); break;
+	case 4: fdnfeedbackT<V, 4>(lines, stride, numsamples, coefs, state, in, out, householder); break;
+	case 8: fdnfeedbackT<V, 8>(lines, stride, numsamples, coefs, state, in, out, householder); break;
+	default: fdnfeedbackT<V, 16>(lines, stride, numsamples, coefs, state, in, out, householder); break;
+	}
+}
+
+// Scatter at every junction of a group with a fixed number of ports. The arithmetic is
+// that of Junction::step(), so the result is identical.
+template <unsigned int P>
+LANES_INLINE void scatterT(double* state, const unsigned int* in, unsigned int numjunct, unsigned int outbase)
+{
+	double* out = state + outbase;
+	for (unsigned int j = 0; j < numjunct; j++, in += P, out += P)
+	{
+		double x[P];
+		for (unsigned int port = 0; port < P; port++)
+			x[port] = state[in[port]];
+		double sum = 0.0;
+		for (unsigned int port = 0; port < P; port++)
+			sum += x[port];
+		double scatter = 2.0 * sum / double(P);
+		// scatter - x rounds exactly like -x + scatter
+		for (unsigned int port = 0; port < P; port++)
+			out[port] = scatter - x[port];
+	}
+}
+
+LANES_INLINE void scatterN(double* state, const unsigned int* in, unsigned int numjunct, unsigned int outbase,
+	unsigned int numports)
+{
+	switch (numports)
+	{
+	case 2: scatterT<2>(state, in, numjunct, outbase); return;
+	case 3: scatterT<3>(state, in, numjunct, outbase); return;
+	case 4: scatterT<4>(state, in, numjunct, outbase); return;
+	case 5: scatterT<5>(state, in, numjunct, outbase); return;
+	case 6: scatterT<6>(state, in, numjunct, outbase); return;
+	}
+	double* out = state + outbase;
+	for (unsigned int j = 0; j < numjunct; j++, in += numports, out += numports)
+	{
+		double sum = 0.0;
+		for (unsigned int port = 0; port < numports; port++)
+			sum += state[in[port]];
+		double scatter = 2.0 * sum / double(numports);
+		for (unsigned int port = 0; port < numports; port++)
+			out[port] = scatter - state[in[port]];
+	}
+}
+
+// Mesh kernels run along a row of junctions, a vector of them at a time
+template <typename V>
+LANES_INLINE void meshpressureT(const double* const* waves, int numwaves, double* pressure, int numjunct)
+{
+	constexpr int L = lanecount<V>::value;
+	const V two = lanebroadcast<V>(2.0);
+	const V count = lanebroadcast<V>(double(numwaves));
+	int j = 0;
+	for (; j + L <= numjunct; j += L)
+	{
+		V sum = laneload<V>(waves[0] + j);
+		for (int w = 1; w < numwaves; w++)
+			sum = sum + laneload<V>(waves[w] + j);
+		lanestore(pressure + j, two * sum / count);
+	}
+	for (; j < numjunct; j++)
+	{
+		double sum = waves[0][j];
+		for (int w = 1; w < numwaves; w++)
+			sum += waves[w][j];
+		pressure[j] = 2.0 * sum / double(numwaves);
+	}
+}
+
+template <typename V>
+LANES_INLINE void meshwaveT(double* next, const double* prev, const double* pressure, const double* opposite,
+	const double* damping, int numjunct)
+{
+	constexpr int L = lanecount<V>::value;
+	const V one = lanebroadcast<V>(1.0);
+	int j = 0;
+	for (; j + L <= numjunct; j += L)
+	{
+		V d = laneload<V>(damping + j);
+		V out = laneload<V>(pressure + j) - laneload<V>(opposite + j);
+		lanestore(next + j, d * laneload<V>(prev + j) + (one - d) * out);
+	}
+	for (; j < numjunct; j++)
+		next[j] = damping[j] * prev[j] + (1.0 - damping[j]) * (pressure[j] - opposite[j]);
+}
+
+LANES_INLINE void complexmacT(const float* __restrict are, const float* __restrict aim,
+	const float* __restrict bre, const float* __restrict bim, float* __restrict accre, float* __restrict accim,
+	int numbins)
+{
+	for (int k = 0; k < numbins; k++)
+	{
+		accre[k] += are[k] * bre[k] - aim[k] * bim[k];
+		accim[k] += are[k] * bim[k] + aim[k] * bre[k];
+	}
+}
+
+// Taps in the outer loop, so the inner loop runs across samples and vectorizes; each output
+// is still summed in tap order
+LANES_INLINE void firT(const double* __restrict x, const double* __restrict coefs, int numtaps,
+	double* __restrict out, int numsamples)
+{
+	for (int n = 0; n < numsamples; n++)
+		out[n] = 0.0;
+	for (int k = 0; k < numtaps; k++)
+	{
+		const double c = coefs[k];
+		const double* xk = x - k;
+		for (int n = 0; n < numsamples; n++)
+			out[n] += c * xk[n];
+	}
+}
+
+// Taps across the lanes, POLYPHASETAPS to a pass; every level keeps the same partial sums,
+// POLYPHASETAPS / L vectors of L, and adds them up in the same order
+template <typename V>
+LANES_INLINE void polyphaseT(const double* x, const int* offsets, const double* const* rows, int numtaps,
+	double* out, int numsamples)
+{
+	static_assert(POLYPHASETAPS == 8, "the partial sums are added up for POLYPHASETAPS = 8");
+	constexpr int L = lanecount<V>::value;
+	constexpr int A = POLYPHASETAPS / L;
+	for (int n = 0; n < numsamples; n++)
+	{
+		const double* xn = x + offsets[n];
+		const double* c = rows[n];
+		V acc[A];
+		for (int a = 0; a < A; a++)
+			acc[a] = laneload<V>(c + a * L) * laneload<V>(xn + a * L);
+		for (int k = POLYPHASETAPS; k < numtaps; k += POLYPHASETAPS)
+			for (int a = 0; a < A; a++)
+				acc[a] = acc[a] + laneload<V>(c + k + a * L) * laneload<V>(xn + k + a * L);
+		double sums[POLYPHASETAPS];
+		for (int a = 0; a < A; a++)
+			lanestore(sums + a * L, acc[a]);
+		out[n] = ((sums[0] + sums[1]) + (sums[2] + sums[3])) + ((sums[4] + sums[5]) + (sums[6] + sums[7]));
+	}
+}
+
+// Sample format conversions, written as plain loops for the compiler to vectorize
+LANES_INLINE void floattodoubleT(const float* __restrict src, double* __restrict dest, int numsamples)
+{
+	for (int n = 0; n < numsamples; n++)
+		dest[n] = src[n];
+}
+
+LANES_INLINE void doubletofloatT(const double* __restrict src, float* __restrict dest, int numsamples)
+{
+	for (int n = 0; n < numsamples; n++)
+		dest[n] = float(src[n]);
+}
+
+LANES_INLINE void int16tofloatT(const short* __restrict src, float* __restrict dest, int numsamples)
+{
+	for (int n = 0; n < numsamples; n++)
+		dest[n] = float(src[n]) * (1.0f / 32768.0f);
+}
+
+LANES_INLINE void floattoint16T(const float* __restrict src, short* __restrict dest, int numsamples)
+{
+	for (int n = 0; n < numsamples; n++)
+	{
+		float x = src[n] * 32768.0f;
+		x = x < -32768.0f ? -32768.0f : x;
+		x = x > 32767.0f ? 32767.0f : x;
+		dest[n] = short(x < 0.0f ? x - 0.5f : x + 0.5f);
+	}
+}
+
+LANES_INLINE void int32tofloatT(const int* __restrict src, float* __restrict dest, int numsamples)
+{
+	for (int n = 0; n < numsamples; n++)
+		dest[n] = float(double(src[n]) * (1.0 / 2147483648.0));
+}
+
+LANES_INLINE void floattoint32T(const float* __restrict src, int* __restrict dest, int numsamples)
+{
+	for (int n = 0; n < numsamples; n++)
+	{
+		double x = double(src[n]) * 2147483648.0;
+		x = x < -2147483648.0 ? -2147483648.0 : x;
+		x = x > 2147483647.0 ? 2147483647.0 : x;
+		dest[n] = int(x < 0.0 ? x - 0.5 : x + 0.5);
+	}
+}
+
+// Kernel table for one instruction set level: every kernel is instantiated inside a function
+// compiled for that level, so the whole loop is generated for its instruction set.
+#define DEFINE_KERNELS(NAME, LEVEL, V, TARGET) \
+	TARGET static void NAME##_biquadbank(double* frames, int numsamples, const double* const* coefs, double* s1, \
+		double* s2) { biquadbankT<V>(frames, numsamples, coefs, s1, s2); } \
+	TARGET static void NAME##_ssfilterbank(double* frames, double* bpframes, double* lpframes, int numsamples, \
+		const double* const* coefs, double* const* state) \
+		{ ssfilterbankT<V>(frames, bpframes, lpframes, numsamples, coefs, state); } \
+	TARGET static void NAME##_soscascade(double* samples, int numsamples, const double* coefs, double* state, \
+		int numsects) { soscascadeN(samples, numsamples, coefs, state, numsects); } \
+	TARGET static void NAME##_sosparallel(const double* in, double* out, double* frames, int numsamples, \
+		int numsects, const double* const* coefs, double* s1, double* s2, double direct) \
+		{ sosparallelT<V>(in, out, frames, numsamples, numsects, coefs, s1, s2, direct); } \
+	TARGET static void NAME##_combfilter(const float* delayed, const float* in, float* out, int numsamples, \
+		double damping, double feedback, double* state) \
+		{ combT(delayed, in, out, numsamples, damping, feedback, state); } \
+	TARGET static void NAME##_combbank(const double* delayed, float* combout, int numsamples, int numcombs, \
+		int width, const double* const* coefs, double* state, const double* in, double* out) \
+		{ combbankT<V>(delayed, combout, numsamples, numcombs, width, coefs, state, in, out); } \
+	TARGET static void NAME##_allpassfilter(const float* xdelayed, const float* ydelayed, const float* in, \
+		float* out, int numsamples, double damping, double reflection, float* xprev, float* yprev) \
+		{ allpassT(xdelayed, ydelayed, in, out, numsamples, damping, reflection, xprev, yprev); } \
+	TARGET static void NAME##_fdnfeedback(double* lines, int stride, int numlines, int numsamples, \
+		const double* const* coefs, double* state, const double* in, double* out, bool householder) \
+		{ fdnfeedbackN<V>(lines, stride, numlines, numsamples, coefs, state, in, out, householder); } \
+	TARGET static void NAME##_scatter(double* state, const unsigned int* in, unsigned int numjunct, \
+		unsigned int outbase, unsigned int numports) { scatterN(state, in, numjunct, outbase, numports); } \
+	TARGET static void NAME##_meshpressure(const double* const* waves, int numwaves, double* pressure, \
+		int numjunct) { meshpressureT<V>(waves, numwaves, pressure, numjunct); } \
+	TARGET static void NAME##_meshwave(double* next, const double* prev, const double* pressure, \
+		const double* opposite, const double* damping, int numjunct) \
+		{ meshwaveT<V>(next, prev, pressure, opposite, damping, numjunct); } \
+	TARGET static void NAME##_complexmac(const float* are, const float* aim, const float* bre, const float* bim, \
+		float* accre, float* accim, int numbins) { complexmacT(are, aim, bre, bim, accre, accim, numbins); } \
+	TARGET static void NAME##_fir(const double* x, const double* coefs, int numtaps, double* out, \
+		int numsamples) { firT(x, coefs, numtaps, out, numsamples); } \
+	TARGET static void NAME##_polyphase(const double* x, const int* offsets, const double* const* rows, \
+		int numtaps, double* out, int numsamples) { polyphaseT<V>(x, offsets, rows, numtaps, out, numsamples); } \
+	TARGET static void NAME##_floattodouble(const float* src, double* dest, int numsamples) \
+		{ floattodoubleT(src, dest, numsamples); } \
+	TARGET static void NAME##_doubletofloat(const double* src, float* dest, int numsamples) \
+		{ doubletofloatT(src, dest, numsamples); } \
+	TARGET static void NAME##_int16tofloat(const short* src, float* dest, int numsamples) \
+		{ int16tofloatT(src, dest, numsamples); } \
+	TARGET static void NAME##_floattoint16(const float* src, short* dest, int numsamples) \
+		{ floattoint16T(src, dest, numsamples); } \
+	TARGET static void NAME##_int32tofloat(const int* src, float* dest, int numsamples) \
+		{ int32tofloatT(src, dest, numsamples); } \
+	TARGET static void NAME##_floattoint32(const float* src, int* dest, int numsamples) \
+		{ floattoint32T(src, dest, numsamples); } \
+	static const DSPkernels NAME##_kernels = { LEVEL, 2 * lanecount<V>::value, NAME##_biquadbank, \
+		NAME##_ssfilterbank, NAME##_soscascade, NAME##_sosparallel, NAME##_combfilter, NAME##_combbank, \
+		NAME##_allpassfilter, NAME##_fdnfeedback, NAME##_scatter, NAME##_meshpressure, NAME##_meshwave, \
+		NAME##_complexmac, NAME##_fir, NAME##_polyphase, NAME##_floattodouble, NAME##_doubletofloat, \
+		NAME##_int16tofloat, NAME##_floattoint16, NAME##_int32tofloat, NAME##_floattoint32 };
+
+DEFINE_KERNELS(scalar, ISAlevel::SCALAR, double, )
+#if defined(LANES_X86)
+DEFINE_KERNELS(sse2, ISAlevel::SIMD128, lanevec128, LANES_TARGET("sse2"))
+DEFINE_KERNELS(avx2, ISAlevel::AVX2, lanevec256, LANES_TARGET("avx2"))
+DEFINE_KERNELS(avx512, ISAlevel::AVX512, lanevec512, LANES_TARGET("avx512f"))
+#elif defined(LANES_NEON)
+DEFINE_KERNELS(neon, ISAlevel::SIMD128, lanevec128, )
+#endif
+
+const DSPkernels& getkernels(ISAlevel isa)
+{
+#if defined(LANES_X86)
+	switch (isa)
+	{
+	case ISAlevel::AVX512: return avx512_kernels;
+	case ISAlevel::AVX2: return avx2_kernels;
+	case ISAlevel::SIMD128: return sse2_kernels;
+	default: return scalar_kernels;
+	}
+#elif defined(LANES_NEON)
+	return isa == ISAlevel::SCALAR ? scalar_kernels : neon_kernels;
+#else
+	return scalar_kernels;
+#endif
+}
+
+const DSPkernels& getkernels()
+{
+	static const DSPkernels& kernels = getkernels(getisa());
+	return kernels;
+}
+
+const DSPkernels& getbankkernels(int numchannels)
+{
+	const DSPkernels* kernels = &getkernels();
+	for (int level = int(kernels->isa) - 1; level >= 0; level--)
+	{
+		const DSPkernels& lower = getkernels(ISAlevel(level));
+		if (lower.banklanes < numchannels)
+			break;
+		kernels = &lower;
+	}
+	return *kernels;
+}
@@ -0,0 +1,259 @@
+/*
+  ==============================================================================
+
+    DSPkernels.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "CPUfeatures.h"
+
+// Largest DSPkernels::banklanes of any instruction set level
+constexpr int MAXBANKLANES = 16;
+// The number of taps of a DSPkernels::polyphase filter must be a multiple of this
+constexpr int POLYPHASETAPS = 8;
+
+/// <summary>
+/// Hot inner loops of the DSP classes, compiled for each instruction set level
+///
+/// One binary carries a version of every kernel for each level (see ISAlevel); the table for
+/// the level returned by getisa() is chosen once, on first use. All versions perform the same
+/// arithmetic in the same order, without fused multiply-add, so results are identical
+/// whichever version runs.
+/// </summary>
+struct DSPkernels
+{
+	ISAlevel isa;
+
+	/// <summary>
+	/// Number of channels in a biquadbank group (a power of two, at most MAXBANKLANES)
+	/// </summary>
+	int banklanes;
+
+	/// <summary>
+	/// Step a group of banklanes biquads through a block (transposed direct form II)
+	/// </summary>
+	/// <param name="frames">numsamples frames of banklanes samples, replaced by the output</param>
+	/// <param name="numsamples">number of frames</param>
+	/// <param name="coefs">b0, b1, b2, a1, a2 arrays of the group</param>
+	/// <param name="s1">first state variable of each channel (updated)</param>
+	/// <param name="s2">second state variable of each channel (updated)</param>
+	void (*biquadbank)(double* frames, int numsamples, const double* const* coefs, double* s1, double* s2);
+
+	/// <summary>
+	/// Step a group of banklanes state space filters (SSfilter) through a block, with F1 of
+	/// each channel changing by a fixed step before every sample
+	/// </summary>
+	/// <param name="frames">numsamples frames of banklanes samples, replaced by the high-pass output</param>
+	/// <param name="bpframes">band-pass output frames</param>
+	/// <param name="lpframes">low-pass output frames</param>
+	/// <param name="numsamples">number of frames</param>
+	/// <param name="coefs">damping and F1 step arrays of the group</param>
+	/// <param name="state">F1, band-pass and low-pass arrays of the group (updated)</param>
+	void (*ssfilterbank)(double* frames, double* bpframes, double* lpframes, int numsamples,
+		const double* const* coefs, double* const* state);
+
+	/// <summary>
+	/// Run up to four cascaded biquads through a block (transposed direct form II)
+	/// </summary>
+	/// <param name="samples">samples, replaced by the output</param>
+	/// <param name="numsamples">number of samples</param>
+	/// <param name="coefs">b0[4], b1[4], b2[4], a1[4] and a2[4]</param>
+	/// <param name="state">s1[4] and s2[4] (updated)</param>
+	/// <param name="numsects">number of sections (1 to 4)</param>
+	void (*soscascade)(double* samples, int numsamples, const double* coefs, double* state, int numsects);
+
+	/// <summary>
+	/// Run the sections of a parallel form filter (see parallelsos()) through a block:
+	/// out = direct * in + the section outputs, added in section order
+	///
+	/// Each section is y = b0 * in + s1, s1 = s2 + b1 * in - a1 * y, s2 = 0 - a2 * y.
+	/// </summary>
+	/// <param name="in">input samples</param>
+	/// <param name="out">output samples</param>
+	/// <param name="frames">numsamples frames of 8 section outputs (scratch)</param>
+	/// <param name="numsamples">number of samples</param>
+	/// <param name="numsects">number of sections</param>
+	/// <param name="coefs">b0, b1, a1 and a2 arrays, padded to a multiple of 8 sections</param>
+	/// <param name="s1">first state variable of each section (updated)</param>
+	/// <param name="s2">second state variable of each section (updated)</param>
+	/// <param name="direct">gain of the direct path</param>
+	void (*sosparallel)(const double* in, double* out, double* frames, int numsamples, int numsects,
+		const double* const* coefs, double* s1, double* s2, double direct);
+
+	/// <summary>
+	/// Lowpass comb recursion: state = damping * state + feedback * delayed, out = state + in
+	/// </summary>
+	void (*combfilter)(const float* delayed, const float* in, float* out, int numsamples, double damping,
+		double feedback, double* state);
+
+	/// <summary>
+	/// Bank of lowpass combs with a common input, one comb per lane:
+	/// state = damping * state + feedback * delayed, output of the comb = float(state + in)
+	///
+	/// The comb outputs are also added, in comb order, to give the output of the bank.
+	/// </summary>
+	/// <param name="delayed">numsamples frames of width delayed samples</param>
+	/// <param name="combout">numsamples frames of width comb outputs (output)</param>
+	/// <param name="numsamples">number of frames</param>
+	/// <param name="numcombs">number of combs summed</param>
+	/// <param name="width">number of lanes in a frame (a multiple of 8)</param>
+	/// <param name="coefs">damping and feedback arrays</param>
+	/// <param name="state">state of each comb (updated)</param>
+	/// <param name="in">input samples</param>
+	/// <param name="out">output samples</param>
+	void (*combbank)(const double* delayed, float* combout, int numsamples, int numcombs, int width,
+		const double* const* coefs, double* state, const double* in, double* out);
+
+	/// <summary>
+	/// Lowpass allpass recursion of LPAPfilter
+	/// </summary>
+	void (*allpassfilter)(const float* xdelayed, const float* ydelayed, const float* in, float* out,
+		int numsamples, double damping, double reflection, float* xprev, float* yprev);
+
+	/// <summary>
+	/// Feedback path of a feedback delay network for a block no longer than the shortest delay
+	///
+	/// Each delay line output is lowpass filtered (state = damping * state + feedback * delayed),
+	/// the output is the weighted sum of the filtered lines, and the filtered lines are mixed by
+	/// a normalized Hadamard or a Householder matrix before the weighted input is added.
+	/// </summary>
+	/// <param name="lines">numlines rows of stride samples: delay line outputs, replaced by the delay line inputs</param>
+	/// <param name="stride">distance between rows</param>
+	/// <param name="numlines">number of delay lines (2, 4, 8 or 16)</param>
+	/// <param name="numsamples">number of samples (at most stride)</param>
+	/// <param name="coefs">damping, feedback, input gain and output gain arrays</param>
+	/// <param name="state">lowpass state of each line (updated)</param>
+	/// <param name="in">input samples</param>
+	/// <param name="out">output samples</param>
+	/// <param name="householder">true for the Householder matrix, false for Hadamard</param>
+	void (*fdnfeedback)(double* lines, int stride, int numlines, int numsamples, const double* const* coefs,
+		double* state, const double* in, double* out, bool householder);
+
+	/// <summary>
+	/// Scatter at a group of junctions with the same number of ports
+	/// </summary>
+	/// <param name="state">state array of an MPnetwork plan</param>
+	/// <param name="in">numports input indices per junction</param>
+	/// <param name="numjunct">number of junctions</param>
+	/// <param name="outbase">state index of the first output (outputs are contiguous)</param>
+	/// <param name="numports">number of ports per junction</param>
+	void (*scatter)(double* state, const unsigned int* in, unsigned int numjunct, unsigned int outbase,
+		unsigned int numports);
+
+	/// <summary>
+	/// Junction pressures of a row of a rectilinear waveguide mesh: 2 * (sum of the waves
+	/// arriving at the junction) / numwaves, summed in wave order as in scatter
+	/// </summary>
+	/// <param name="waves">numwaves arrays of arriving waves</param>
+	/// <param name="numwaves">number of waves per junction</param>
+	/// <param name="pressure">pressure of each junction</param>
+	/// <param name="numjunct">number of junctions</param>
+	void (*meshpressure)(const double* const* waves, int numwaves, double* pressure, int numjunct);
+
+	/// <summary>
+	/// Waves arriving from one direction at a row of a rectilinear waveguide mesh, one sample
+	/// later: next = damping * prev + (1 - damping) * (pressure - opposite), where pressure and
+	/// opposite belong to the neighbouring junction the waves come from, as in Waveguide::step()
+	/// </summary>
+	/// <param name="next">new arriving waves</param>
+	/// <param name="prev">arriving waves of the last sample</param>
+	/// <param name="pressure">pressure of each neighbour</param>
+	/// <param name="opposite">wave arriving at each neighbour from the junction (the neighbour's output is pressure - opposite)</param>
+	/// <param name="damping">damping of each waveguide</param>
+	/// <param name="numjunct">number of junctions</param>
+	void (*meshwave)(double* next, const double* prev, const double* pressure, const double* opposite,
+		const double* damping, int numjunct);
+
+	/// <summary>
+	/// Complex multiply-accumulate of spectra held as separate real and imaginary arrays:
+	/// acc += a * b, bin by bin
+	/// </summary>
+	void (*complexmac)(const float* are, const float* aim, const float* bre, const float* bim, float* accre,
+		float* accim, int numbins);
+
+	/// <summary>
+	/// FIR filter: out[n] = sum over k of coefs[k] * x[n - k]
+	/// </summary>
+	/// <param name="x">first input sample; the numtaps - 1 samples before it are read as history</param>
+	/// <param name="coefs">filter coefficients</param>
+	/// <param name="numtaps">number of coefficients</param>
+	/// <param name="out">output samples</param>
+	/// <param name="numsamples">number of samples</param>
+	void (*fir)(const double* x, const double* coefs, int numtaps, double* out, int numsamples);
+
+	/// <summary>
+	/// Polyphase FIR filter, with its own coefficients and input position for every output:
+	/// out[n] = sum over k of rows[n][k] * x[offsets[n] + k]. Each output is summed as
+	/// POLYPHASETAPS partial sums, of every POLYPHASETAPS-th tap, added in a fixed order.
+	/// </summary>
+	/// <param name="x">input samples</param>
+	/// <param name="offsets">index in x of the first sample of each output</param>
+	/// <param name="rows">coefficients of each output, in input order</param>
+	/// <param name="numtaps">number of coefficients (a multiple of POLYPHASETAPS)</param>
+	/// <param name="out">output samples</param>
+	/// <param name="numsamples">number of output samples</param>
+	void (*polyphase)(const double* x, const int* offsets, const double* const* rows, int numtaps, double* out,
+		int numsamples);
+
+	// Sample format conversion. Integer samples are scaled to [-1, 1); conversions to integer
+	// round to nearest and saturate.
+	void (*floattodouble)(const float* src, double* dest, int numsamples);
+	void (*doubletofloat)(const double* src, float* dest, int numsamples);
+	void (*int16tofloat)(const short* src, float* dest, int numsamples);
+	void (*floattoint16)(const float* src, short* dest, int numsamples);
+	void (*int32tofloat)(const int* src, float* dest, int numsamples);
+	void (*floattoint32)(const float* src, int* dest, int numsamples);
+};
+
+/// <summary>
+/// Get the kernels for the instruction set level chosen at startup
+/// </summary>
+/// <returns>kernel table</returns>
+const DSPkernels& getkernels();
+
+/// <summary>
+/// Get the kernels for a given instruction set level
+///
+/// Intended for tests and benchmarks. Levels the processor does not support must not be run.
+/// </summary>
+/// <param name="isa">instruction set level</param>
+/// <returns>kernel table (the closest level compiled in)</returns>
+const DSPkernels& getkernels(ISAlevel isa);
+
+/// <summary>
+/// Get the kernels for a group of bank channels
+///
+/// This is the narrowest level, no higher than the one chosen at startup, whose banklanes
+/// still holds all the channels, so a small last group does not pay for unused lanes.
+/// </summary>
+/// <param name="numchannels">number of channels in the group</param>
+/// <returns>kernel table</returns>
+const DSPkernels& getbankkernels(int numchannels);
+
+/// <summary>
+/// Convert samples from one type to another
+///
+/// Conversions between float and double go through the conversion kernels.
+/// </summary>
+/// <param name="src">source samples</param>
+/// <param name="dest">destination</param>
+/// <param name="numsamples">number of samples</param>
+template <typename S, typename T>
+inline void convertsamples(const S* src, T* dest, int numsamples)
+{
+	for (int n = 0; n < numsamples; n++)
+		dest[n] = T(src[n]);
+}
+
+inline void convertsamples(const float* src, double* dest, int numsamples)
+{
+	getkernels().floattodouble(src, dest, numsamples);
+}
+
+inline void convertsamples(const double* src, float* dest, int numsamples)
+{
+	getkernels().doubletofloat(src, dest, numsamples);
+}
@@ -0,0 +1,87 @@
+/*
+  ==============================================================================
+
+    DelayArena.cpp
+
+  ==============================================================================
+*/
+
+#include "DelayArena.h"
+#include <cstring>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Arenas at least this large are rounded up to whole huge pages
+constexpr std::size_t HUGEPAGE = 2 * 1024 * 1024;
+
+DelayArena::DelayArena()
+{
+	memory = nullptr;
+	size = 0;
+	mapped = 0;
+	used = 0;
+}
+
+DelayArena::~DelayArena()
+{
+	release();
+}
+
+bool DelayArena::init(std::size_t bytes)
+{
+	release();
+	if (bytes == 0)
+		return true;
+	mapped = bytes >= HUGEPAGE ? (bytes + HUGEPAGE - 1) / HUGEPAGE * HUGEPAGE : bytes;
+#if defined(_WIN32)
+	void* block = VirtualAlloc(nullptr, mapped, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+	if (!block)
+		return false;
+#else
+	void* block = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (block == MAP_FAILED)
+		return false;
+#if defined(MADV_HUGEPAGE)
+	if (mapped >= HUGEPAGE)
+		madvise(block, mapped, MADV_HUGEPAGE);
+#endif
+#endif
+	memory = static_cast<char*>(block);
+	size = mapped;
+	// fault every page in now rather than on the audio thread
+	std::memset(memory, 0, size);
+	return true;
+}
+
+void* DelayArena::allocate(std::size_t bytes)
+{
+	bytes = (bytes + ARENAALIGN - 1) / ARENAALIGN * ARENAALIGN;
+	if (!memory || bytes > size - used)
+		return nullptr;
+	void* region = memory + used;
+	used += bytes;
+	return region;
+}
+
+void DelayArena::release()
+{
+	if (memory)
+	{
+#if defined(_WIN32)
+		VirtualFree(memory, 0, MEM_RELEASE);
+#else
+		munmap(memory, mapped);
+#endif
+	}
+	memory = nullptr;
+	size = 0;
+	mapped = 0;
+	used = 0;
+}
@@ -0,0 +1,94 @@
+/*
+  ==============================================================================
+
+    DelayArena.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstddef>
+
+// Alignment of every region handed out by a DelayArena
+constexpr std::size_t ARENAALIGN = 64;
+
+/// <summary>
+/// One contiguous block of memory for all the delay lines of a processing graph
+///
+/// The arena is sized once, before processing starts, for the maximum delays the graph will
+/// need. Delay classes then take their buffers from it (see DelayLineT::setmaxdelay() and
+/// RingBuffer::reserve()), and later delay changes up to those maxima move only the read tap,
+/// so they never allocate. Regions are handed out one after another and are only released
+/// together, with the arena.
+///
+/// The memory is mapped directly from the operating system, in whole huge pages when it is
+/// large enough (and on Linux the kernel is asked to back it with them), and every page is
+/// touched when the arena is created, so the audio thread never takes a page fault on first use
+/// of a delay line. The arena must outlive the objects that use it.
+/// </summary>
+class DelayArena
+{
+public:
+	DelayArena();
+	~DelayArena();
+	DelayArena(const DelayArena&) = delete;
+	DelayArena& operator=(const DelayArena&) = delete;
+
+	/// <summary>
+	/// Allocate the arena
+	///
+	/// Any previous arena is released, so objects using it must be given new storage first.
+	/// </summary>
+	/// <param name="bytes">size of the arena (bytes)</param>
+	/// <returns>false if the memory could not be allocated</returns>
+	bool init(std::size_t bytes);
+
+	/// <summary>
+	/// Get the size of the region a ring buffer takes for a maximum delay
+	///
+	/// Add these up over the delay lines of a graph to find the size for init().
+	/// </summary>
+	/// <param name="maxdelay">maximum delay (samples)</param>
+	/// <returns>size of region (bytes)</returns>
+	template <typename T>
+	static std::size_t bytesfor(unsigned int maxdelay)
+	{
+		std::size_t capacity = 1;
+		while (capacity < maxdelay)
+			capacity <<= 1;
+		return (capacity * sizeof(T) + ARENAALIGN - 1) / ARENAALIGN * ARENAALIGN;
+	}
+
+	/// <summary>
+	/// Take a region from the arena
+	///
+	/// This does not allocate or lock, so it may be called on the audio thread.
+	/// </summary>
+	/// <param name="bytes">size of region (bytes)</param>
+	/// <returns>pointer to the region (zeroed, aligned to ARENAALIGN), or nullptr if the arena is full</returns>
+	void* allocate(std::size_t bytes);
+
+	/// <summary>
+	/// Get the size of the arena
+	/// </summary>
+	/// <returns>size (bytes)</returns>
+	std::size_t getsize() const { return size; }
+
+	/// <summary>
+	/// Get the amount of the arena handed out
+	/// </summary>
+	/// <returns>bytes used</returns>
+	std::size_t getused() const { return used; }
+
+	/// <summary>
+	/// Release the arena
+	/// </summary>
+	void release();
+
+private:
+	char* memory;
+	std::size_t size;
+	std::size_t mapped;
+	std::size_t used;
+};
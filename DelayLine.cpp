@@ -1,43 +1,106 @@
-/*
-  ==============================================================================
-
-    DelayLine.cpp
-    Created: 17 Nov 2019 10:28:01am
-    Author:  profw
-
-  ==============================================================================
-*/
-
-#include "DelayLine.h"
-
-DelayLine::DelayLine()
-{
-	head = 0;
-	outsample = 0.0;
-	damping = 0.0;
-}
-
-void DelayLine::setsampledelay(int sampledelay)
-{
-	// This resizes the delay line
-	buffer.resize(sampledelay, 0.0);
-	if (head >= buffer.size())
-		head = 0;
-}
-
-double DelayLine::step(double sample)
-{
-	// Update output, then insert sample
-	outsample = damping * outsample + (1.0 - damping) * buffer[head];
-	buffer[head] = sample;
-	head = ++head % buffer.size();
-	return outsample;
-}
-
-void DelayLine::reset()
-{
-	for (auto& x : buffer)
-		x = 0.0;
-	head = 0;
-	outsample = 0.0;
-}
+/*
+  ==============================================================================
+
+    DelayLine.cpp
+    Created: 17 Nov 2019 10:28:01am
+    Author:  profw
+
+  ==============================================================================
+*/
+
+#include "DelayLine.h"
+#include "DSPkernels.h"
+
+template <typename T, typename C>
+DelayLineT<T, C>::DelayLineT()
+{
+	outsample = 0.0;
+	damping = 0.0;
+}
+
+template <typename T, typename C>
+void DelayLineT<T, C>::setsampledelay(int sampledelay)
+{
+	buffer.setdelay(sampledelay);
+}
+
+template <typename T, typename C>
+C DelayLineT<T, C>::step(C sample)
+{
+	// Update output, then insert sample
+	outsample = damping * outsample + (C(1) - damping) * C(buffer.read());
+	buffer.write(T(sample));
+	return outsample;
+}
+
+template <typename T, typename C>
+template <typename SampleType>
+void DelayLineT<T, C>::procsamples(const SampleType* insamples, SampleType* outsamples, int numsamples)
+{
+	// The block is moved through the buffer in chunks no longer than the delay, so the
+	// delayed samples for a chunk can be read before its input is written
+	T delayed[RINGCHUNK];
+	T chunk[RINGCHUNK];
+	const unsigned int maxlen = buffer.getdelay() < RINGCHUNK ? buffer.getdelay() : RINGCHUNK;
+	C out = outsample;
+	for (int start = 0; start < numsamples; start += maxlen)
+	{
+		unsigned int len = unsigned(numsamples - start) < maxlen ? unsigned(numsamples - start) : maxlen;
+		buffer.readblock(delayed, len);
+		convertsamples(insamples + start, chunk, int(len));
+		buffer.writeblock(chunk, len);
+		for (unsigned int n = 0; n < len; n++)
+		{
+			out = damping * out + (C(1) - damping) * C(delayed[n]);
+			outsamples[start + n] = SampleType(out);
+		}
+	}
+	outsample = out;
+}
+
+template <typename T, typename C>
+void DelayLineT<T, C>::procblock(const float* insamples, float* outsamples, int numsamples)
+{
+	procsamples(insamples, outsamples, numsamples);
+}
+
+template <typename T, typename C>
+void DelayLineT<T, C>::procblock(const double* insamples, double* outsamples, int numsamples)
+{
+	procsamples(insamples, outsamples, numsamples);
+}
+
+template <typename T, typename C>
+void DelayLineT<T, C>::reset()
+{
+	buffer.clear();
+	outsample = 0.0;
+}
+
+template <typename T, typename C>
+void DelayLineT<T, C>::savestate(SnapshotWriter& writer) const
+{
+	writer.begin(snapshottag("DLYL"));
+	writer.put(std::uint32_t(sizeof(C)));
+	writer.put(outsample);
+	writer.put(damping);
+	writer.end();
+	buffer.savestate(writer);
+}
+
+template <typename T, typename C>
+bool DelayLineT<T, C>::loadstate(SnapshotReader& reader)
+{
+	std::uint32_t size;
+	C out, damp;
+	if (!reader.begin(snapshottag("DLYL")) || !reader.get(size) || size != sizeof(C) || !reader.get(out)
+		|| !reader.get(damp) || !reader.end() || !buffer.loadstate(reader))
+		return false;
+	outsample = out;
+	damping = damp;
+	return true;
+}
+
+template class DelayLineT<float>;
+template class DelayLineT<double>;
+template class DelayLineT<float, double>;
@@ -1,63 +1,135 @@
-/*
-  ==============================================================================
-
-    DelayLine.h
-    Created: 17 Nov 2019 10:28:01am
-    Author:  profw
-
-  ==============================================================================
-*/
-
-#pragma once
-
-#include <vector>
-
-typedef std::vector<float>::size_type vector_size;
-
-/// <summary>
-/// This class models a propagation delay with frequency-dependent attenuation
-/// </summary>
-class DelayLine
-{
-public:
-	DelayLine();
-	~DelayLine() {}
-
-	/// <summary>
-	/// Set sample delay
-	/// </summary>
-	/// <param name="sampledelay">delay in samples</param>
-	void setsampledelay(int sampledelay);
-
-	/// <summary>
-	/// Set damping parameter
-	/// </summary>
-	/// <param name="damp">damping parameter (no units)</param>
-	void setdamping(double damp) { damping = damp; }
-
-	/// <summary>
-	/// Get sample dealy
-	/// </summary>
-	/// <returns>delay in samples</returns>
-	unsigned int getdelay() { return buffer.size(); }
-
-	/// <summary>
-	/// Step delay line through one sample period
-	/// </summary>
-	/// <param name="sample">input sample</param>
-	/// <returns>output sample</returns>
-	double step(double sample);
-
-	/// <summary>
-	/// Reset the delay line
-	/// 
-	/// Clears the buffer and the output, but maintains the sample delay and damping.
-	/// </summary>
-	void reset();
-
-private:
-	std::vector<double> buffer;
-	unsigned int head;
-	double outsample;
-	double damping;
-};
\ No newline at end of file
+/*
+  ==============================================================================
+
+    DelayLine.h
+    Created: 17 Nov 2019 10:28:01am
+    Author:  profw
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <vector>
+#include "RingBuffer.h"
+
+typedef std::vector<float>::size_type vector_size;
+
+/// <summary>
+/// This class models a propagation delay with frequency-dependent attenuation
+///
+/// The template parameters are the type of the samples held in the delay line (T) and of the
+/// damping parameter and output filter (C, by default the same as T). DelayLine is the double
+/// precision delay line.
+/// </summary>
+template <typename T, typename C = T>
+class DelayLineT
+{
+public:
+	DelayLineT();
+	~DelayLineT() {}
+
+	/// <summary>
+	/// Set sample delay
+	/// 
+	/// Samples already in the delay line are kept, so a change of delay moves the output tap.
+	/// Once the storage comes from a DelayArena, the delay is limited to the maximum given to
+	/// setmaxdelay() and nothing is allocated.
+	/// </summary>
+	/// <param name="sampledelay">delay in samples</param>
+	void setsampledelay(int sampledelay);
+
+	/// <summary>
+	/// Reserve storage for a maximum delay
+	/// </summary>
+	/// <param name="maxdelay">maximum delay in samples</param>
+	/// <param name="arena">arena to take the storage from (nullptr to allocate it)</param>
+	/// <returns>false if the arena does not have enough room left</returns>
+	bool setmaxdelay(int maxdelay, DelayArena* arena = nullptr)
+	{
+		return buffer.reserve(maxdelay > 0 ? unsigned(maxdelay) : 1, arena);
+	}
+
+	/// <summary>
+	/// Set damping parameter
+	/// </summary>
+	/// <param name="damp">damping parameter (no units)</param>
+	void setdamping(double damp) { damping = C(damp); }
+
+	/// <summary>
+	/// Get sample dealy
+	/// </summary>
+	/// <returns>delay in samples</returns>
+	unsigned int getdelay() { return buffer.getdelay(); }
+
+	/// <summary>
+	/// Step delay line through one sample period
+	/// </summary>
+	/// <param name="sample">input sample</param>
+	/// <returns>output sample</returns>
+	C step(C sample);
+
+	/// <summary>
+	/// Process a block of samples
+	/// </summary>
+	/// <param name="insamples">pointer to first input sample</param>
+	/// <param name="outsamples">pointer to first output sample (may be the same as insamples)</param>
+	/// <param name="numsamples">number of samples in the block</param>
+	void procblock(const float* insamples, float* outsamples, int numsamples);
+
+	/// <summary>
+	/// Process a block of double precision samples
+	/// </summary>
+	/// <param name="insamples">pointer to first input sample</param>
+	/// <param name="outsamples">pointer to first output sample (may be the same as insamples)</param>
+	/// <param name="numsamples">number of samples in the block</param>
+	void procblock(const double* insamples, double* outsamples, int numsamples);
+
+	/// <summary>
+	/// Process a block of samples in place
+	/// 
+	/// Note: this method modifies the input samples - they become the output samples.
+	/// </summary>
+	/// <param name="samples">pointer to first audio sample</param>
+	/// <param name="numsamples">number of samples in the block</param>
+	void procblock(float* samples, int numsamples) { procblock(samples, samples, numsamples); }
+
+	/// <summary>
+	/// Process a block of double precision samples in place
+	/// </summary>
+	/// <param name="samples">pointer to first audio sample</param>
+	/// <param name="numsamples">number of samples in the block</param>
+	void procblock(double* samples, int numsamples) { procblock(samples, samples, numsamples); }
+
+	/// <summary>
+	/// Reset the delay line
+	/// 
+	/// Clears the buffer and the output, but maintains the sample delay and damping.
+	/// </summary>
+	void reset();
+
+	/// <summary>
+	/// Write the delay, damping, output and buffer contents to a snapshot
+	/// </summary>
+	/// <param name="writer">snapshot</param>
+	void savestate(SnapshotWriter& writer) const;
+
+	/// <summary>
+	/// Restore everything written by savestate()
+	///
+	/// The buffer grows if it must to hold the saved delay (see RingBuffer::loadstate()).
+	/// </summary>
+	/// <param name="reader">snapshot</param>
+	/// <returns>false if the next records are not a delay line of this type</returns>
+	bool loadstate(SnapshotReader& reader);
+
+private:
+	template <typename SampleType>
+	void procsamples(const SampleType* insamples, SampleType* outsamples, int numsamples);
+
+	RingBuffer<T> buffer;
+	C outsample;
+	C damping;
+};
+
+typedef DelayLineT<double> DelayLine;
\ No newline at end of file
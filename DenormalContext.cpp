@@ -0,0 +1,112 @@
+/*
+  ==============================================================================
+
+    DenormalContext.cpp
+
+  ==============================================================================
+*/
+
+#include "DenormalContext.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DENORMAL_MXCSR
+#include <xmmintrin.h>
+// flush to zero and denormals are zero bits of MXCSR
+constexpr unsigned int FLUSHBITS = 0x8040;
+#elif defined(__aarch64__) && defined(__GNUC__)
+#define DENORMAL_FPCR
+// flush to zero bit of FPCR (applies to operands as well as results)
+constexpr unsigned long long FLUSHBITS = 1ull << 24;
+#endif
+
+// Read the floating point control register of the calling thread
+static unsigned long long getcontrol()
+{
+#if defined(DENORMAL_MXCSR)
+	return _mm_getcsr();
+#elif defined(DENORMAL_FPCR)
+	unsigned long long fpcr;
+	__asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+	return fpcr;
+#else
+	return 0;
+#endif
+}
+
+// Write the floating point control register of the calling thread
+static void setcontrol(unsigned long long control)
+{
+#if defined(DENORMAL_MXCSR)
+	_mm_setcsr(static_cast<unsigned int>(control));
+#elif defined(DENORMAL_FPCR)
+	__asm__ __volatile__("msr fpcr, %0" : : "r"(control));
+#else
+	(void)control;
+#endif
+}
+
+DenormalContext::DenormalContext(DenormalMode mode)
+{
+	saved = getcontrol();
+	flushing = mode != DenormalMode::INJECT && mode != DenormalMode::NOFLUSH && canflush();
+	restore = false;
+	noise = 1;
+#if defined(DENORMAL_MXCSR) || defined(DENORMAL_FPCR)
+	if (flushing)
+		setcontrol(saved | FLUSHBITS);
+	else if (mode == DenormalMode::NOFLUSH)
+		setcontrol(saved & ~FLUSHBITS);
+	restore = flushing || mode == DenormalMode::NOFLUSH;
+#endif
+	// NOFLUSH asks for exact arithmetic, so it adds no noise either
+	injecting = !flushing && mode != DenormalMode::NOFLUSH;
+}
+
+DenormalContext::~DenormalContext()
+{
+	if (restore)
+		setcontrol(saved);
+}
+
+void DenormalContext::inject(float* samples, int numsamples)
+{
+	if (!injecting)
+		return;
+	// white noise from a linear congruential generator, scaled to +/-ANTIDENORMAL
+	const float scale = float(ANTIDENORMAL / 2147483648.0);
+	for (int n = 0; n < numsamples; n++)
+	{
+		noise = noise * 1664525u + 1013904223u;
+		samples[n] += float(static_cast<int>(noise)) * scale;
+	}
+}
+
+void DenormalContext::inject(double* samples, int numsamples)
+{
+	if (!injecting)
+		return;
+	const double scale = ANTIDENORMAL / 2147483648.0;
+	for (int n = 0; n < numsamples; n++)
+	{
+		noise = noise * 1664525u + 1013904223u;
+		samples[n] += double(static_cast<int>(noise)) * scale;
+	}
+}
+
+bool DenormalContext::canflush()
+{
+#if defined(DENORMAL_MXCSR) || defined(DENORMAL_FPCR)
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool DenormalContext::isthreadflushing()
+{
+#if defined(DENORMAL_MXCSR) || defined(DENORMAL_FPCR)
+	return (getcontrol() & FLUSHBITS) == FLUSHBITS;
+#else
+	return false;
+#endif
+}
@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    DenormalContext.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+// Peak level of the noise added by DenormalContext::inject() (about -400 dB)
+constexpr double ANTIDENORMAL = 1e-20;
+
+/// <summary>
+/// How a DenormalContext keeps subnormal numbers out of the processing
+/// </summary>
+enum class DenormalMode
+{
+	FLUSH,	// set the flush to zero and denormals are zero modes of the floating point unit
+	INJECT,	// leave the floating point unit alone; inject() adds noise far below the signal
+	AUTO,	// FLUSH where the processor supports it, INJECT elsewhere
+	NOFLUSH	// clear the flush to zero and denormals are zero modes, so subnormal numbers are exact
+};
+
+/// <summary>
+/// Scoped protection against subnormal numbers in feedback structures
+///
+/// When the input of an LPcombfilter, LPAPfilter, DelayLine or Waveguide falls silent, the
+/// recirculating samples decay toward zero and eventually become subnormal. Many processors
+/// take a slow path for every operation on a subnormal operand, so a filter can use ten to a
+/// hundred times its normal time for as long as the tail lasts. Create a context at the start
+/// of the audio callback: in FLUSH mode it switches the floating point unit of the calling
+/// thread to flush subnormal results and operands to zero (FTZ and DAZ on x86, FZ on ARM), and
+/// its destructor restores the previous mode, so code outside the callback is unaffected.
+/// Where that is not available, INJECT mode instead adds noise of ANTIDENORMAL peak level to
+/// the input of each feedback structure, through inject(), so its state never decays below that
+/// level. AUTO picks the first that works; inject() does nothing while flushing. NOFLUSH turns
+/// flushing off for the life of the context, for code that must run exactly as it would on a
+/// thread that never entered a context.
+///
+/// The floating point mode belongs to a thread. Tasks queued on a TaskPool run with the mode of
+/// the thread that queued them, and the worker threads of a compiled MPnetwork run each block
+/// with the mode of the thread that called netstep().
+/// </summary>
+class DenormalContext
+{
+public:
+	/// <summary>
+	/// Enter the context
+	/// </summary>
+	/// <param name="mode">how subnormal numbers are avoided</param>
+	explicit DenormalContext(DenormalMode mode = DenormalMode::AUTO);
+
+	/// <summary>
+	/// Leave the context, restoring the floating point mode it was entered with
+	/// </summary>
+	~DenormalContext();
+	DenormalContext(const DenormalContext&) = delete;
+	DenormalContext& operator=(const DenormalContext&) = delete;
+
+	/// <summary>
+	/// Check whether this context flushes subnormal numbers to zero
+	/// </summary>
+	/// <returns>true if flushing</returns>
+	bool isflushing() const { return flushing; }
+
+	/// <summary>
+	/// Add anti-denormal noise to a block of samples (INJECT mode)
+	///
+	/// Call this on the input of each feedback structure before processing it. The noise is
+	/// far below the resolution of any audible signal, so only silence is changed. Nothing is
+	/// added while flushing or in NOFLUSH mode.
+	/// </summary>
+	/// <param name="samples">pointer to first sample</param>
+	/// <param name="numsamples">number of samples in the block</param>
+	void inject(float* samples, int numsamples);
+
+	/// <summary>
+	/// Add anti-denormal noise to a block of samples (INJECT mode)
+	/// </summary>
+	/// <param name="samples">pointer to first sample</param>
+	/// <param name="numsamples">number of samples in the block</param>
+	void inject(double* samples, int numsamples);
+
+	/// <summary>
+	/// Check whether the processor can flush subnormal numbers to zero
+	/// </summary>
+	/// <returns>true if FLUSH mode is available</returns>
+	static bool canflush();
+
+	/// <summary>
+	/// Check whether the calling thread currently flushes subnormal numbers to zero
+	/// </summary>
+	/// <returns>true if flushing</returns>
+	static bool isthreadflushing();
+
+private:
+	unsigned long long saved;
+	bool flushing;
+	bool injecting;
+	bool restore; // the control register was changed and is restored on exit
+	unsigned int noise;
+};
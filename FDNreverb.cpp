@@ -0,0 +1,170 @@
+/*
+  ==============================================================================
+
+    FDNreverb.cpp
+
+  ==============================================================================
+*/
+
+#include "FDNreverb.h"
+#include "DSPkernels.h"
+#include <algorithm>
+#include <cmath>
+
+// Longest chunk processed at once. The chunk rows live on the stack, so many reverbs running
+// on one thread share the same few kilobytes of scratch memory.
+constexpr int FDNCHUNK = 64;
+
+// Prime delay lengths, spread evenly on a log scale; fewer lines take every second, fourth ...
+static const int DEFAULTDELAYS[MAXFDNLINES] = { 1031, 1109, 1187, 1277, 1367, 1471, 1567, 1693, 1801, 1931,
+	2069, 2221, 2377, 2549, 2731, 2927 };
+
+FDNreverb::FDNreverb()
+{
+	matrix = FDNmatrix::HADAMARD;
+	damping = 0.2;
+	decaytime = 96000.0;
+	writepos = 0;
+	init(8);
+}
+
+bool FDNreverb::init(int numlines)
+{
+	if (numlines != 2 && numlines != 4 && numlines != 8 && numlines != 16)
+		return false;
+	this->numlines = numlines;
+	const int spacing = MAXFDNLINES / numlines;
+	const double gain = 1.0 / std::sqrt(double(numlines));
+	for (int i = 0; i < numlines; i++)
+	{
+		delays[i] = DEFAULTDELAYS[i * spacing + spacing - 1];
+		ingain[i] = 1.0;
+		outgain[i] = i % 2 ? -gain : gain;
+	}
+	arena.clear();
+	layout();
+	return true;
+}
+
+void FDNreverb::setdelay(int line, int delay)
+{
+	delays[line] = delay > 0 ? delay : 1;
+	layout();
+}
+
+void FDNreverb::setdamping(double damp)
+{
+	damping = damp;
+	updatefeedback();
+}
+
+void FDNreverb::setdecaytime(double T60)
+{
+	decaytime = T60;
+	updatefeedback();
+}
+
+void FDNreverb::layout()
+{
+	unsigned int total = 0;
+	bool fits = true;
+	mindelay = delays[0];
+	for (int i = 0; i < numlines; i++)
+	{
+		unsigned int capacity = 1;
+		while (capacity < unsigned(delays[i]))
+			capacity <<= 1;
+		if (arena.empty() || capacity > masks[i] + 1)
+			fits = false;
+		total += capacity;
+		mindelay = std::min(mindelay, delays[i]);
+	}
+	if (!fits)
+	{
+		// lines follow one another in the order they are visited
+		arena.assign(total, 0.0f);
+		unsigned int base = 0;
+		for (int i = 0; i < numlines; i++)
+		{
+			unsigned int capacity = 1;
+			while (capacity < unsigned(delays[i]))
+				capacity <<= 1;
+			bases[i] = base;
+			masks[i] = capacity - 1;
+			base += capacity;
+		}
+		reset();
+	}
+	updatefeedback();
+}
+
+void FDNreverb::updatefeedback()
+{
+	// a line of length D loses 60 dB every T60/D round trips
+	for (int i = 0; i < numlines; i++)
+	{
+		dampcoef[i] = damping;
+		feedback[i] = std::pow(10.0, -3.0 * delays[i] / decaytime) * (1.0 - damping);
+	}
+}
+
+double FDNreverb::step(double sample)
+{
+	// a chunk of one sample, with the input rounded like procblock() rounds it
+	const DSPkernels& kernels = getkernels();
+	double lines[MAXFDNLINES];
+	const double* coefs[4] = { dampcoef, feedback, ingain, outgain };
+	const double in = float(sample);
+	double out;
+	for (int i = 0; i < numlines; i++)
+		lines[i] = arena[bases[i] + ((writepos - unsigned(delays[i])) & masks[i])];
+	kernels.fdnfeedback(lines, 1, numlines, 1, coefs, state, &in, &out, matrix == FDNmatrix::HOUSEHOLDER);
+	for (int i = 0; i < numlines; i++)
+		arena[bases[i] + (writepos & masks[i])] = float(lines[i]);
+	writepos++;
+	return float(out);
+}
+
+void FDNreverb::procblock(const float* insamples, float* outsamples, int numsamples)
+{
+	// Rows of the chunk: one per line, then the input and the output
+	const DSPkernels& kernels = getkernels();
+	double rows[(MAXFDNLINES + 2) * FDNCHUNK];
+	double* inrow = rows + numlines * FDNCHUNK;
+	double* outrow = inrow + FDNCHUNK;
+	const double* coefs[4] = { dampcoef, feedback, ingain, outgain };
+	const int maxlen = mindelay < FDNCHUNK ? mindelay : FDNCHUNK;
+	for (int start = 0; start < numsamples; start += maxlen)
+	{
+		const int len = numsamples - start < maxlen ? numsamples - start : maxlen;
+		for (int i = 0; i < numlines; i++)
+		{
+			const float* line = &arena[bases[i]];
+			unsigned int pos = (writepos - unsigned(delays[i])) & masks[i];
+			int first = int(masks[i] + 1 - pos) < len ? int(masks[i] + 1 - pos) : len;
+			kernels.floattodouble(line + pos, rows + i * FDNCHUNK, first);
+			kernels.floattodouble(line, rows + i * FDNCHUNK + first, len - first);
+		}
+		kernels.floattodouble(insamples + start, inrow, len);
+		kernels.fdnfeedback(rows, FDNCHUNK, numlines, len, coefs, state, inrow, outrow,
+			matrix == FDNmatrix::HOUSEHOLDER);
+		for (int i = 0; i < numlines; i++)
+		{
+			float* line = &arena[bases[i]];
+			unsigned int pos = writepos & masks[i];
+			int first = int(masks[i] + 1 - pos) < len ? int(masks[i] + 1 - pos) : len;
+			kernels.doubletofloat(rows + i * FDNCHUNK, line + pos, first);
+			kernels.doubletofloat(rows + i * FDNCHUNK + first, line, len - first);
+		}
+		kernels.doubletofloat(outrow, outsamples + start, len);
+		writepos += unsigned(len);
+	}
+}
+
+void FDNreverb::reset()
+{
+	std::fill(arena.begin(), arena.end(), 0.0f);
+	for (int i = 0; i < MAXFDNLINES; i++)
+		state[i] = 0.0;
+	writepos = 0;
+}
@@ -0,0 +1,146 @@
+/*
+  ==============================================================================
+
+    FDNreverb.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <vector>
+
+// Largest number of delay lines of an FDNreverb
+constexpr int MAXFDNLINES = 16;
+
+/// <summary>
+/// Feedback matrix of an FDNreverb
+/// </summary>
+enum class FDNmatrix
+{
+	HADAMARD, // normalized Hadamard matrix, applied as a fast Walsh-Hadamard transform
+	HOUSEHOLDER // I - (2/N) 1 1^T
+};
+
+/// <summary>
+/// Feedback delay network reverb
+///
+/// Each of the delay lines is a lowpass comb filter like LPcombfilter (the output of the
+/// line is damped by a one pole lowpass with unity gain at DC and scaled to give the decay
+/// time), but instead of feeding back into its own line, the filtered outputs are mixed by an
+/// orthogonal matrix and fed back into every line. The output is the sum of the filtered lines
+/// with alternating signs.
+///
+/// Blocks are processed in chunks no longer than the shortest delay, so a whole chunk of
+/// every line is read before any of it is written. The lowpass recursions then run along each
+/// line, and the matrix is applied to all samples of the chunk at once in SIMD lanes. All the
+/// delay lines are packed into one buffer and each is read and written sequentially, a chunk
+/// at a time, so memory is touched in a few long streams rather than in one scattered access
+/// per line per sample.
+/// </summary>
+class FDNreverb
+{
+public:
+	FDNreverb();
+	~FDNreverb() {}
+
+	/// <summary>
+	/// Set number of delay lines
+	///
+	/// The delays are set to different prime lengths between 1031 and 2927 samples, and the
+	/// network is cleared.
+	/// </summary>
+	/// <param name="numlines">number of delay lines (2, 4, 8 or 16)</param>
+	/// <returns>false if the number of lines is not supported</returns>
+	bool init(int numlines);
+
+	/// <summary>
+	/// Get number of delay lines
+	/// </summary>
+	/// <returns>number of delay lines</returns>
+	int getnumlines() const { return numlines; }
+
+	/// <summary>
+	/// Set delay of one line
+	///
+	/// If the line needs more memory, the network is cleared.
+	/// </summary>
+	/// <param name="line">line index</param>
+	/// <param name="delay">delay in samples (at least 1)</param>
+	void setdelay(int line, int delay);
+
+	/// <summary>
+	/// Get delay of one line
+	/// </summary>
+	/// <param name="line">line index</param>
+	/// <returns>delay in samples</returns>
+	int getdelay(int line) const { return delays[line]; }
+
+	/// <summary>
+	/// Set damping parameter of every line
+	/// </summary>
+	/// <param name="damp">damping parameter (no units)</param>
+	void setdamping(double damp);
+
+	/// <summary>
+	/// Set decay time
+	/// </summary>
+	/// <param name="T60">time for the reverberation to decay by 60 dB at DC (samples)</param>
+	void setdecaytime(double T60);
+
+	/// <summary>
+	/// Set feedback matrix
+	/// </summary>
+	/// <param name="type">matrix</param>
+	void setmatrix(FDNmatrix type) { matrix = type; }
+
+	/// <summary>
+	/// Step reverb through one sample period
+	/// </summary>
+	/// <param name="sample">audio sample</param>
+	/// <returns>output sample</returns>
+	double step(double sample);
+
+	/// <summary>
+	/// Process a block of samples
+	/// </summary>
+	/// <param name="insamples">pointer to first input sample</param>
+	/// <param name="outsamples">pointer to first output sample (may be the same as insamples)</param>
+	/// <param name="numsamples">number of samples in the block</param>
+	void procblock(const float* insamples, float* outsamples, int numsamples);
+
+	/// <summary>
+	/// Process a block of samples in place
+	///
+	/// Note: this method modifies the input samples - they become the output samples.
+	/// </summary>
+	/// <param name="samples">pointer to first audio sample</param>
+	/// <param name="numsamples">number of samples in the block</param>
+	void procblock(float* samples, int numsamples) { procblock(samples, samples, numsamples); }
+
+	/// <summary>
+	/// Clear delay lines and reset state variables
+	/// </summary>
+	void reset();
+
+private:
+	void layout();
+	void updatefeedback();
+
+	int numlines;
+	FDNmatrix matrix;
+	double damping;
+	double decaytime;
+	int delays[MAXFDNLINES];
+	int mindelay;
+	double dampcoef[MAXFDNLINES];
+	double feedback[MAXFDNLINES];
+	double ingain[MAXFDNLINES];
+	double outgain[MAXFDNLINES];
+	double state[MAXFDNLINES];
+	// line i occupies a power of two capacity starting at bases[i]
+	std::vector<float> arena;
+	unsigned int bases[MAXFDNLINES];
+	unsigned int masks[MAXFDNLINES];
+	unsigned int writepos;
+};
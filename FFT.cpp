@@ -0,0 +1,131 @@
+/*
+  ==============================================================================
+
+    FFT.cpp
+
+  ==============================================================================
+*/
+
+#include "FFT.h"
+#include <cmath>
+
+static const double PI = 3.14159265358979323846;
+
+FFT::FFT()
+{
+	size = 0;
+	half = 0;
+}
+
+void FFT::init(int N)
+{
+	size = N;
+	half = N / 2;
+	int bits = 0;
+	while ((1 << bits) < half)
+		bits++;
+	bitrev.resize(half);
+	for (int n = 0; n < half; n++)
+	{
+		int r = 0;
+		for (int b = 0; b < bits; b++)
+			r |= ((n >> b) & 1) << (bits - 1 - b);
+		bitrev[n] = r;
+	}
+	// stage with butterflies of span h uses twiddles h-1 ... 2h-2
+	stagecos.resize(half > 1 ? half - 1 : 1);
+	stagesin.resize(half > 1 ? half - 1 : 1);
+	for (int h = 1; h < half; h *= 2)
+	{
+		for (int j = 0; j < h; j++)
+		{
+			stagecos[h - 1 + j] = float(std::cos(PI * j / h));
+			stagesin[h - 1 + j] = float(-std::sin(PI * j / h));
+		}
+	}
+	splitcos.resize(half + 1);
+	splitsin.resize(half + 1);
+	for (int k = 0; k <= half; k++)
+	{
+		splitcos[k] = float(std::cos(2.0 * PI * k / N));
+		splitsin[k] = float(std::sin(2.0 * PI * k / N));
+	}
+	workre.resize(half);
+	workim.resize(half);
+}
+
+void FFT::complexfft(float* re, float* im)
+{
+	// Radix-2 decimation in time on input already in bit-reversed order
+	for (int h = 1; h < half; h *= 2)
+	{
+		const float* wr = stagecos.data() + h - 1;
+		const float* wi = stagesin.data() + h - 1;
+		for (int start = 0; start < half; start += 2 * h)
+		{
+			float* ar = re + start;
+			float* ai = im + start;
+			float* br = ar + h;
+			float* bi = ai + h;
+			for (int j = 0; j < h; j++)
+			{
+				float vr = br[j] * wr[j] - bi[j] * wi[j];
+				float vi = br[j] * wi[j] + bi[j] * wr[j];
+				br[j] = ar[j] - vr;
+				bi[j] = ai[j] - vi;
+				ar[j] += vr;
+				ai[j] += vi;
+			}
+		}
+	}
+}
+
+void FFT::forward(const float* in, float* re, float* im)
+{
+	// Even samples are the real parts and odd samples the imaginary parts of a half length
+	// complex signal
+	for (int n = 0; n < half; n++)
+	{
+		workre[bitrev[n]] = in[2 * n];
+		workim[bitrev[n]] = in[2 * n + 1];
+	}
+	complexfft(workre.data(), workim.data());
+
+	// Split into the spectrum of the real signal
+	re[0] = workre[0] + workim[0];
+	im[0] = 0.0f;
+	re[half] = workre[0] - workim[0];
+	im[half] = 0.0f;
+	for (int k = 1; k < half; k++)
+	{
+		float a = workre[k], b = workim[k];
+		float c = workre[half - k], d = workim[half - k];
+		float ere = 0.5f * (a + c), eim = 0.5f * (b - d);
+		float ore = 0.5f * (b + d), oim = -0.5f * (a - c);
+		re[k] = ere + splitcos[k] * ore + splitsin[k] * oim;
+		im[k] = eim + splitcos[k] * oim - splitsin[k] * ore;
+	}
+}
+
+void FFT::inverse(const float* re, const float* im, float* out)
+{
+	// Rebuild the half length spectrum (scaled by 1/N) in bit-reversed order
+	const float scale = 1.0f / float(size);
+	for (int k = 0; k < half; k++)
+	{
+		float a = re[k], b = im[k];
+		float c = re[half - k], d = im[half - k];
+		float dr = a - c, di = b + d;
+		float ore = dr * splitcos[k] - di * splitsin[k];
+		float oim = dr * splitsin[k] + di * splitcos[k];
+		workre[bitrev[k]] = scale * (a + c - oim);
+		workim[bitrev[k]] = scale * (b - d + ore);
+	}
+	// the inverse transform is the forward transform with real and imaginary parts swapped
+	complexfft(workim.data(), workre.data());
+	for (int n = 0; n < half; n++)
+	{
+		out[2 * n] = workre[n];
+		out[2 * n + 1] = workim[n];
+	}
+}
@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    FFT.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <vector>
+
+/// <summary>
+/// Fast Fourier transform of real signals with a power of two length
+///
+/// A real signal of N samples is transformed with a complex FFT of N/2 points followed by a
+/// split step. Spectra hold the N/2+1 bins from DC to Nyquist with real and imaginary parts in
+/// separate arrays, so that products of spectra vectorize. Twiddle factors are computed in
+/// double precision when the size is set, and stored per stage so the butterflies read them
+/// contiguously.
+/// </summary>
+class FFT
+{
+public:
+	FFT();
+	~FFT() {}
+
+	/// <summary>
+	/// Set transform size
+	/// </summary>
+	/// <param name="N">number of real samples (a power of two, at least 4)</param>
+	void init(int N);
+
+	/// <summary>
+	/// Get transform size
+	/// </summary>
+	/// <returns>number of real samples</returns>
+	int getsize() const { return size; }
+
+	/// <summary>
+	/// Forward transform
+	/// </summary>
+	/// <param name="in">N real samples</param>
+	/// <param name="re">real parts of bins 0 to N/2 (output)</param>
+	/// <param name="im">imaginary parts of bins 0 to N/2 (output)</param>
+	void forward(const float* in, float* re, float* im);
+
+	/// <summary>
+	/// Inverse transform, scaled by 1/N so that inverse(forward(x)) = x
+	/// </summary>
+	/// <param name="re">real parts of bins 0 to N/2</param>
+	/// <param name="im">imaginary parts of bins 0 to N/2</param>
+	/// <param name="out">N real samples (output)</param>
+	void inverse(const float* re, const float* im, float* out);
+
+private:
+	void complexfft(float* re, float* im);
+
+	int size;
+	int half; // points of the complex FFT
+	std::vector<int> bitrev;
+	std::vector<float> stagecos, stagesin; // twiddles of each stage, one after another
+	std::vector<float> splitcos, splitsin; // twiddles of the split step
+	std::vector<float> workre, workim;
+};
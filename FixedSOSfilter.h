@@ -0,0 +1,206 @@
+/*
+  ==============================================================================
+
+    FixedSOSfilter.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "BQdesign.h"
+#include "FreqGrid.h"
+
+/// <summary>
+/// Cascade of a fixed number of second order sections.
+///
+/// This class has the same interface as SOSfilter, but the number of sections N is a template
+/// parameter. The sections are held in a plain array inside the object, and since the length
+/// of the cascade is known at compile time the compiler can fully unroll it.
+/// </summary>
+template <int N>
+class FixedSOSfilter
+{
+public:
+	FixedSOSfilter()
+	{
+		sampRate = 44100.0;
+		smoothing = 0;
+		coefcache = nullptr;
+	}
+	~FixedSOSfilter() {}
+
+	/// <summary>
+	/// Initialize the SOS cascade
+	///
+	/// Sections beyond numsects are set to pass the signal through unchanged, so a cascade
+	/// of N sections can hold fewer active sections.
+	/// </summary>
+	/// <param name="numsects">number of active SOS in cascade (at most N)</param>
+	/// <param name="fs">sampling frequency</param>
+	void initsos(int numsects, double fs)
+	{
+		const double unity[3] = { 1.0, 0.0, 0.0 };
+		sampRate = fs;
+		for (int k = 0; k < N; k++)
+		{
+			SOScascade[k] = BQfilter();
+			if (k >= numsects)
+				SOScascade[k].setcoefs(unity, unity);
+			SOScascade[k].setsmoothing(smoothing);
+		}
+	}
+
+	/// <summary>
+	/// Update settings of SOS filter section
+	/// </summary>
+	/// <param name="sect">index of filter in cascade</param>
+	/// <param name="ftype">filter type (BASS, TREBLE, PEAK)</param>
+	/// <param name="Gain">gain (dB)</param>
+	/// <param name="f0">center or cut-off frequency (Hz)</param>
+	/// <param name="Q">Q factor (no units)</param>
+	void updateSection(int sect, FilterType ftype, double Gain, double f0, double Q)
+	{
+		if (coefcache)
+			SOScascade[sect].update(ftype, Gain, f0, Q, sampRate, *coefcache);
+		else
+			SOScascade[sect].update(ftype, Gain, f0, Q, sampRate);
+	}
+
+	/// <summary>
+	/// Set coefficient smoothing for every section
+	/// 
+	/// See BQfilter::setsmoothing().
+	/// </summary>
+	/// <param name="numsamples">length of the interpolation (0 disables smoothing)</param>
+	void setsmoothing(int numsamples)
+	{
+		smoothing = numsamples;
+		for (int k = 0; k < N; k++)
+			SOScascade[k].setsmoothing(numsamples);
+	}
+
+	/// <summary>
+	/// Set coefficient cache
+	/// 
+	/// When a cache is set, updateSection() looks designs up in it. The cache is not owned
+	/// by the filter.
+	/// </summary>
+	/// <param name="cache">coefficient cache (nullptr to design every update)</param>
+	void setcoefcache(BQcoefcache* cache) { coefcache = cache; }
+
+	/// <summary>
+	/// Check whether any section is interpolating its coefficients
+	/// </summary>
+	/// <returns>true while coefficients are being interpolated</returns>
+	bool isramping() const
+	{
+		for (int k = 0; k < N; k++)
+			if (SOScascade[k].isramping())
+				return true;
+		return false;
+	}
+
+	/// <summary>
+	/// Step SOS filter through one sample period
+	/// </summary>
+	/// <param name="sample">input sample</param>
+	/// <returns>output sample</returns>
+	double step(double sample)
+	{
+		double y = sample;
+		for (int k = 0; k < N; k++)
+			y = SOScascade[k].step(y);
+		return y;
+	}
+
+	/// <summary>
+	/// Process a block of samples
+	///
+	/// The state of every section is kept in local variables for the whole block. The output
+	/// matches calling step() for each sample.
+	/// </summary>
+	/// <param name="insamples">pointer to first input sample</param>
+	/// <param name="outsamples">pointer to first output sample (may be the same as insamples)</param>
+	/// <param name="numsamples">number of samples in the block</param>
+	void procblock(const float* insamples, float* outsamples, int numsamples)
+	{
+		// Samples during a coefficient interpolation go through step()
+		while (numsamples > 0 && isramping())
+		{
+			*outsamples++ = float(step(*insamples++));
+			numsamples--;
+		}
+
+		double b0[N], b1[N], b2[N], a1[N], a2[N], z1[N], z2[N];
+		for (int k = 0; k < N; k++)
+		{
+			b0[k] = SOScascade[k].b[0];
+			b1[k] = SOScascade[k].b[1];
+			b2[k] = SOScascade[k].b[2];
+			a1[k] = SOScascade[k].a[1];
+			a2[k] = SOScascade[k].a[2];
+			z1[k] = SOScascade[k].s1;
+			z2[k] = SOScascade[k].s2;
+		}
+		for (int n = 0; n < numsamples; n++)
+		{
+			double x = insamples[n];
+			for (int k = 0; k < N; k++)
+			{
+				double y = b0[k] * x + z1[k];
+				z1[k] = z2[k] + b1[k] * x - a1[k] * y;
+				z2[k] = b2[k] * x - a2[k] * y;
+				x = y;
+			}
+			outsamples[n] = float(x);
+		}
+		for (int k = 0; k < N; k++)
+		{
+			SOScascade[k].s1 = z1[k];
+			SOScascade[k].s2 = z2[k];
+		}
+	}
+
+	/// <summary>
+	/// Process a block of samples in place
+	///
+	/// Note: this method modifies the input samples - they become the output samples.
+	/// </summary>
+	/// <param name="samples">pointer to first audio sample</param>
+	/// <param name="numsamples">number of samples in the block</param>
+	void procblock(float* samples, int numsamples) { procblock(samples, samples, numsamples); }
+
+	/// <summary>
+	/// Calculate magnitude of frequency response
+	/// </summary>
+	/// <param name="freq">frequency (Hz)</param>
+	/// <returns>magnitude of frequency response (dB)</returns>
+	double freqResponse(double freq)
+	{
+		double frmag = 0.0;
+		for (int k = 0; k < N; k++)
+			frmag += SOScascade[k].freqresp(freq, sampRate);
+		return frmag;
+	}
+
+	/// <summary>
+	/// Calculate frequency response at every frequency of a grid
+	/// </summary>
+	/// <param name="grid">frequency grid</param>
+	/// <param name="magdB">magnitude of frequency response (dB) (output)</param>
+	/// <param name="phase">phase (radians) (output, optional)</param>
+	/// <param name="grpdelay">group delay (samples) (output, optional)</param>
+	/// <param name="scratch">scratch arrays for the phase (see FreqScratch) (optional)</param>
+	void freqResponse(const FreqGrid& grid, double* magdB, double* phase = nullptr, double* grpdelay = nullptr,
+		FreqScratch* scratch = nullptr) const
+	{
+		grid.cascaderesp(SOScascade, N, magdB, phase, grpdelay, scratch);
+	}
+
+private:
+	double sampRate;
+	int smoothing;
+	BQcoefcache* coefcache;
+	BQfilter SOScascade[N];
+};
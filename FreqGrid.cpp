@@ -0,0 +1,181 @@
+/*
+  ==============================================================================
+
+    FreqGrid.cpp
+
+  ==============================================================================
+*/
+
+#include <cmath>
+#include "FreqGrid.h"
+#include "BQfilter.h"
+#include "SIMDlanes.h"
+
+FreqGrid::FreqGrid()
+{
+	sampRate = 44100.0;
+}
+
+void FreqGrid::setgrid(const double* freqlist, int numfreqs, double fs)
+{
+	sampRate = fs;
+	freqs.assign(freqlist, freqlist + numfreqs);
+	settables();
+}
+
+void FreqGrid::setloggrid(double fmin, double fmax, int numfreqs, double fs)
+{
+	sampRate = fs;
+	freqs.resize(numfreqs);
+	double ratio = numfreqs > 1 ? pow(fmax / fmin, 1.0 / (numfreqs - 1)) : 1.0;
+	for (int k = 0; k < numfreqs; k++)
+		freqs[k] = fmin * pow(ratio, k);
+	settables();
+}
+
+void FreqGrid::settables()
+{
+	const double PI = 3.141592653589793238463;
+	int numfreqs = int(freqs.size());
+	cos1.resize(numfreqs);
+	cos2.resize(numfreqs);
+	sin1.resize(numfreqs);
+	sin2.resize(numfreqs);
+	for (int k = 0; k < numfreqs; k++)
+	{
+		double theta = 2.0 * PI * freqs[k] / sampRate;
+		cos1[k] = cos(theta);
+		cos2[k] = cos(2.0 * theta);
+		sin1[k] = sin(theta);
+		sin2[k] = sin(2.0 * theta);
+	}
+}
+
+// Section kernels, written once for scalar and SIMD lanes. k is the index of the first frequency.
+
+// Multiply accumulated squared magnitude by that of one section
+template <typename T>
+static inline void magkernel(const double* c1, const double* c2, const double* Bc, const double* Ac, double* magsq, int k)
+{
+	// |B(theta)|^2 = B0 + B1 cos(theta) + B2 cos(2 theta), likewise for A (as in BQfilter::freqresp)
+	T cos1 = laneload<T>(c1 + k);
+	T cos2 = laneload<T>(c2 + k);
+	T num = lanebroadcast<T>(Bc[0]) + lanebroadcast<T>(Bc[1]) * cos1 + lanebroadcast<T>(Bc[2]) * cos2;
+	T den = lanebroadcast<T>(Ac[0]) + lanebroadcast<T>(Ac[1]) * cos1 + lanebroadcast<T>(Ac[2]) * cos2;
+	// skip sections giving 0.0 / 0.0
+	lanestore(magsq + k, laneload<T>(magsq + k) * ifnan(num / den, lanebroadcast<T>(1.0)));
+}
+
+// Multiply accumulated numerator and denominator phasors by those of one section
+template <typename T>
+static inline void phasekernel(const double* c1, const double* c2, const double* s1, const double* s2,
+	const double* b, const double* a, double* nre, double* nim, double* dre, double* dim, int k)
+{
+	// B(theta) = b0 + b1 e^{-j theta} + b2 e^{-2j theta}, likewise for A
+	T cos1 = laneload<T>(c1 + k), cos2 = laneload<T>(c2 + k);
+	T sin1 = laneload<T>(s1 + k), sin2 = laneload<T>(s2 + k);
+	T zero = lanebroadcast<T>(0.0);
+	T br = lanebroadcast<T>(b[0]) + lanebroadcast<T>(b[1]) * cos1 + lanebroadcast<T>(b[2]) * cos2;
+	T bi = zero - (lanebroadcast<T>(b[1]) * sin1 + lanebroadcast<T>(b[2]) * sin2);
+	T ar = lanebroadcast<T>(1.0) + lanebroadcast<T>(a[1]) * cos1 + lanebroadcast<T>(a[2]) * cos2;
+	T ai = zero - (lanebroadcast<T>(a[1]) * sin1 + lanebroadcast<T>(a[2]) * sin2);
+	T xr = laneload<T>(nre + k), xi = laneload<T>(nim + k);
+	lanestore(nre + k, xr * br - xi * bi);
+	lanestore(nim + k, xr * bi + xi * br);
+	xr = laneload<T>(dre + k);
+	xi = laneload<T>(dim + k);
+	lanestore(dre + k, xr * ar - xi * ai);
+	lanestore(dim + k, xr * ai + xi * ar);
+}
+
+// Add group delay of one section
+template <typename T>
+static inline void gdkernel(const double* c1, const double* c2, const double* s1, const double* s2,
+	const double* b, const double* a, double* grpdelay, int k)
+{
+	// group delay of a polynomial P is Re(sum_m m p_m e^{-jm theta} / P(theta))
+	T cos1 = laneload<T>(c1 + k), cos2 = laneload<T>(c2 + k);
+	T sin1 = laneload<T>(s1 + k), sin2 = laneload<T>(s2 + k);
+	T zero = lanebroadcast<T>(0.0);
+	T two = lanebroadcast<T>(2.0);
+	T b0 = lanebroadcast<T>(b[0]), b1 = lanebroadcast<T>(b[1]), b2 = lanebroadcast<T>(b[2]);
+	T a1 = lanebroadcast<T>(a[1]), a2 = lanebroadcast<T>(a[2]);
+	T br = b0 + b1 * cos1 + b2 * cos2;
+	T bi = zero - (b1 * sin1 + b2 * sin2);
+	T bdr = b1 * cos1 + two * b2 * cos2;
+	T bdi = zero - (b1 * sin1 + two * b2 * sin2);
+	T ar = lanebroadcast<T>(1.0) + a1 * cos1 + a2 * cos2;
+	T ai = zero - (a1 * sin1 + a2 * sin2);
+	T adr = a1 * cos1 + two * a2 * cos2;
+	T adi = zero - (a1 * sin1 + two * a2 * sin2);
+	T gd = (bdr * br + bdi * bi) / (br * br + bi * bi) - (adr * ar + adi * ai) / (ar * ar + ai * ai);
+	lanestore(grpdelay + k, laneload<T>(grpdelay + k) + gd);
+}
+
+void FreqGrid::cascaderesp(const BQfilter* sects, int numsects, double* magdB, double* phase, double* grpdelay,
+	FreqScratch* scratch) const
+{
+	const int numfreqs = int(freqs.size());
+	const int numvec = numfreqs / VECLANES * VECLANES;
+	const double* c1 = cos1.data();
+	const double* c2 = cos2.data();
+	const double* s1 = sin1.data();
+	const double* s2 = sin2.data();
+
+	// Squared magnitude is accumulated as a product in magdB, then converted to dB
+	for (int k = 0; k < numfreqs; k++)
+		magdB[k] = 1.0;
+	// Numerator and denominator phasors of the whole cascade, for the phase
+	FreqScratch local;
+	FreqScratch& phasors = scratch ? *scratch : local;
+	if (phase)
+	{
+		phasors.nre.assign(numfreqs, 1.0);
+		phasors.nim.assign(numfreqs, 0.0);
+		phasors.dre.assign(numfreqs, 1.0);
+		phasors.dim.assign(numfreqs, 0.0);
+	}
+	double* nre = phasors.nre.data();
+	double* nim = phasors.nim.data();
+	double* dre = phasors.dre.data();
+	double* dim = phasors.dim.data();
+	if (grpdelay)
+		for (int k = 0; k < numfreqs; k++)
+			grpdelay[k] = 0.0;
+
+	for (int sect = 0; sect < numsects; sect++)
+	{
+		double b[3], a[3];
+		sects[sect].getcoefs(b, a);
+		const double Bc[3] = { b[0] * b[0] + b[1] * b[1] + b[2] * b[2], 2.0 * (b[0] * b[1] + b[1] * b[2]), 2.0 * b[0] * b[2] };
+		const double Ac[3] = { 1.0 + a[1] * a[1] + a[2] * a[2], 2.0 * (a[1] + a[1] * a[2]), 2.0 * a[2] };
+
+		int k = 0;
+		for (; k < numvec; k += VECLANES)
+			magkernel<lanevec>(c1, c2, Bc, Ac, magdB, k);
+		for (; k < numfreqs; k++)
+			magkernel<double>(c1, c2, Bc, Ac, magdB, k);
+
+		if (phase)
+		{
+			for (k = 0; k < numvec; k += VECLANES)
+				phasekernel<lanevec>(c1, c2, s1, s2, b, a, nre, nim, dre, dim, k);
+			for (; k < numfreqs; k++)
+				phasekernel<double>(c1, c2, s1, s2, b, a, nre, nim, dre, dim, k);
+		}
+
+		if (grpdelay)
+		{
+			for (k = 0; k < numvec; k += VECLANES)
+				gdkernel<lanevec>(c1, c2, s1, s2, b, a, grpdelay, k);
+			for (; k < numfreqs; k++)
+				gdkernel<double>(c1, c2, s1, s2, b, a, grpdelay, k);
+		}
+	}
+
+	for (int k = 0; k < numfreqs; k++)
+		magdB[k] = 10.0 * log10(std::abs(magdB[k]));
+	if (phase)
+		for (int k = 0; k < numfreqs; k++)
+			phase[k] = atan2(nim[k] * dre[k] - nre[k] * dim[k], nre[k] * dre[k] + nim[k] * dim[k]);
+}
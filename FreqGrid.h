@@ -0,0 +1,108 @@
+/*
+  ==============================================================================
+
+    FreqGrid.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <vector>
+
+template <typename C> class BQfilterT;
+typedef BQfilterT<double> BQfilter;
+
+/// <summary>
+/// Scratch arrays for the phase computed by FreqGrid::cascaderesp()
+///
+/// Keep one for each thread that evaluates responses and pass it with every call. The arrays
+/// grow to the largest grid used with it and are then reused, so later calls allocate nothing.
+/// </summary>
+class FreqScratch
+{
+public:
+	FreqScratch() {}
+	~FreqScratch() {}
+
+private:
+	friend class FreqGrid;
+	// numerator and denominator phasors of the cascade
+	std::vector<double> nre, nim, dre, dim;
+};
+
+/// <summary>
+/// Fixed grid of frequencies for batch frequency response evaluation
+///
+/// The cosine and sine tables for the grid are computed once, when the grid is set, so that
+/// evaluating the magnitude response of a cascade costs only multiply-adds per section and
+/// frequency plus one logarithm per frequency. The loops run across the frequencies of the grid
+/// and are written to be vectorized by the compiler.
+/// </summary>
+class FreqGrid
+{
+public:
+	FreqGrid();
+	~FreqGrid() {}
+
+	/// <summary>
+	/// Set grid to an arbitrary list of frequencies
+	/// </summary>
+	/// <param name="freqs">array of frequencies (Hz)</param>
+	/// <param name="numfreqs">number of frequencies</param>
+	/// <param name="fs">sampling frequency (Hz)</param>
+	void setgrid(const double* freqs, int numfreqs, double fs);
+
+	/// <summary>
+	/// Set grid to logarithmically spaced frequencies
+	/// </summary>
+	/// <param name="fmin">lowest frequency (Hz)</param>
+	/// <param name="fmax">highest frequency (Hz)</param>
+	/// <param name="numfreqs">number of frequencies</param>
+	/// <param name="fs">sampling frequency (Hz)</param>
+	void setloggrid(double fmin, double fmax, int numfreqs, double fs);
+
+	/// <summary>
+	/// Get number of frequencies in the grid
+	/// </summary>
+	/// <returns>number of frequencies</returns>
+	int getnumfreqs() const { return int(freqs.size()); }
+
+	/// <summary>
+	/// Get grid frequencies
+	/// </summary>
+	/// <returns>pointer to first frequency (Hz)</returns>
+	const double* getfreqs() const { return freqs.data(); }
+
+	/// <summary>
+	/// Get sampling frequency of the grid
+	/// </summary>
+	/// <returns>sampling frequency (Hz)</returns>
+	double getsamprate() const { return sampRate; }
+
+	/// <summary>
+	/// Evaluate the frequency response of a cascade of second order sections
+	///
+	/// The output arrays must hold getnumfreqs() values. Phase and group delay are optional;
+	/// pass nullptr to skip them, which leaves only multiply-adds in the section loop.
+	/// The grid itself is not changed, so one grid may be shared by any number of threads. The
+	/// phase is accumulated in the scratch arrays passed in; without them, every call that asks
+	/// for the phase allocates arrays of its own.
+	/// </summary>
+	/// <param name="sects">array of sections</param>
+	/// <param name="numsects">number of sections</param>
+	/// <param name="magdB">magnitude of frequency response (dB) (output)</param>
+	/// <param name="phase">phase of frequency response, wrapped to (-pi, pi] (radians) (output)</param>
+	/// <param name="grpdelay">group delay (samples) (output)</param>
+	/// <param name="scratch">scratch arrays for the phase (nullptr to allocate them)</param>
+	void cascaderesp(const BQfilter* sects, int numsects, double* magdB, double* phase = nullptr, double* grpdelay = nullptr,
+		FreqScratch* scratch = nullptr) const;
+
+private:
+	void settables();
+
+	double sampRate;
+	std::vector<double> freqs;
+	// cos(theta), cos(2 theta), sin(theta), sin(2 theta) at each grid frequency
+	std::vector<double> cos1, cos2, sin1, sin2;
+};
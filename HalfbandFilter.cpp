@@ -0,0 +1,124 @@
+/*
+  ==============================================================================
+
+    HalfbandFilter.cpp
+
+  ==============================================================================
+*/
+
+#include "HalfbandFilter.h"
+#include "DSPkernels.h"
+#include <algorithm>
+#include <cmath>
+
+// Low rate samples per pass
+constexpr int HBCHUNK = 128;
+// Kaiser window parameter, for about 80 dB of stopband attenuation
+constexpr double HBKAISERBETA = 8.0;
+
+// Modified Bessel function of the first kind, order zero, by its power series
+static double besseli0(double x)
+{
+	double sum = 1.0;
+	double term = 1.0;
+	for (int k = 1; k < 50; k++)
+	{
+		term *= (x / (2.0 * k)) * (x / (2.0 * k));
+		sum += term;
+		if (term < 1e-17 * sum)
+			break;
+	}
+	return sum;
+}
+
+double kaiserwindow(double r, double beta)
+{
+	return besseli0(beta * std::sqrt(std::max(0.0, 1.0 - r * r))) / besseli0(beta);
+}
+
+HalfbandFilter::HalfbandFilter()
+{
+	init(16);
+}
+
+void HalfbandFilter::init(int halflength)
+{
+	this->halflength = halflength > 0 ? halflength : 1;
+	const int M = this->halflength;
+	const int numtaps = 2 * M;
+	const double pi = 3.141592653589793238463;
+
+	// Branch coefficient k is tap j = 2k - (2M - 1) of the half-band filter, whose odd taps
+	// are sin(pi j / 2) / (pi j), scaled by 2 for the zeros that upsampling inserts
+	coefs.resize(numtaps);
+	double sum = 0.0;
+	for (int k = 0; k < numtaps; k++)
+	{
+		const int j = 2 * k - (2 * M - 1);
+		const double r = double(j) / (2.0 * M);
+		coefs[k] = 2.0 * std::sin(pi * j / 2.0) / (pi * j) * kaiserwindow(r, HBKAISERBETA);
+		sum += coefs[k];
+	}
+	// unity gain at DC
+	halfcoefs.resize(numtaps);
+	for (int k = 0; k < numtaps; k++)
+	{
+		coefs[k] /= sum;
+		halfcoefs[k] = 0.5 * coefs[k];
+	}
+
+	firin.resize(numtaps - 1 + HBCHUNK);
+	delayin.resize(M + HBCHUNK);
+	firout.resize(HBCHUNK);
+	reset();
+}
+
+void HalfbandFilter::upsample(const double* insamples, double* outsamples, int numsamples)
+{
+	const DSPkernels& kernels = getkernels();
+	const int M = halflength;
+	const int H = 2 * M - 1;
+	for (int start = 0; start < numsamples; start += HBCHUNK)
+	{
+		const int len = numsamples - start < HBCHUNK ? numsamples - start : HBCHUNK;
+		std::copy(insamples + start, insamples + start + len, &firin[H]);
+		kernels.fir(&firin[H], coefs.data(), 2 * M, firout.data(), len);
+		// even outputs from the FIR branch, odd outputs from the center tap
+		double* out = outsamples + 2 * start;
+		for (int n = 0; n < len; n++)
+		{
+			out[2 * n] = firout[n];
+			out[2 * n + 1] = firin[M + n];
+		}
+		std::copy(&firin[len], &firin[len + H], firin.begin());
+	}
+}
+
+void HalfbandFilter::downsample(const double* insamples, double* outsamples, int numsamples)
+{
+	const DSPkernels& kernels = getkernels();
+	const int M = halflength;
+	const int H = 2 * M - 1;
+	for (int start = 0; start < numsamples; start += HBCHUNK)
+	{
+		const int len = numsamples - start < HBCHUNK ? numsamples - start : HBCHUNK;
+		// even samples feed the FIR branch, odd samples the center tap
+		const double* in = insamples + 2 * start;
+		for (int n = 0; n < len; n++)
+		{
+			firin[H + n] = in[2 * n];
+			delayin[M + n] = in[2 * n + 1];
+		}
+		kernels.fir(&firin[H], halfcoefs.data(), 2 * M, firout.data(), len);
+		for (int n = 0; n < len; n++)
+			outsamples[start + n] = firout[n] + 0.5 * delayin[n];
+		std::copy(&firin[len], &firin[len + H], firin.begin());
+		std::copy(&delayin[len], &delayin[len + M], delayin.begin());
+	}
+}
+
+void HalfbandFilter::reset()
+{
+	std::fill(firin.begin(), firin.end(), 0.0);
+	std::fill(delayin.begin(), delayin.end(), 0.0);
+}
@@ -0,0 +1,85 @@
+/*
+  ==============================================================================
+
+    HalfbandFilter.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <vector>
+
+/// <summary>
+/// Kaiser window, as used by the half-band and resampling filters
+/// </summary>
+/// <param name="r">position, from -1 at the first coefficient to 1 at the last</param>
+/// <param name="beta">window parameter (larger for more stopband attenuation)</param>
+/// <returns>window value (1 at the center)</returns>
+double kaiserwindow(double r, double beta);
+
+/// <summary>
+/// Polyphase half-band FIR filter for upsampling or downsampling by two
+///
+/// The filter is a Kaiser windowed sinc with its cutoff at a quarter of the high sampling
+/// rate, so every second coefficient is zero except the center one, which is 1/2. In
+/// polyphase form one branch holds all the nonzero side coefficients and the other is a pure
+/// delay: upsampling computes one FIR output per input sample and copies the other, and
+/// downsampling filters only the even samples and adds half of a delayed odd sample. The FIR
+/// branch runs in the DSPkernels::fir kernel.
+///
+/// An object keeps the history of one stream, so it is used either for upsampling or for
+/// downsampling.
+/// </summary>
+class HalfbandFilter
+{
+public:
+	HalfbandFilter();
+	~HalfbandFilter() {}
+
+	/// <summary>
+	/// Design the filter
+	///
+	/// With a half length of 16 (63 taps) the stopband attenuation is about 80 dB and the
+	/// passband extends to 0.21 of the high sampling rate; shorter filters have a wider
+	/// transition band. The history is cleared.
+	/// </summary>
+	/// <param name="halflength">number of nonzero coefficients on each side of the center</param>
+	void init(int halflength);
+
+	/// <summary>
+	/// Get delay of the filter
+	/// </summary>
+	/// <returns>delay in samples at the high sampling rate</returns>
+	int getlatency() const { return 2 * halflength - 1; }
+
+	/// <summary>
+	/// Upsample a block by two
+	/// </summary>
+	/// <param name="insamples">pointer to first input sample</param>
+	/// <param name="outsamples">pointer to first of 2 * numsamples output samples</param>
+	/// <param name="numsamples">number of input samples</param>
+	void upsample(const double* insamples, double* outsamples, int numsamples);
+
+	/// <summary>
+	/// Downsample a block by two
+	/// </summary>
+	/// <param name="insamples">pointer to first of 2 * numsamples input samples</param>
+	/// <param name="outsamples">pointer to first output sample</param>
+	/// <param name="numsamples">number of output samples</param>
+	void downsample(const double* insamples, double* outsamples, int numsamples);
+
+	/// <summary>
+	/// Clear history
+	/// </summary>
+	void reset();
+
+private:
+	int halflength;
+	std::vector<double> coefs; // FIR branch, scaled for upsampling (gain 2)
+	std::vector<double> halfcoefs; // FIR branch for downsampling
+	// low rate input of the FIR branch and of the delay branch, each after its history
+	std::vector<double> firin;
+	std::vector<double> delayin;
+	std::vector<double> firout;
+};
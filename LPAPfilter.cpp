@@ -1,52 +1,179 @@
-/*
-  ==============================================================================
-
-    LPAPfilter.cpp
-    Created: 5 Aug 2020 9:23:43am
-    Author:  profw
-
-  ==============================================================================
-*/
-
-#include "LPAPfilter.h"
-
-LPAPfilter::LPAPfilter()
-{
-    damping = 0.0;
-    reflection = 0.0;
-    oldest = 0;
-    xprev = 0.0f;
-    yprev = 0.0f;
-}
-
-void LPAPfilter::setdelay(int delay)
-{
-    xbuffer.resize(delay, 0.0f);
-    ybuffer.resize(delay, 0.0f);
-    if (oldest >= delay)
-        oldest = 0;
-}
-
-void LPAPfilter::reset()
-{
-    for (auto n = 0; n < xbuffer.size(); n++)
-    {
-        xbuffer[n] = 0.0f;
-        ybuffer[n] = 0.0f;
-    }
-    oldest = 0;
-    xprev = 0.0f;
-    yprev = 0.0f;
-}
-
-double LPAPfilter::step(double sample)
-{
-    float outsample = damping * yprev + reflection * (1.0 - damping) * ybuffer[oldest] - reflection * sample 
-        + reflection * damping * xprev + (1 - damping) * xbuffer[oldest];
-    yprev = outsample;
-    xprev = sample;
-    xbuffer[oldest] = sample;
-    ybuffer[oldest] = outsample;
-    oldest = ++oldest % xbuffer.size();
-    return outsample;
-}
+/*
+  ==============================================================================
+
+    LPAPfilter.cpp
+    Created: 5 Aug 2020 9:23:43am
+    Author:  profw
+
+  ==============================================================================
+*/
+
+#include "LPAPfilter.h"
+#include "DSPkernels.h"
+
+template <typename T, typename C>
+LPAPfilterT<T, C>::LPAPfilterT()
+{
+    damping = 0.0;
+    reflection = 0.0;
+    xprev = 0.0f;
+    yprev = 0.0f;
+}
+
+template <typename T, typename C>
+void LPAPfilterT<T, C>::setdelay(int delay)
+{
+    xbuffer.setdelay(delay);
+    ybuffer.setdelay(delay);
+}
+
+template <typename T, typename C>
+bool LPAPfilterT<T, C>::setmaxdelay(int maxdelay, DelayArena* arena)
+{
+    const unsigned int D = maxdelay > 0 ? unsigned(maxdelay) : 1;
+    if (arena && arena->getsize() - arena->getused() < 2 * DelayArena::bytesfor<T>(D))
+        return false;
+    return xbuffer.reserve(D, arena) && ybuffer.reserve(D, arena);
+}
+
+template <typename T, typename C>
+void LPAPfilterT<T, C>::reset()
+{
+    xbuffer.clear();
+    ybuffer.clear();
+    xprev = 0.0f;
+    yprev = 0.0f;
+}
+
+template <typename T, typename C>
+C LPAPfilterT<T, C>::step(C sample)
+{
+    T outsample = T(damping * C(yprev) + reflection * (C(1) - damping) * C(ybuffer.read()) - reflection * sample
+        + reflection * damping * C(xprev) + (C(1) - damping) * C(xbuffer.read()));
+    yprev = outsample;
+    xprev = T(sample);
+    xbuffer.write(T(sample));
+    ybuffer.write(outsample);
+    return outsample;
+}
+
+template <typename T, typename C>
+template <typename SampleType>
+void LPAPfilterT<T, C>::procsamples(const SampleType* insamples, SampleType* outsamples, int numsamples)
+{
+    // Chunks are no longer than the delay, so a chunk is written after its delayed samples
+    // have been read
+    T xdelayed[RINGCHUNK];
+    T ydelayed[RINGCHUNK];
+    T xwritten[RINGCHUNK];
+    T ywritten[RINGCHUNK];
+    const unsigned int maxlen = xbuffer.getdelay() < RINGCHUNK ? xbuffer.getdelay() : RINGCHUNK;
+    T xp = xprev;
+    T yp = yprev;
+    for (int start = 0; start < numsamples; start += maxlen)
+    {
+        unsigned int len = unsigned(numsamples - start) < maxlen ? unsigned(numsamples - start) : maxlen;
+        xbuffer.readblock(xdelayed, len);
+        ybuffer.readblock(ydelayed, len);
+        for (unsigned int n = 0; n < len; n++)
+        {
+            // same expression as step()
+            C sample = C(insamples[start + n]);
+            T outsample = T(damping * C(yp) + reflection * (C(1) - damping) * C(ydelayed[n]) - reflection * sample
+                + reflection * damping * C(xp) + (C(1) - damping) * C(xdelayed[n]));
+            yp = outsample;
+            xp = T(sample);
+            xwritten[n] = xp;
+            ywritten[n] = outsample;
+            outsamples[start + n] = SampleType(outsample);
+        }
+        xbuffer.writeblock(xwritten, len);
+        ybuffer.writeblock(ywritten, len);
+    }
+    xprev = xp;
+    yprev = yp;
+}
+
+// Single precision samples with double precision arithmetic run in the dispatched kernel
+template <>
+template <>
+void LPAPfilterT<float, double>::procsamples(const float* insamples, float* outsamples, int numsamples)
+{
+    const DSPkernels& kernels = getkernels();
+    float xdelayed[RINGCHUNK];
+    float ydelayed[RINGCHUNK];
+    const unsigned int maxlen = xbuffer.getdelay() < RINGCHUNK ? xbuffer.getdelay() : RINGCHUNK;
+    float xp = xprev;
+    float yp = yprev;
+    for (int start = 0; start < numsamples; start += maxlen)
+    {
+        unsigned int len = unsigned(numsamples - start) < maxlen ? unsigned(numsamples - start) : maxlen;
+        xbuffer.readblock(xdelayed, len);
+        ybuffer.readblock(ydelayed, len);
+        // inputs go in before the outputs overwrite them (for in-place processing)
+        xbuffer.writeblock(insamples + start, len);
+        kernels.allpassfilter(xdelayed, ydelayed, insamples + start, outsamples + start, int(len), damping,
+            reflection, &xp, &yp);
+        ybuffer.writeblock(outsamples + start, len);
+    }
+    xprev = xp;
+    yprev = yp;
+}
+
+template <typename T, typename C>
+void LPAPfilterT<T, C>::procblock(const float* insamples, float* outsamples, int numsamples)
+{
+    procsamples(insamples, outsamples, numsamples);
+}
+
+template <typename T, typename C>
+void LPAPfilterT<T, C>::procblock(const double* insamples, double* outsamples, int numsamples)
+{
+    procsamples(insamples, outsamples, numsamples);
+}
+
+template <typename T, typename C>
+void LPAPfilterT<T, C>::savestate(SnapshotWriter& writer) const
+{
+    writer.begin(snapshottag("LPAP"));
+    writer.put(std::uint32_t(sizeof(T)));
+    writer.put(std::uint32_t(sizeof(C)));
+    writer.put(damping);
+    writer.put(reflection);
+    writer.put(xprev);
+    writer.put(yprev);
+    writer.end();
+    xbuffer.savestate(writer);
+    ybuffer.savestate(writer);
+}
+
+template <typename T, typename C>
+bool LPAPfilterT<T, C>::loadstate(SnapshotReader& reader)
+{
+    std::uint32_t sizes[2];
+    C damp = 0, refl = 0;
+    T x = 0, y = 0;
+    if (!reader.begin(snapshottag("LPAP")) || !reader.get(sizes[0]) || !reader.get(sizes[1]) || sizes[0] != sizeof(T)
+        || sizes[1] != sizeof(C))
+        return false;
+    reader.get(damp);
+    reader.get(refl);
+    reader.get(x);
+    reader.get(y);
+    // Both buffers are read before either is restored, so a failed load leaves the filter unchanged
+    typename RingBuffer<T>::SavedRing xsaved, ysaved;
+    if (!reader.end() || !RingBuffer<T>::readstate(reader, xsaved) || !RingBuffer<T>::readstate(reader, ysaved)
+        || !xbuffer.canrestore(xsaved) || !ybuffer.canrestore(ysaved))
+        return false;
+    xbuffer.restorestate(xsaved);
+    ybuffer.restorestate(ysaved);
+    damping = damp;
+    reflection = refl;
+    xprev = x;
+    yprev = y;
+    return true;
+}
+
+template class LPAPfilterT<float>;
+template class LPAPfilterT<double>;
+template class LPAPfilterT<float, double>;
@@ -1,63 +1,134 @@
-/*
-  ==============================================================================
-
-    LPAPfilter.h
-    Created: 5 Aug 2020 9:23:43am
-    Author:  profw
-
-  ==============================================================================
-*/
-
-#pragma once
-
-#include <vector>
-/// <summary>
-/// This class implements a low pass all pass filter
-/// 
-/// Filter transfer function: h(z) = (-R + Rdz^{-1} + (1 - d)z^{-N})/(1 - dz^{-1} - R(1 - d)z^{-N})
-/// </summary>
-class LPAPfilter
-{
-public:
-    LPAPfilter();
-    ~LPAPfilter() {}
-
-    /// <summary>
-    /// Set damping parameter
-    /// </summary>
-    /// <param name="damp">damping parameter (no units)</param>
-    void setdamping(double damp) { damping = damp; }
-
-    /// <summary>
-    /// Set reflection parameter
-    /// </summary>
-    /// <param name="R">reflection parameter (no units)</param>
-    void setreflection(double R) { reflection = R; }
-
-    /// <summary>
-    /// Set sample delay
-    /// </summary>
-    /// <param name="delay">delay in samples</param>
-    void setdelay(int delay);
-
-    /// <summary>
-    /// Clear buffer and reset state variables
-    /// </summary>
-    void reset();
-
-    /// <summary>
-    /// Step filter through one sample period
-    /// </summary>
-    /// <param name="sample">input sample</param>
-    /// <returns>output sample</returns>
-    double step(double sample);
-
-private:
-    double damping;
-    double reflection;
-    std::vector<float> xbuffer;
-    std::vector<float> ybuffer;
-    unsigned int oldest;
-    float xprev;
-    float yprev;
-};
\ No newline at end of file
+/*
+  ==============================================================================
+
+    LPAPfilter.h
+    Created: 5 Aug 2020 9:23:43am
+    Author:  profw
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <vector>
+#include "RingBuffer.h"
+/// <summary>
+/// This class implements a low pass all pass filter
+/// 
+/// Filter transfer function: h(z) = (-R + Rdz^{-1} + (1 - d)z^{-N})/(1 - dz^{-1} - R(1 - d)z^{-N})
+///
+/// The template parameters are the type of the samples held in the delay lines (T) and of the
+/// parameters and the recursion (C, by default the same as T). LPAPfilter keeps single
+/// precision samples and computes in double precision.
+/// </summary>
+template <typename T, typename C = T>
+class LPAPfilterT
+{
+public:
+    LPAPfilterT();
+    ~LPAPfilterT() {}
+
+    /// <summary>
+    /// Set damping parameter
+    /// </summary>
+    /// <param name="damp">damping parameter (no units)</param>
+    void setdamping(double damp) { damping = C(damp); }
+
+    /// <summary>
+    /// Set reflection parameter
+    /// </summary>
+    /// <param name="R">reflection parameter (no units)</param>
+    void setreflection(double R) { reflection = C(R); }
+
+    /// <summary>
+    /// Set sample delay
+    ///
+    /// Once the storage comes from a DelayArena, the delay is limited to the maximum given to
+    /// setmaxdelay() and nothing is allocated.
+    /// </summary>
+    /// <param name="delay">delay in samples</param>
+    void setdelay(int delay);
+
+    /// <summary>
+    /// Reserve storage for a maximum delay
+    ///
+    /// The two delay lines take two regions of the arena.
+    /// </summary>
+    /// <param name="maxdelay">maximum delay in samples</param>
+    /// <param name="arena">arena to take the storage from (nullptr to allocate it)</param>
+    /// <returns>false if the arena does not have enough room left</returns>
+    bool setmaxdelay(int maxdelay, DelayArena* arena = nullptr);
+
+    /// <summary>
+    /// Clear buffer and reset state variables
+    /// </summary>
+    void reset();
+
+    /// <summary>
+    /// Write the parameters, state variables and buffer contents to a snapshot
+    /// </summary>
+    /// <param name="writer">snapshot</param>
+    void savestate(SnapshotWriter& writer) const;
+
+    /// <summary>
+    /// Restore everything written by savestate()
+    ///
+    /// The buffers grow if they must to hold the saved delay (see RingBuffer::loadstate()).
+    /// If any record does not match, the filter is left unchanged.
+    /// </summary>
+    /// <param name="reader">snapshot</param>
+    /// <returns>false if the next records are not a filter of this type</returns>
+    bool loadstate(SnapshotReader& reader);
+
+    /// <summary>
+    /// Step filter through one sample period
+    /// </summary>
+    /// <param name="sample">input sample</param>
+    /// <returns>output sample</returns>
+    C step(C sample);
+
+    /// <summary>
+    /// Process a block of samples
+    /// </summary>
+    /// <param name="insamples">pointer to first input sample</param>
+    /// <param name="outsamples">pointer to first output sample (may be the same as insamples)</param>
+    /// <param name="numsamples">number of samples in the block</param>
+    void procblock(const float* insamples, float* outsamples, int numsamples);
+
+    /// <summary>
+    /// Process a block of double precision samples
+    /// </summary>
+    /// <param name="insamples">pointer to first input sample</param>
+    /// <param name="outsamples">pointer to first output sample (may be the same as insamples)</param>
+    /// <param name="numsamples">number of samples in the block</param>
+    void procblock(const double* insamples, double* outsamples, int numsamples);
+
+    /// <summary>
+    /// Process a block of samples in place
+    /// 
+    /// Note: this method modifies the input samples - they become the output samples.
+    /// </summary>
+    /// <param name="samples">pointer to first audio sample</param>
+    /// <param name="numsamples">number of samples in the block</param>
+    void procblock(float* samples, int numsamples) { procblock(samples, samples, numsamples); }
+
+    /// <summary>
+    /// Process a block of double precision samples in place
+    /// </summary>
+    /// <param name="samples">pointer to first audio sample</param>
+    /// <param name="numsamples">number of samples in the block</param>
+    void procblock(double* samples, int numsamples) { procblock(samples, samples, numsamples); }
+
+private:
+    template <typename SampleType>
+    void procsamples(const SampleType* insamples, SampleType* outsamples, int numsamples);
+
+    C damping;
+    C reflection;
+    RingBuffer<T> xbuffer;
+    RingBuffer<T> ybuffer;
+    T xprev;
+    T yprev;
+};
+
+typedef LPAPfilterT<float, double> LPAPfilter;
\ No newline at end of file
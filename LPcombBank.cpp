@@ -0,0 +1,142 @@
+/*
+  ==============================================================================
+
+    LPcombBank.cpp
+
+  ==============================================================================
+*/
+
+#include "LPcombBank.h"
+#include "DSPkernels.h"
+#include <algorithm>
+#include <cstring>
+
+// Frames are padded to a multiple of the widest lane vector (AVX-512); unused lanes have zero
+// feedback and are never summed.
+constexpr int COMBLANES = 8;
+// Samples per pass of procblock
+constexpr int COMBCHUNK = 64;
+
+LPcombBank::LPcombBank()
+{
+    numcombs = 0;
+    width = 0;
+    mindelay = 1;
+    mask = 0;
+    writepos = 0;
+}
+
+void LPcombBank::setnumcombs(int numcombs)
+{
+    this->numcombs = numcombs;
+    width = (numcombs + COMBLANES - 1) / COMBLANES * COMBLANES;
+    for (auto* v : { &damping, &reflection, &feedback, &state })
+        v->assign(width, 0.0);
+    delays.assign(width, 1);
+    mindelay = 1;
+    frames.assign(width, 0.0f);
+    mask = 0;
+    writepos = 0;
+    delayed.assign(std::size_t(COMBCHUNK) * width, 0.0);
+    combout.assign(std::size_t(COMBCHUNK) * width, 0.0f);
+}
+
+void LPcombBank::setdamping(int comb, double damp)
+{
+    damping[comb] = damp;
+    updatefeedback(comb);
+}
+
+void LPcombBank::setreflection(int comb, double R)
+{
+    reflection[comb] = R;
+    updatefeedback(comb);
+}
+
+void LPcombBank::updatefeedback(int comb)
+{
+    // same product as LPcombfilter::step()
+    feedback[comb] = reflection[comb] * (1.0 - damping[comb]);
+}
+
+void LPcombBank::setdelay(int comb, int delay)
+{
+    delays[comb] = delay > 0 ? unsigned(delay) : 1;
+    mindelay = *std::min_element(delays.begin(), delays.begin() + numcombs);
+    unsigned int capacity = mask + 1;
+    if (delays[comb] <= capacity)
+        return;
+    while (capacity < delays[comb])
+        capacity <<= 1;
+
+    // keep the frames in the same order relative to the write position
+    std::vector<float> newframes(std::size_t(capacity) * width, 0.0f);
+    unsigned int oldsize = mask + 1;
+    for (unsigned int k = 1; k <= oldsize; k++)
+        std::memcpy(&newframes[std::size_t((oldsize - k) & (capacity - 1)) * width],
+            &frames[std::size_t((writepos - k) & mask) * width], width * sizeof(float));
+    frames.swap(newframes);
+    mask = capacity - 1;
+    writepos = oldsize & mask;
+}
+
+void LPcombBank::processchunk(const double* in, double* out, int numsamples)
+{
+    const DSPkernels& kernels = getkernels();
+
+    // gather each comb's delayed samples from its lane of earlier frames
+    for (int comb = 0; comb < numcombs; comb++)
+    {
+        unsigned int pos = (writepos - delays[comb]) & mask;
+        int first = int(mask + 1 - pos) < numsamples ? int(mask + 1 - pos) : numsamples;
+        const float* src = &frames[std::size_t(pos) * width + comb];
+        double* dest = &delayed[comb];
+        for (int n = 0; n < first; n++)
+            dest[n * width] = src[n * width];
+        src = &frames[comb];
+        dest += first * width;
+        for (int n = 0; n < numsamples - first; n++)
+            dest[n * width] = src[n * width];
+    }
+
+    const double* coefs[2] = { damping.data(), feedback.data() };
+    kernels.combbank(delayed.data(), combout.data(), numsamples, numcombs, width, coefs, state.data(), in, out);
+
+    // the new frames are written whole
+    unsigned int pos = writepos & mask;
+    int first = int(mask + 1 - pos) < numsamples ? int(mask + 1 - pos) : numsamples;
+    std::memcpy(&frames[std::size_t(pos) * width], combout.data(), first * width * sizeof(float));
+    std::memcpy(frames.data(), &combout[std::size_t(first) * width], (numsamples - first) * width * sizeof(float));
+    writepos += unsigned(numsamples);
+}
+
+double LPcombBank::step(double sample)
+{
+    double out;
+    processchunk(&sample, &out, 1);
+    return out;
+}
+
+void LPcombBank::procblock(const float* insamples, float* outsamples, int numsamples)
+{
+    // Chunks are no longer than the shortest delay, so a chunk's output is written after its
+    // delayed samples have been read
+    const DSPkernels& kernels = getkernels();
+    double in[COMBCHUNK];
+    double out[COMBCHUNK];
+    const int maxlen = mindelay < unsigned(COMBCHUNK) ? int(mindelay) : COMBCHUNK;
+    for (int start = 0; start < numsamples; start += maxlen)
+    {
+        int len = numsamples - start < maxlen ? numsamples - start : maxlen;
+        kernels.floattodouble(insamples + start, in, len);
+        processchunk(in, out, len);
+        kernels.doubletofloat(out, outsamples + start, len);
+    }
+}
+
+void LPcombBank::reset()
+{
+    std::fill(frames.begin(), frames.end(), 0.0f);
+    std::fill(state.begin(), state.end(), 0.0);
+    writepos = 0;
+}
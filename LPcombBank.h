@@ -0,0 +1,115 @@
+/*
+  ==============================================================================
+
+    LPcombBank.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <vector>
+
+/// <summary>
+/// Bank of low pass feedback comb filters in parallel, with a common input and summed outputs
+///
+/// Each comb has its own delay, damping and reflection parameters and follows exactly the
+/// recursion of LPcombfilter::step(), so the output equals the sum of the outputs of separate
+/// LPcombfilters (added in comb order). The combs run side by side in SIMD lanes: all delay
+/// lines share one buffer of interleaved frames, one sample of every comb per frame, so each
+/// sample period writes a single frame and each comb gathers its delayed sample from an
+/// earlier frame.
+/// </summary>
+class LPcombBank
+{
+public:
+    LPcombBank();
+    ~LPcombBank() {}
+
+    /// <summary>
+    /// Set number of combs
+    ///
+    /// The bank is cleared, and new combs have zero damping, reflection and a delay of one
+    /// sample.
+    /// </summary>
+    /// <param name="numcombs">number of combs</param>
+    void setnumcombs(int numcombs);
+
+    /// <summary>
+    /// Get number of combs
+    /// </summary>
+    /// <returns>number of combs</returns>
+    int getnumcombs() const { return numcombs; }
+
+    /// <summary>
+    /// Set damping parameter of one comb
+    /// </summary>
+    /// <param name="comb">comb number</param>
+    /// <param name="damp">damping parameter (no units)</param>
+    void setdamping(int comb, double damp);
+
+    /// <summary>
+    /// Set reflection parameter of one comb
+    /// </summary>
+    /// <param name="comb">comb number</param>
+    /// <param name="R">reflection parameter (no units)</param>
+    void setreflection(int comb, double R);
+
+    /// <summary>
+    /// Set sample delay of one comb
+    ///
+    /// Samples already in the delay lines are kept.
+    /// </summary>
+    /// <param name="comb">comb number</param>
+    /// <param name="delay">delay in samples (at least 1)</param>
+    void setdelay(int comb, int delay);
+
+    /// <summary>
+    /// Step filters through one sample period
+    /// </summary>
+    /// <param name="sample">audio sample</param>
+    /// <returns>sum of the comb outputs</returns>
+    double step(double sample);
+
+    /// <summary>
+    /// Process a block of samples
+    /// </summary>
+    /// <param name="insamples">pointer to first input sample</param>
+    /// <param name="outsamples">pointer to first output sample (may be the same as insamples)</param>
+    /// <param name="numsamples">number of samples in the block</param>
+    void procblock(const float* insamples, float* outsamples, int numsamples);
+
+    /// <summary>
+    /// Process a block of samples in place
+    ///
+    /// Note: this method modifies the input samples - they become the output samples.
+    /// </summary>
+    /// <param name="samples">pointer to first audio sample</param>
+    /// <param name="numsamples">number of samples in the block</param>
+    void procblock(float* samples, int numsamples) { procblock(samples, samples, numsamples); }
+
+    /// <summary>
+    /// Clear delay lines and reset state variables
+    /// </summary>
+    void reset();
+
+private:
+    void processchunk(const double* in, double* out, int numsamples);
+    void updatefeedback(int comb);
+
+    int numcombs;
+    int width; // lanes per frame
+    std::vector<double> damping;
+    std::vector<double> reflection;
+    std::vector<double> feedback;
+    std::vector<double> state;
+    std::vector<unsigned int> delays;
+    unsigned int mindelay;
+    // capacity frames of width samples; the capacity is a power of two
+    std::vector<float> frames;
+    unsigned int mask;
+    unsigned int writepos;
+    // delayed samples and outputs of the combs for one chunk, in frames
+    std::vector<double> delayed;
+    std::vector<float> combout;
+};
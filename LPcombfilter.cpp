@@ -1,43 +1,130 @@
-/*
-  ==============================================================================
-
-    LPcombfilter.cpp
-    Created: 28 Jul 2020 10:36:40am
-    Author:  profw
-
-  ==============================================================================
-*/
-
-#include "LPcombfilter.h"
-
-LPcombfilter::LPcombfilter()
-{
-    damping = 0.0;
-    reflection = 0.0;
-    oldest = 0;
-    state = 0.0;
-}
-
-void LPcombfilter::setdelay(int delay)
-{
-    buffer.resize(delay, 0.0);
-    if (oldest >= buffer.size())
-        oldest = 0;
-}
-
-double LPcombfilter::step(double sample)
-{
-    state = damping * state + reflection * (1.0 - damping) * buffer[oldest];
-    float outsample = state + sample;
-    buffer[oldest] = outsample;
-    oldest = ++oldest % buffer.size();
-    return outsample;
-}
-
-void LPcombfilter::reset()
-{
-    for (auto& sample : buffer)
-        sample = 0.0f;
-    oldest = 0;
-    state = 0.0;
-}
+/*
+  ==============================================================================
+
+    LPcombfilter.cpp
+    Created: 28 Jul 2020 10:36:40am
+    Author:  profw
+
+  ==============================================================================
+*/
+
+#include "LPcombfilter.h"
+#include "DSPkernels.h"
+
+template <typename T, typename C>
+LPcombfilterT<T, C>::LPcombfilterT()
+{
+    damping = 0.0;
+    reflection = 0.0;
+    state = 0.0;
+}
+
+template <typename T, typename C>
+void LPcombfilterT<T, C>::setdelay(int delay)
+{
+    buffer.setdelay(delay);
+}
+
+template <typename T, typename C>
+C LPcombfilterT<T, C>::step(C sample)
+{
+    state = damping * state + reflection * (C(1) - damping) * C(buffer.read());
+    T outsample = T(state + sample);
+    buffer.write(outsample);
+    return outsample;
+}
+
+template <typename T, typename C>
+template <typename SampleType>
+void LPcombfilterT<T, C>::procsamples(const SampleType* insamples, SampleType* outsamples, int numsamples)
+{
+    // Chunks are no longer than the delay, so a chunk's output is written after its delayed
+    // samples have been read
+    T delayed[RINGCHUNK];
+    T written[RINGCHUNK];
+    const unsigned int maxlen = buffer.getdelay() < RINGCHUNK ? buffer.getdelay() : RINGCHUNK;
+    const C feedback = reflection * (C(1) - damping);
+    C st = state;
+    for (int start = 0; start < numsamples; start += maxlen)
+    {
+        unsigned int len = unsigned(numsamples - start) < maxlen ? unsigned(numsamples - start) : maxlen;
+        buffer.readblock(delayed, len);
+        for (unsigned int n = 0; n < len; n++)
+        {
+            st = damping * st + feedback * C(delayed[n]);
+            written[n] = T(st + C(insamples[start + n]));
+            outsamples[start + n] = SampleType(written[n]);
+        }
+        buffer.writeblock(written, len);
+    }
+    state = st;
+}
+
+// Single precision samples with double precision arithmetic run in the dispatched kernel
+template <>
+template <>
+void LPcombfilterT<float, double>::procsamples(const float* insamples, float* outsamples, int numsamples)
+{
+    const DSPkernels& kernels = getkernels();
+    float delayed[RINGCHUNK];
+    const unsigned int maxlen = buffer.getdelay() < RINGCHUNK ? buffer.getdelay() : RINGCHUNK;
+    const double feedback = reflection * (1.0 - damping);
+    double st = state;
+    for (int start = 0; start < numsamples; start += maxlen)
+    {
+        unsigned int len = unsigned(numsamples - start) < maxlen ? unsigned(numsamples - start) : maxlen;
+        buffer.readblock(delayed, len);
+        kernels.combfilter(delayed, insamples + start, outsamples + start, int(len), damping, feedback, &st);
+        buffer.writeblock(outsamples + start, len);
+    }
+    state = st;
+}
+
+template <typename T, typename C>
+void LPcombfilterT<T, C>::procblock(const float* insamples, float* outsamples, int numsamples)
+{
+    procsamples(insamples, outsamples, numsamples);
+}
+
+template <typename T, typename C>
+void LPcombfilterT<T, C>::procblock(const double* insamples, double* outsamples, int numsamples)
+{
+    procsamples(insamples, outsamples, numsamples);
+}
+
+template <typename T, typename C>
+void LPcombfilterT<T, C>::reset()
+{
+    buffer.clear();
+    state = 0.0;
+}
+
+template <typename T, typename C>
+void LPcombfilterT<T, C>::savestate(SnapshotWriter& writer) const
+{
+    writer.begin(snapshottag("COMB"));
+    writer.put(std::uint32_t(sizeof(C)));
+    writer.put(damping);
+    writer.put(reflection);
+    writer.put(state);
+    writer.end();
+    buffer.savestate(writer);
+}
+
+template <typename T, typename C>
+bool LPcombfilterT<T, C>::loadstate(SnapshotReader& reader)
+{
+    std::uint32_t size;
+    C damp, refl, st;
+    if (!reader.begin(snapshottag("COMB")) || !reader.get(size) || size != sizeof(C) || !reader.get(damp)
+        || !reader.get(refl) || !reader.get(st) || !reader.end() || !buffer.loadstate(reader))
+        return false;
+    damping = damp;
+    reflection = refl;
+    state = st;
+    return true;
+}
+
+template class LPcombfilterT<float>;
+template class LPcombfilterT<double>;
+template class LPcombfilterT<float, double>;
@@ -1,62 +1,133 @@
-/*
-  ==============================================================================
-
-    LPcombfilter.h
-    Created: 28 Jul 2020 10:36:40am
-    Author:  profw
-
-  ==============================================================================
-*/
-
-#pragma once
-
-#include <vector>
-
-/// <summary>
-/// This class implements a low pass feedback comb filter
-/// 
-/// Filter transfer function: h(z)=\frac{1-dz^{-1}}{1-dz^{-1}-R(1 - d)z^{-N}}
-/// </summary>
-class LPcombfilter
-{
-public:
-    LPcombfilter();
-    ~LPcombfilter() {}
-
-    /// <summary>
-    /// Set damping parameter
-    /// </summary>
-    /// <param name="damp">damping parameter (no units)</param>
-    void setdamping(double damp) { damping = damp; }
-
-    /// <summary>
-    /// Set reflection parameter
-    /// </summary>
-    /// <param name="R">reflection parameter (no units)</param>
-    void setreflection(double R) { reflection = R; }
-
-    /// <summary>
-    /// Set sample delay
-    /// </summary>
-    /// <param name="delay">delay in samples</param>
-    void setdelay(int delay);
-
-    /// <summary>
-    /// Step filter through one sample period
-    /// </summary>
-    /// <param name="sample">audio sample</param>
-    /// <returns>output sample</returns>
-    double step(double sample);
-
-    /// <summary>
-    /// Clear buffer and reset state variable
-    /// </summary>
-    void reset();
-
-private:
-    double damping;
-    double reflection;
-    std::vector<float> buffer;
-    unsigned int oldest;
-    double state;
-};
\ No newline at end of file
+/*
+  ==============================================================================
+
+    LPcombfilter.h
+    Created: 28 Jul 2020 10:36:40am
+    Author:  profw
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <vector>
+#include "RingBuffer.h"
+
+/// <summary>
+/// This class implements a low pass feedback comb filter
+/// 
+/// Filter transfer function: h(z)=\frac{1-dz^{-1}}{1-dz^{-1}-R(1 - d)z^{-N}}
+///
+/// The template parameters are the type of the samples held in the delay line (T) and of the
+/// parameters and the recursion (C, by default the same as T). LPcombfilter keeps single
+/// precision samples and computes in double precision.
+/// </summary>
+template <typename T, typename C = T>
+class LPcombfilterT
+{
+public:
+    LPcombfilterT();
+    ~LPcombfilterT() {}
+
+    /// <summary>
+    /// Set damping parameter
+    /// </summary>
+    /// <param name="damp">damping parameter (no units)</param>
+    void setdamping(double damp) { damping = C(damp); }
+
+    /// <summary>
+    /// Set reflection parameter
+    /// </summary>
+    /// <param name="R">reflection parameter (no units)</param>
+    void setreflection(double R) { reflection = C(R); }
+
+    /// <summary>
+    /// Set sample delay
+    ///
+    /// Once the storage comes from a DelayArena, the delay is limited to the maximum given to
+    /// setmaxdelay() and nothing is allocated.
+    /// </summary>
+    /// <param name="delay">delay in samples</param>
+    void setdelay(int delay);
+
+    /// <summary>
+    /// Reserve storage for a maximum delay
+    /// </summary>
+    /// <param name="maxdelay">maximum delay in samples</param>
+    /// <param name="arena">arena to take the storage from (nullptr to allocate it)</param>
+    /// <returns>false if the arena does not have enough room left</returns>
+    bool setmaxdelay(int maxdelay, DelayArena* arena = nullptr)
+    {
+        return buffer.reserve(maxdelay > 0 ? unsigned(maxdelay) : 1, arena);
+    }
+
+    /// <summary>
+    /// Step filter through one sample period
+    /// </summary>
+    /// <param name="sample">audio sample</param>
+    /// <returns>output sample</returns>
+    C step(C sample);
+
+    /// <summary>
+    /// Process a block of samples
+    /// </summary>
+    /// <param name="insamples">pointer to first input sample</param>
+    /// <param name="outsamples">pointer to first output sample (may be the same as insamples)</param>
+    /// <param name="numsamples">number of samples in the block</param>
+    void procblock(const float* insamples, float* outsamples, int numsamples);
+
+    /// <summary>
+    /// Process a block of double precision samples
+    /// </summary>
+    /// <param name="insamples">pointer to first input sample</param>
+    /// <param name="outsamples">pointer to first output sample (may be the same as insamples)</param>
+    /// <param name="numsamples">number of samples in the block</param>
+    void procblock(const double* insamples, double* outsamples, int numsamples);
+
+    /// <summary>
+    /// Process a block of samples in place
+    /// 
+    /// Note: this method modifies the input samples - they become the output samples.
+    /// </summary>
+    /// <param name="samples">pointer to first audio sample</param>
+    /// <param name="numsamples">number of samples in the block</param>
+    void procblock(float* samples, int numsamples) { procblock(samples, samples, numsamples); }
+
+    /// <summary>
+    /// Process a block of double precision samples in place
+    /// </summary>
+    /// <param name="samples">pointer to first audio sample</param>
+    /// <param name="numsamples">number of samples in the block</param>
+    void procblock(double* samples, int numsamples) { procblock(samples, samples, numsamples); }
+
+    /// <summary>
+    /// Clear buffer and reset state variable
+    /// </summary>
+    void reset();
+
+    /// <summary>
+    /// Write the parameters, state variable and buffer contents to a snapshot
+    /// </summary>
+    /// <param name="writer">snapshot</param>
+    void savestate(SnapshotWriter& writer) const;
+
+    /// <summary>
+    /// Restore everything written by savestate()
+    ///
+    /// The buffer grows if it must to hold the saved delay (see RingBuffer::loadstate()).
+    /// </summary>
+    /// <param name="reader">snapshot</param>
+    /// <returns>false if the next records are not a filter of this type</returns>
+    bool loadstate(SnapshotReader& reader);
+
+private:
+    template <typename SampleType>
+    void procsamples(const SampleType* insamples, SampleType* outsamples, int numsamples);
+
+    C damping;
+    C reflection;
+    RingBuffer<T> buffer;
+    C state;
+};
+
+typedef LPcombfilterT<float, double> LPcombfilter;
\ No newline at end of file
@@ -1,114 +1,793 @@
-/*
-  ==============================================================================
-
-	Multiport.cpp
-	Created: 10 Dec 2020 5:38:16am
-	Author:  profw
-
-  ==============================================================================
-*/
-#include "MultiPort.h"
-
-Reflector::Reflector()
-{
-	insamples.resize(2);
-	outsamples.resize(2);
-	for (auto& sample : outsamples)
-		sample = std::make_shared<double>(0.0);
-	Gamma = 0.0;
-}
-
-void Reflector::step()
-{
-	*outsamples[0] = Gamma * *insamples[0] + (1.0 - Gamma) * *insamples[1];
-	*outsamples[1] = (1.0 + Gamma) * *insamples[0] - Gamma * *insamples[1];
-}
-
-Waveguide::Waveguide()
-{
-	insamples.resize(2);
-	outsamples.resize(2);
-	for (auto& sample : outsamples)
-		sample = std::make_shared<double>(0.0);
-	damping = 0.0;
-	oldest = 0;
-}
-
-void Waveguide::step()
-{
-	*outsamples[0] = damping * *outsamples[0] + (1.0 - damping) * westbuffer[oldest];
-	*outsamples[1] = damping * *outsamples[1] + (1.0 - damping) * eastbuffer[oldest];
-	eastbuffer[oldest] = *insamples[0];
-	westbuffer[oldest] = *insamples[1];
-	oldest = ++oldest % eastbuffer.size();
-}
-
-void Waveguide::setDelay(unsigned int D)
-{
-	eastbuffer.resize(D, 0.0);
-	westbuffer.resize(D, 0.0);
-	if (oldest >= eastbuffer.size())
-		oldest = 0;
-}
-
-void Junction::step()
-{
-	auto sum = 0.0;
-	for (auto port = 0; port < insamples.size(); port++)
-	{
-		sum += *insamples[port];
-		*outsamples[port] = -*insamples[port];
-	}
-	for (auto port = 0; port < insamples.size(); port++)
-		*outsamples[port] += 2.0 * sum / double(insamples.size());
-}
-
-void Junction::setNumPorts(unsigned int numports)
-{
-	insamples.clear();
-	outsamples.clear();
-	insamples.resize(numports);
-	outsamples.resize(numports);
-	for (auto& sample : outsamples)
-		sample = std::make_shared<double>(0.0);
-}
-
-MPnetwork::MPnetwork()
-{
-	numjunct = 0;
-	numwg = 0;
-}
-
-void MPnetwork::addJunctions(unsigned int numjunctions)
-{
-	numjunct += numjunctions;
-	junction.resize(numjunct);
-}
-
-void MPnetwork::addWaveguides(unsigned int numwaveguides)
-{
-	numwg += numwaveguides;
-	waveguide.resize(numwg);
-}
-
-void MPnetwork::setWGparams(unsigned int wgno, unsigned int delay, double damping)
-{
-	waveguide[wgno].setDelay(delay);
-	waveguide[wgno].setDamping(damping);
-}
-
-void MPnetwork::connect(unsigned int wgno, unsigned int junct1, unsigned int port1, unsigned int junct2, unsigned int port2)
-{
-	junction[junct1].setInputPtr(port1, waveguide[wgno].getOutputPtr(0));
-	junction[junct2].setInputPtr(port2, waveguide[wgno].getOutputPtr(1));
-	waveguide[wgno].setInputPtr(0, junction[junct1].getOutputPtr(port1));
-	waveguide[wgno].setInputPtr(1, junction[junct2].getOutputPtr(port2));
-}
-
-void MPnetwork::netstep()
-{
-	for (auto& junct : junction)
-		junct.step();
-	for (auto& wg : waveguide)
-		wg.step();
-}
\ No newline at end of file
+/*
+  ==============================================================================
+
+	Multiport.cpp
+	Created: 10 Dec 2020 5:38:16am
+	Author:  profw
+
+  ==============================================================================
+*/
+#include "MultiPort.h"
+#include "DSPkernels.h"
+#include "DenormalContext.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+
+struct MPnetwork::NetWorkers
+{
+	NetWorkers()
+	{
+		callcount = 0;
+		quit = false;
+		callsamples = 0;
+		callflush = false;
+		barriercount = 0;
+		barrierphase = 0;
+	}
+
+	std::vector<std::thread> threads;
+	std::mutex poolmutex;
+	std::condition_variable poolwake;
+	unsigned int callcount; // number of block calls so far
+	bool quit;
+	int callsamples;
+	bool callflush; // calling thread flushes subnormal numbers to zero
+	std::atomic<unsigned int> barriercount;
+	std::atomic<unsigned int> barrierphase;
+};
+
+Reflector::Reflector()
+{
+	insamples.resize(2);
+	outsamples.resize(2);
+	for (auto& sample : outsamples)
+		sample = std::make_shared<double>(0.0);
+	Gamma = 0.0;
+}
+
+void Reflector::step()
+{
+	*outsamples[0] = Gamma * *insamples[0] + (1.0 - Gamma) * *insamples[1];
+	*outsamples[1] = (1.0 + Gamma) * *insamples[0] - Gamma * *insamples[1];
+}
+
+Waveguide::Waveguide()
+{
+	insamples.resize(2);
+	outsamples.resize(2);
+	for (auto& sample : outsamples)
+		sample = std::make_shared<double>(0.0);
+	damping = 0.0;
+}
+
+void Waveguide::step()
+{
+	*outsamples[0] = damping * *outsamples[0] + (1.0 - damping) * westbuffer.read();
+	*outsamples[1] = damping * *outsamples[1] + (1.0 - damping) * eastbuffer.read();
+	eastbuffer.write(*insamples[0]);
+	westbuffer.write(*insamples[1]);
+}
+
+void Waveguide::setDelay(unsigned int D)
+{
+	eastbuffer.setdelay(D);
+	westbuffer.setdelay(D);
+}
+
+bool Waveguide::setMaxDelay(unsigned int D, DelayArena* arena)
+{
+	if (arena && arena->getsize() - arena->getused() < 2 * DelayArena::bytesfor<double>(D))
+		return false;
+	return eastbuffer.reserve(D, arena) && westbuffer.reserve(D, arena);
+}
+
+void Waveguide::procblock(const float* in0, const float* in1, float* out0, float* out1, int numsamples)
+{
+	// Chunks are no longer than the delay, so the inputs of a chunk can be written as soon
+	// as its delayed samples have been read
+	const DSPkernels& kernels = getkernels();
+	double eastdelayed[RINGCHUNK], westdelayed[RINGCHUNK];
+	double chunk[RINGCHUNK];
+	const unsigned int maxlen = eastbuffer.getdelay() < RINGCHUNK ? eastbuffer.getdelay() : RINGCHUNK;
+	double y0 = *outsamples[0];
+	double y1 = *outsamples[1];
+	for (int start = 0; start < numsamples; start += maxlen)
+	{
+		unsigned int len = unsigned(numsamples - start) < maxlen ? unsigned(numsamples - start) : maxlen;
+		eastbuffer.readblock(eastdelayed, len);
+		westbuffer.readblock(westdelayed, len);
+		kernels.floattodouble(in0 + start, chunk, int(len));
+		eastbuffer.writeblock(chunk, len);
+		kernels.floattodouble(in1 + start, chunk, int(len));
+		westbuffer.writeblock(chunk, len);
+		for (unsigned int n = 0; n < len; n++)
+		{
+			y0 = damping * y0 + (1.0 - damping) * westdelayed[n];
+			y1 = damping * y1 + (1.0 - damping) * eastdelayed[n];
+			out0[start + n] = float(y0);
+			out1[start + n] = float(y1);
+		}
+	}
+	*outsamples[0] = y0;
+	*outsamples[1] = y1;
+}
+
+void Waveguide::saveheader(SnapshotWriter& writer, double damp, double out0, double out1)
+{
+	writer.begin(snapshottag("WGDE"));
+	writer.put(damp);
+	writer.put(out0);
+	writer.put(out1);
+	writer.end();
+}
+
+void Waveguide::savestate(SnapshotWriter& writer) const
+{
+	saveheader(writer, damping, *outsamples[0], *outsamples[1]);
+	eastbuffer.savestate(writer);
+	westbuffer.savestate(writer);
+}
+
+bool Waveguide::loadstate(SnapshotReader& reader)
+{
+	SavedState saved;
+	if (!readstate(reader, saved) || !canrestore(saved))
+		return false;
+	restorestate(saved);
+	return true;
+}
+
+bool Waveguide::readstate(SnapshotReader& reader, SavedState& saved)
+{
+	return reader.begin(snapshottag("WGDE")) && reader.get(saved.damp) && reader.get(saved.out0)
+		&& reader.get(saved.out1) && reader.end() && RingBuffer<double>::readstate(reader, saved.east)
+		&& RingBuffer<double>::readstate(reader, saved.west);
+}
+
+bool Waveguide::canrestore(const SavedState& saved) const
+{
+	return eastbuffer.canrestore(saved.east) && westbuffer.canrestore(saved.west);
+}
+
+void Waveguide::restorestate(const SavedState& saved)
+{
+	damping = saved.damp;
+	*outsamples[0] = saved.out0;
+	*outsamples[1] = saved.out1;
+	eastbuffer.restorestate(saved.east);
+	westbuffer.restorestate(saved.west);
+}
+
+void Junction::step()
+{
+	auto sum = 0.0;
+	for (auto port = 0; port < insamples.size(); port++)
+	{
+		sum += *insamples[port];
+		*outsamples[port] = -*insamples[port];
+	}
+	for (auto port = 0; port < insamples.size(); port++)
+		*outsamples[port] += 2.0 * sum / double(insamples.size());
+}
+
+void Junction::setNumPorts(unsigned int numports)
+{
+	insamples.clear();
+	outsamples.clear();
+	insamples.resize(numports);
+	outsamples.resize(numports);
+	for (auto& sample : outsamples)
+		sample = std::make_shared<double>(0.0);
+}
+
+MPnetwork::MPnetwork()
+{
+	numjunct = 0;
+	numwg = 0;
+	compiled = false;
+	lineslot = 0;
+	tick = 0;
+	blocklimit = 0;
+	callin = nullptr;
+	callout = nullptr;
+}
+
+MPnetwork::~MPnetwork()
+{
+	stopworkers();
+}
+
+MPnetwork::MPnetwork(const MPnetwork& other) : MPnetwork()
+{
+	takeplan(other);
+	startworkers();
+}
+
+MPnetwork::MPnetwork(MPnetwork&& other) : MPnetwork()
+{
+	// The threads of the other network are bound to it, so they are replaced
+	other.stopworkers();
+	takeplan(std::move(other));
+	other.takeplan(MPnetwork());
+	startworkers();
+}
+
+MPnetwork& MPnetwork::operator=(const MPnetwork& other)
+{
+	if (this != &other)
+	{
+		stopworkers();
+		takeplan(other);
+		startworkers();
+	}
+	return *this;
+}
+
+MPnetwork& MPnetwork::operator=(MPnetwork&& other)
+{
+	if (this != &other)
+	{
+		stopworkers();
+		other.stopworkers();
+		takeplan(std::move(other));
+		other.takeplan(MPnetwork());
+		startworkers();
+	}
+	return *this;
+}
+
+template <typename N>
+void MPnetwork::takeplan(N&& other)
+{
+	// Everything but the worker threads, copied or moved as other is
+	junction = std::forward<N>(other).junction;
+	waveguide = std::forward<N>(other).waveguide;
+	numjunct = other.numjunct;
+	numwg = other.numwg;
+	compiled = other.compiled;
+	state = std::forward<N>(other).state;
+	sources = std::forward<N>(other).sources;
+	taps = std::forward<N>(other).taps;
+	junctslot = std::forward<N>(other).junctslot;
+	junctinput = std::forward<N>(other).junctinput;
+	groups = std::forward<N>(other).groups;
+	lines = std::forward<N>(other).lines;
+	lineslot = other.lineslot;
+	delaymem = std::forward<N>(other).delaymem;
+	tick = other.tick;
+	parts = std::forward<N>(other).parts;
+	blocklimit = other.blocklimit;
+}
+
+void MPnetwork::addJunctions(unsigned int numjunctions)
+{
+	decompile();
+	numjunct += numjunctions;
+	junction.resize(numjunct);
+}
+
+void MPnetwork::addWaveguides(unsigned int numwaveguides)
+{
+	decompile();
+	numwg += numwaveguides;
+	waveguide.resize(numwg);
+}
+
+void MPnetwork::setWGparams(unsigned int wgno, unsigned int delay, double damping)
+{
+	decompile();
+	waveguide[wgno].setDelay(delay);
+	waveguide[wgno].setDamping(damping);
+}
+
+void MPnetwork::connect(unsigned int wgno, unsigned int junct1, unsigned int port1, unsigned int junct2, unsigned int port2)
+{
+	decompile();
+	junction[junct1].setInputPtr(port1, waveguide[wgno].getOutputPtr(0));
+	junction[junct2].setInputPtr(port2, waveguide[wgno].getOutputPtr(1));
+	waveguide[wgno].setInputPtr(0, junction[junct1].getOutputPtr(port1));
+	waveguide[wgno].setInputPtr(1, junction[junct2].getOutputPtr(port2));
+}
+
+void MPnetwork::addsource(unsigned int junct, unsigned int port, std::shared_ptr<double> src)
+{
+	decompile();
+	junction[junct].setInputPtr(port, src);
+	if (std::find(sources.begin(), sources.end(), src) == sources.end())
+		sources.push_back(src);
+}
+
+unsigned int MPnetwork::addtap(unsigned int junct, unsigned int port)
+{
+	taps.push_back(std::make_pair(junct, port));
+	if (compiled)
+	{
+		for (auto& part : parts)
+			if (junct >= part.firstjunct && junct < part.endjunct)
+				part.taps.push_back(PlanCopy{ junctslot[junct] + port, unsigned(taps.size() - 1) });
+	}
+	return taps.size() - 1;
+}
+
+void MPnetwork::scatter(unsigned int firstgroup, unsigned int endgroup)
+{
+	// The scatter kernel uses the arithmetic of Junction::step(), so the result is identical
+	const DSPkernels& kernels = getkernels();
+	double* st = state.data();
+	for (unsigned int g = firstgroup; g < endgroup; g++)
+	{
+		const PlanGroup& grp = groups[g];
+		kernels.scatter(st, junctinput.data() + grp.inbase, grp.numjunct, grp.outbase, grp.numports);
+	}
+}
+
+void MPnetwork::netstep()
+{
+	if (!compiled)
+	{
+		for (auto& junct : junction)
+			junct.step();
+		for (auto& wg : waveguide)
+			wg.step();
+		return;
+	}
+
+	double* st = state.data();
+	for (auto& part : parts)
+		for (auto& src : part.sources)
+			st[src.slot] = *sources[src.index];
+
+	// Junctions read only waveguide outputs and sources, so the order of the groups is free
+	scatter(0, groups.size());
+
+	// Each delay line reads its delayed sample before it is overwritten, as in Waveguide::step()
+	double* mem = delaymem.data();
+	double* out = st + lineslot;
+	const PlanLine* line = lines.data();
+	const unsigned int numlines = lines.size();
+	for (unsigned int l = 0; l < numlines; l++)
+	{
+		double* buf = mem + line[l].offset;
+		out[l] = line[l].damping * out[l] + line[l].gain * buf[(tick - line[l].delay) & line[l].mask];
+		buf[tick & line[l].mask] = st[line[l].input];
+	}
+	tick++;
+}
+
+void MPnetwork::netstep(int numsamples, const float* const* insamples, float* const* outsamples)
+{
+	if (!compiled)
+	{
+		for (int n = 0; n < numsamples; n++)
+		{
+			for (unsigned int k = 0; k < sources.size(); k++)
+				*sources[k] = insamples[k][n];
+			netstep();
+			for (unsigned int k = 0; k < taps.size(); k++)
+				outsamples[k][n] = float(getoutput(taps[k].first, taps[k].second));
+		}
+		return;
+	}
+
+	if (pool)
+	{
+		{
+			std::lock_guard<std::mutex> lock(pool->poolmutex);
+			pool->callsamples = numsamples;
+			callin = insamples;
+			callout = outsamples;
+			pool->callflush = DenormalContext::isthreadflushing();
+			pool->callcount++;
+		}
+		pool->poolwake.notify_all();
+	}
+	else
+	{
+		callin = insamples;
+		callout = outsamples;
+	}
+	runblocks(0, numsamples);
+	tick += numsamples;
+}
+
+void MPnetwork::steppart(unsigned int p, int start, int numsamples)
+{
+	const PlanPart& part = parts[p];
+	double* st = state.data();
+	double* mem = delaymem.data();
+	double* out = st + lineslot;
+	const PlanLine* line = lines.data();
+	for (int n = start; n < start + numsamples; n++)
+	{
+		const unsigned int t = tick + n;
+		for (auto& src : part.sources)
+			st[src.slot] = callin[src.index][n];
+		scatter(part.firstgroup, part.endgroup);
+		for (auto& tap : part.taps)
+			callout[tap.index][n] = float(st[tap.slot]);
+		// The lines read by this part may be fed by another part, which is writing samples
+		// no older than the start of the block. The block is no longer than their delay, so
+		// those samples are not read until the next block, and the capacity leaves room for
+		// a block beyond the delay.
+		for (unsigned int l = part.firstline; l < part.endline; l++)
+			out[l] = line[l].damping * out[l] + line[l].gain * mem[line[l].offset + ((t - line[l].delay) & line[l].mask)];
+		for (unsigned int l : part.feeds)
+			mem[line[l].offset + (t & line[l].mask)] = st[line[l].input];
+	}
+}
+
+void MPnetwork::runblocks(unsigned int part, int numsamples)
+{
+	if (parts.size() == 1)
+	{
+		steppart(part, 0, numsamples);
+		return;
+	}
+	for (int start = 0; start < numsamples; start += blocklimit)
+	{
+		int len = numsamples - start < int(blocklimit) ? numsamples - start : int(blocklimit);
+		steppart(part, start, len);
+		barrier();
+	}
+}
+
+void MPnetwork::worker(unsigned int part)
+{
+	unsigned int seen = 0;
+	while (true)
+	{
+		int numsamples;
+		bool flush;
+		{
+			std::unique_lock<std::mutex> lock(pool->poolmutex);
+			pool->poolwake.wait(lock, [&]() { return pool->quit || pool->callcount != seen; });
+			if (pool->quit)
+				return;
+			seen = pool->callcount;
+			numsamples = pool->callsamples;
+			flush = pool->callflush;
+		}
+		// Run with the floating point mode of the calling thread, as TaskPool does
+		if (flush)
+		{
+			DenormalContext context(DenormalMode::FLUSH);
+			runblocks(part, numsamples);
+		}
+		else
+			runblocks(part, numsamples);
+	}
+}
+
+void MPnetwork::barrier()
+{
+	// Sense-reversing barrier: the last thread to arrive starts the next phase
+	const unsigned int phase = pool->barrierphase.load(std::memory_order_acquire);
+	if (pool->barriercount.fetch_add(1, std::memory_order_acq_rel) + 1 == parts.size())
+	{
+		pool->barriercount.store(0, std::memory_order_relaxed);
+		pool->barrierphase.store(phase + 1, std::memory_order_release);
+		return;
+	}
+	int spins = 0;
+	while (pool->barrierphase.load(std::memory_order_acquire) == phase)
+		if (++spins > 64)
+			std::this_thread::yield();
+}
+
+void MPnetwork::startworkers()
+{
+	if (!compiled || parts.size() < 2)
+		return;
+	pool.reset(new NetWorkers());
+	for (unsigned int p = 1; p < parts.size(); p++)
+		pool->threads.push_back(std::thread(&MPnetwork::worker, this, p));
+}
+
+void MPnetwork::stopworkers()
+{
+	if (!pool)
+		return;
+	{
+		std::lock_guard<std::mutex> lock(pool->poolmutex);
+		pool->quit = true;
+	}
+	pool->poolwake.notify_all();
+	for (auto& thr : pool->threads)
+		thr.join();
+	pool.reset();
+}
+
+void MPnetwork::compile(unsigned int numthreads)
+{
+	decompile();
+
+	// Divide the junctions into contiguous ranges with about the same number of ports
+	unsigned int numparts = numthreads < 1 ? 1 : numthreads;
+	if (numparts > numjunct && numjunct > 0)
+		numparts = numjunct;
+	std::vector<unsigned int> partof(numjunct);
+	parts.assign(numparts, PlanPart());
+	unsigned int totalports = 0;
+	for (auto& junct : junction)
+		totalports += junct.getNumPorts();
+	unsigned int part = 0, ports = 0;
+	for (unsigned int j = 0; j < numjunct; j++)
+	{
+		if (ports * numparts >= totalports * (part + 1) && part + 1 < numparts)
+		{
+			parts[part].endjunct = j;
+			parts[++part].firstjunct = j;
+		}
+		partof[j] = part;
+		ports += junction[j].getNumPorts();
+	}
+	parts[numparts - 1].endjunct = numjunct;
+
+	// Which junction feeds, and which junction reads, each waveguide output
+	std::map<const double*, unsigned int> jfeeding; // junction output -> junction
+	std::map<const double*, unsigned int> jreading; // waveguide output -> junction
+	for (unsigned int j = 0; j < numjunct; j++)
+		for (unsigned int port = 0; port < junction[j].getNumPorts(); port++)
+		{
+			jfeeding[junction[j].getOutputPtr(port).get()] = j;
+			auto src = junction[j].getInputPtr(port);
+			if (src)
+				jreading[src.get()] = j;
+		}
+	std::vector<unsigned int> reader(2 * numwg), feeder(2 * numwg);
+	for (unsigned int wg = 0; wg < numwg; wg++)
+		for (unsigned int port = 0; port < 2; port++)
+		{
+			auto out = waveguide[wg].getOutputPtr(port);
+			auto in = waveguide[wg].getInputPtr(1 - port);
+			bool isread = jreading.count(out.get()) > 0;
+			bool isfed = in && jfeeding.count(in.get()) > 0;
+			unsigned int rpart = isread ? partof[jreading[out.get()]] : isfed ? partof[jfeeding[in.get()]] : 0;
+			reader[2 * wg + port] = rpart;
+			feeder[2 * wg + port] = isfed ? partof[jfeeding[in.get()]] : rpart;
+		}
+
+	// State layout: ground, then for each part its sources and its junction outputs (grouped
+	// by port count), then the waveguide outputs ordered by the part that reads them
+	std::map<const double*, unsigned int> slotof; // element output -> state index
+	std::vector<std::map<const double*, unsigned int>> srcslot(numparts);
+	std::map<const double*, unsigned int> srcindex;
+	for (unsigned int k = 0; k < sources.size(); k++)
+		srcindex[sources[k].get()] = k;
+	unsigned int numslots = 1;
+	groups.clear();
+	junctslot.assign(numjunct, 0);
+	std::vector<std::vector<unsigned int>> groupjuncts;
+	for (unsigned int p = 0; p < numparts; p++)
+	{
+		PlanPart& pt = parts[p];
+		for (unsigned int j = pt.firstjunct; j < pt.endjunct; j++)
+			for (unsigned int port = 0; port < junction[j].getNumPorts(); port++)
+			{
+				auto src = junction[j].getInputPtr(port);
+				if (src && srcindex.count(src.get()) && !srcslot[p].count(src.get()))
+				{
+					srcslot[p][src.get()] = numslots;
+					pt.sources.push_back(PlanCopy{ numslots++, srcindex[src.get()] });
+				}
+			}
+
+		std::map<unsigned int, std::vector<unsigned int>> byports;
+		for (unsigned int j = pt.firstjunct; j < pt.endjunct; j++)
+			byports[junction[j].getNumPorts()].push_back(j);
+		pt.firstgroup = groups.size();
+		for (auto& entry : byports)
+		{
+			PlanGroup grp;
+			grp.numports = entry.first;
+			grp.numjunct = entry.second.size();
+			grp.outbase = numslots;
+			grp.inbase = 0;
+			groups.push_back(grp);
+			groupjuncts.push_back(entry.second);
+			for (unsigned int j : entry.second)
+			{
+				junctslot[j] = numslots;
+				for (unsigned int port = 0; port < grp.numports; port++)
+					slotof[junction[j].getOutputPtr(port).get()] = numslots++;
+			}
+		}
+		pt.endgroup = groups.size();
+	}
+	for (auto& tap : taps)
+		parts[partof[tap.first]].taps.push_back(PlanCopy{ junctslot[tap.first] + tap.second, unsigned(&tap - taps.data()) });
+
+	// Lines, ordered by reading part; output port 0 of a waveguide comes from the west line
+	// (input 1), port 1 from the east line (input 0)
+	lineslot = numslots;
+	lines.clear();
+	for (unsigned int p = 0; p < numparts; p++)
+	{
+		parts[p].firstline = lines.size();
+		for (unsigned int wg = 0; wg < numwg; wg++)
+			for (unsigned int port = 0; port < 2; port++)
+				if (reader[2 * wg + port] == p)
+				{
+					const RingBuffer<double>& buf = port == 0 ? waveguide[wg].westbuffer : waveguide[wg].eastbuffer;
+					auto in = waveguide[wg].getInputPtr(1 - port);
+					PlanLine line;
+					line.offset = 0;
+					line.mask = buf.getcapacity() - 1;
+					line.delay = buf.getdelay();
+					line.input = in && slotof.count(in.get()) ? slotof[in.get()] : 0;
+					line.damping = waveguide[wg].damping;
+					line.gain = 1.0 - waveguide[wg].damping;
+					line.element = 2 * wg + port;
+					slotof[waveguide[wg].getOutputPtr(port).get()] = numslots++;
+					lines.push_back(line);
+				}
+		parts[p].endline = lines.size();
+	}
+
+	// Resolve every junction input to a state index
+	junctinput.clear();
+	for (unsigned int g = 0; g < groups.size(); g++)
+	{
+		unsigned int p = partof[groupjuncts[g][0]];
+		groups[g].inbase = junctinput.size();
+		for (unsigned int j : groupjuncts[g])
+			for (unsigned int port = 0; port < groups[g].numports; port++)
+			{
+				auto src = junction[j].getInputPtr(port);
+				unsigned int slot = 0; // unlinked ports and grounds read state[0]
+				if (src && slotof.count(src.get()))
+					slot = slotof[src.get()];
+				else if (src && srcslot[p].count(src.get()))
+					slot = srcslot[p][src.get()];
+				junctinput.push_back(slot);
+			}
+	}
+
+	// Lines between parts limit the block length. Their capacity must hold a block beyond
+	// the delay, since the feeding part may run up to a block ahead of the reading part.
+	blocklimit = 1u << 30;
+	for (auto& line : lines)
+		if (reader[line.element] != feeder[line.element] && line.delay < blocklimit)
+			blocklimit = line.delay;
+	unsigned int memsize = 0;
+	for (auto& line : lines)
+	{
+		if (reader[line.element] != feeder[line.element])
+			while (line.mask + 1 < line.delay + blocklimit)
+				line.mask = 2 * line.mask + 1;
+		line.offset = memsize;
+		memsize += line.mask + 1;
+		parts[feeder[line.element]].feeds.push_back(&line - lines.data());
+	}
+
+	// Carry the current state of the elements into the plan
+	state.assign(numslots, 0.0);
+	delaymem.assign(memsize, 0.0);
+	tick = 0;
+	for (unsigned int l = 0; l < lines.size(); l++)
+	{
+		const Waveguide& guide = waveguide[lines[l].element / 2];
+		const RingBuffer<double>& buf = lines[l].element % 2 == 0 ? guide.westbuffer : guide.eastbuffer;
+		for (unsigned int k = 1; k <= buf.getcapacity(); k++)
+			delaymem[lines[l].offset + ((tick - k) & lines[l].mask)] = buf.read(k);
+		state[lineslot + l] = *guide.outsamples[lines[l].element % 2];
+	}
+	for (unsigned int j = 0; j < numjunct; j++)
+		for (unsigned int port = 0; port < junction[j].getNumPorts(); port++)
+			state[junctslot[j] + port] = *junction[j].getOutputPtr(port);
+
+	compiled = true;
+	startworkers();
+}
+
+void MPnetwork::decompile()
+{
+	if (!compiled)
+		return;
+	compiled = false;
+	stopworkers();
+
+	// Carry the state of the plan back into the elements
+	for (unsigned int j = 0; j < numjunct; j++)
+		for (unsigned int port = 0; port < junction[j].getNumPorts(); port++)
+			*junction[j].getOutputPtr(port) = state[junctslot[j] + port];
+	for (unsigned int l = 0; l < lines.size(); l++)
+	{
+		Waveguide& guide = waveguide[lines[l].element / 2];
+		RingBuffer<double>& buf = lines[l].element % 2 == 0 ? guide.westbuffer : guide.eastbuffer;
+		const PlanLine& line = lines[l];
+		buf.clear();
+		for (unsigned int k = buf.getcapacity(); k >= 1; k--)
+			buf.write(delaymem[line.offset + ((tick - k) & line.mask)]);
+		*guide.outsamples[line.element % 2] = state[lineslot + l];
+	}
+	parts.clear();
+	groups.clear();
+	junctinput.clear();
+	junctslot.clear();
+	lines.clear();
+	state.clear();
+	delaymem.clear();
+}
+
+void MPnetwork::savestate(SnapshotWriter& writer) const
+{
+	writer.begin(snapshottag("MPNW"));
+	writer.put(std::uint32_t(numjunct));
+	writer.put(std::uint32_t(numwg));
+	for (unsigned int j = 0; j < numjunct; j++)
+	{
+		const unsigned int numports = junction[j].getNumPorts();
+		writer.put(std::uint32_t(numports));
+		for (unsigned int port = 0; port < numports; port++)
+			writer.put(compiled ? state[junctslot[j] + port] : *junction[j].getOutputPtr(port));
+	}
+	writer.end();
+
+	if (!compiled)
+	{
+		for (auto& wg : waveguide)
+			wg.savestate(writer);
+		return;
+	}
+
+	// Read the plan the way decompile() does: element 2 * wg is the west line, feeding port 0
+	std::vector<unsigned int> lineof(2 * numwg);
+	for (unsigned int l = 0; l < lines.size(); l++)
+		lineof[lines[l].element] = l;
+	for (unsigned int wg = 0; wg < numwg; wg++)
+	{
+		const PlanLine& west = lines[lineof[2 * wg]];
+		const PlanLine& east = lines[lineof[2 * wg + 1]];
+		Waveguide::saveheader(writer, waveguide[wg].damping, state[lineslot + lineof[2 * wg]],
+			state[lineslot + lineof[2 * wg + 1]]);
+		RingBuffer<double>::savesamples(writer, delaymem.data() + east.offset, east.mask + 1, tick, east.delay);
+		RingBuffer<double>::savesamples(writer, delaymem.data() + west.offset, west.mask + 1, tick, west.delay);
+	}
+}
+
+bool MPnetwork::loadstate(SnapshotReader& reader)
+{
+	// The elements hold the state while the network is not compiled
+	const unsigned int numparts = compiled ? unsigned(parts.size()) : 0;
+	decompile();
+
+	std::uint32_t savedjunct = 0, savedwg = 0;
+	bool loaded = reader.begin(snapshottag("MPNW")) && reader.get(savedjunct) && reader.get(savedwg)
+		&& savedjunct == numjunct && savedwg == numwg;
+	std::vector<double> outputs;
+	for (unsigned int j = 0; loaded && j < numjunct; j++)
+	{
+		std::uint32_t numports = 0;
+		loaded = reader.get(numports) && numports == junction[j].getNumPorts();
+		for (unsigned int port = 0; loaded && port < numports; port++)
+		{
+			double value = 0.0;
+			loaded = reader.get(value);
+			outputs.push_back(value);
+		}
+	}
+	loaded = loaded && reader.end();
+	// Every waveguide is read and checked before anything is restored, so a failed load leaves
+	// the network as it was
+	std::vector<Waveguide::SavedState> saved(loaded ? numwg : 0);
+	for (unsigned int wg = 0; loaded && wg < numwg; wg++)
+		loaded = Waveguide::readstate(reader, saved[wg]) && waveguide[wg].canrestore(saved[wg]);
+	if (loaded)
+	{
+		unsigned int k = 0;
+		for (auto& junct : junction)
+			for (unsigned int port = 0; port < junct.getNumPorts(); port++)
+				*junct.getOutputPtr(port) = outputs[k++];
+		for (unsigned int wg = 0; wg < numwg; wg++)
+			waveguide[wg].restorestate(saved[wg]);
+	}
+
+	if (numparts > 0)
+		compile(numparts);
+	return loaded;
+}
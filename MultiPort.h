@@ -1,253 +1,496 @@
-/*
-  ==============================================================================
-
-	Multiport.h
-	Created: 10 Dec 2020 5:38:16am
-	Author:  profw
-
-  ==============================================================================
-*/
-
-#pragma once
-
-#include<vector>
-#include<memory>
-
-/// <summary>
-/// Base class for multiport network elements
-/// 
-/// Multiport elements may be interconnected to create audio signal processing networks.
-/// </summary>
-class MultiPort
-{
-public:
-	MultiPort() {}
-	~MultiPort() {}
-
-	/// <summary>
-	/// Get a link to a given output port.
-	/// 
-	/// This method provides a shared pointer to an output of the element. The pointer can 
-	/// be used as an input to another element or can be de-referenced to provide the output value.
-	/// </summary>
-	/// <param name="port">port number</param>
-	/// <returns>pointer to port output</returns>
-	std::shared_ptr<double> getOutputPtr(unsigned int port) { return(outsamples[port]); }
-
-	/// <summary>
-	/// Link input port to a source
-	/// 
-	/// This method links an input to the element to an input source. The arguments include a
-	/// shared pointer to the source.
-	/// </summary>
-	/// <param name="port">port number</param>
-	/// <param name="source">pointer to source</param>
-	void setInputPtr(unsigned int port, std::shared_ptr<double> source) { insamples[port] = source; }
-
-	/// <summary>
-	/// Connect port input to ground (zero)
-	/// 
-	/// This method sets an input to the element to zero, using a shared pointer to a fixed value of 0.0.
-	/// </summary>
-	/// <param name="port">port number</param>
-	void setGround(unsigned int port) { insamples[port] = std::make_shared<double>(0.0); }
-
-	/// <summary>
-	/// Compute output from current input
-	/// 
-	/// This is a virtual method that must be implemented for each derived class.
-	/// </summary>
-	virtual void step() {}
-
-protected:
-	std::vector<std::shared_ptr<double>> insamples, outsamples;
-};
-
-/// <summary>
-/// Two port element representing waveguide termination or discontinuity
-/// 
-/// The inputs to this element are partially transmitted and partially reflected.
-/// This element is characterized by a single parameter: the reflection coefficient.
-/// </summary>
-class Reflector : public MultiPort
-{
-public:
-	Reflector();
-	~Reflector() {}
-
-	/// <summary>
-	/// Compute output from current input
-	/// 
-	/// This method steps the reflector through one sample cycle and updates the port outputs
-	/// </summary>
-	void step() override;
-
-	/// <summary>
-	/// Set reflection coefficient
-	/// </summary>
-	/// <param name="G">reflection coefficient</param>
-	void setReflection(double G) { Gamma = G; }
-
-private:
-	double Gamma;
-};
-
-
-/// <summary>
-/// Two port network element representing propagation path
-/// 
-/// The element consists of two delay lines, denoted east and west, with frequency-dependent loss.
-/// </summary>
-class Waveguide : public MultiPort
-{
-public:
-	Waveguide();
-	~Waveguide() {}
-
-	/// <summary>
-	/// Compute output from current input
-	/// 
-	/// This method steps the waveguide through one sample cycle and updates the port outputs
-	/// </summary>
-	void step() override;
-
-	/// <summary>
-	/// Set damping factor
-	/// </summary>
-	/// <param name="damp">damping factor</param>
-	void setDamping(double damp) { damping = damp; }
-
-	/// <summary>
-	/// Set sample delay
-	/// </summary>
-	/// <param name="D">sample delay</param>
-	void setDelay(unsigned int D);
-
-private:
-	double damping;
-	std::vector<double> eastbuffer;
-	std::vector<double> westbuffer;
-	unsigned int oldest;
-};
-
-/// <summary>
-/// Multi-port network element representing simple waveguide junction
-/// 
-/// This element is normally used as a junction among three or more waveguide elements. It
-/// can also be used to connect two waveguide elements, but this is simply equivalent to
-/// connecting the waveguides directly.
-/// </summary>
-class Junction : public MultiPort
-{
-public:
-	Junction() {};
-	~Junction() {}
-
-	/// <summary>
-	/// Compute output from current input
-	/// 
-	/// This method steps the junction through one sample cycle and updates the port outputs
-	/// </summary>
-	void step() override;
-
-	/// <summary>
-	/// Set number of ports
-	/// </summary>
-	/// <param name="numports">number of ports</param>
-	void setNumPorts(unsigned int numports);
-};
-
-
-/// <summary>
-/// Multiport element network consisting of interconnected waveguides and junctions
-/// 
-/// This class facilitates creation of networks of multiport elements. It currently supports
-/// networks of waveguides and junctions.
-/// </summary>
-class MPnetwork
-{
-public:
-	MPnetwork();
-	~MPnetwork() {}
-
-	/// <summary>
-	/// Add junctions to the network
-	/// </summary>
-	/// <param name="numjunctions">number of junctions to add</param>
-	void addJunctions(unsigned int numjunctions);
-
-	/// <summary>
-	/// Add waveguides to the network
-	/// </summary>
-	/// <param name="numwaveguides">number of waveguides to add</param>
-	void addWaveguides(unsigned int numwaveguides);
-
-	/// <summary>
-	/// Set port count for a junction
-	/// </summary>
-	/// <param name="junctno">junction number</param>
-	/// <param name="numports">number of ports</param>
-	void setNumPorts(unsigned int junctno, unsigned int numports) { junction[junctno].setNumPorts(numports); }
-
-	/// <summary>
-	/// Set waveguide sample delay and damping factor
-	/// </summary>
-	/// <param name="wgno">waveguide number</param>
-	/// <param name="delay">sample delay</param>
-	/// <param name="damping">damping</param>
-	void setWGparams(unsigned int wgno, unsigned int delay, double damping);
-
-	/// <summary>
-	/// Connect two junctions with a waveguide
-	/// 
-	/// Once junctions and waveguides have been added to the network, use this method
-	/// to establish the connections. Make sure all port inputs are either connected or 
-	/// grounded.
-	/// </summary>
-	/// <param name="wgno">waveguide number</param>
-	/// <param name="junct1">east junction number</param>
-	/// <param name="port1">east junction port number</param>
-	/// <param name="junct2">west junction number</param>
-	/// <param name="port2">west junction port number</param>
-	void connect(unsigned int wgno, unsigned int junct1, unsigned int port1, unsigned int junct2, unsigned int port2);
-
-	/// <summary>
-	/// Set junction input to ground (0.0)
-	/// 
-	/// Use this method if there is no input for a given port.
-	/// </summary>
-	/// <param name="junct">junction number</param>
-	/// <param name="port">port number</param>
-	void addground(unsigned int junct, unsigned int port) { junction[junct].setGround(port); }
-
-	/// <summary>
-	/// Set junction input to source
-	/// 
-	/// Use this method for external inputs to the network.
-	/// </summary>
-	/// <param name="junct">junction number</param>
-	/// <param name="port">port number</param>
-	/// <param name="src">source</param>
-	void addsource(unsigned int junct, unsigned int port, std::shared_ptr<double> src) { junction[junct].setInputPtr(port, src); }
-
-	/// <summary>
-	/// Get output from given junction and port
-	/// </summary>
-	/// <param name="junct">junction number</param>
-	/// <param name="port">port number</param>
-	/// <returns>output value</returns>
-	double getoutput(unsigned int junct, unsigned int port) { return(*junction[junct].getOutputPtr(port)); }
-
-	/// <summary>
-	/// Step every element in the network
-	/// 
-	/// This method steps the network through one sample cycle and updates all port outputs
-	/// </summary>
-	void netstep();
-
-private:
-	std::vector<Junction> junction;
-	std::vector<Waveguide> waveguide;
-	unsigned int numjunct;
-	unsigned int numwg;
+/*
+  ==============================================================================
+
+	Multiport.h
+	Created: 10 Dec 2020 5:38:16am
+	Author:  profw
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include<vector>
+#include<memory>
+#include "RingBuffer.h"
+
+/// <summary>
+/// Base class for multiport network elements
+/// 
+/// Multiport elements may be interconnected to create audio signal processing networks.
+/// </summary>
+class MultiPort
+{
+public:
+	MultiPort() {}
+	~MultiPort() {}
+
+	/// <summary>
+	/// Get a link to a given output port.
+	/// 
+	/// This method provides a shared pointer to an output of the element. The pointer can 
+	/// be used as an input to another element or can be de-referenced to provide the output value.
+	/// </summary>
+	/// <param name="port">port number</param>
+	/// <returns>pointer to port output</returns>
+	std::shared_ptr<double> getOutputPtr(unsigned int port) const { return(outsamples[port]); }
+
+	/// <summary>
+	/// Link input port to a source
+	/// 
+	/// This method links an input to the element to an input source. The arguments include a
+	/// shared pointer to the source.
+	/// </summary>
+	/// <param name="port">port number</param>
+	/// <param name="source">pointer to source</param>
+	void setInputPtr(unsigned int port, std::shared_ptr<double> source) { insamples[port] = source; }
+
+	/// <summary>
+	/// Get the source linked to a given input port
+	/// </summary>
+	/// <param name="port">port number</param>
+	/// <returns>pointer to source (empty if the port is not linked)</returns>
+	std::shared_ptr<double> getInputPtr(unsigned int port) { return(insamples[port]); }
+
+	/// <summary>
+	/// Get number of ports
+	/// </summary>
+	/// <returns>number of ports</returns>
+	unsigned int getNumPorts() const { return insamples.size(); }
+
+	/// <summary>
+	/// Connect port input to ground (zero)
+	/// 
+	/// This method sets an input to the element to zero, using a shared pointer to a fixed value of 0.0.
+	/// </summary>
+	/// <param name="port">port number</param>
+	void setGround(unsigned int port) { insamples[port] = std::make_shared<double>(0.0); }
+
+	/// <summary>
+	/// Compute output from current input
+	/// 
+	/// This is a virtual method that must be implemented for each derived class.
+	/// </summary>
+	virtual void step() {}
+
+protected:
+	std::vector<std::shared_ptr<double>> insamples, outsamples;
+};
+
+/// <summary>
+/// Two port element representing waveguide termination or discontinuity
+/// 
+/// The inputs to this element are partially transmitted and partially reflected.
+/// This element is characterized by a single parameter: the reflection coefficient.
+/// </summary>
+class Reflector : public MultiPort
+{
+public:
+	Reflector();
+	~Reflector() {}
+
+	/// <summary>
+	/// Compute output from current input
+	/// 
+	/// This method steps the reflector through one sample cycle and updates the port outputs
+	/// </summary>
+	void step() override;
+
+	/// <summary>
+	/// Set reflection coefficient
+	/// </summary>
+	/// <param name="G">reflection coefficient</param>
+	void setReflection(double G) { Gamma = G; }
+
+private:
+	double Gamma;
+};
+
+
+/// <summary>
+/// Two port network element representing propagation path
+/// 
+/// The element consists of two delay lines, denoted east and west, with frequency-dependent loss.
+/// </summary>
+class Waveguide : public MultiPort
+{
+public:
+	Waveguide();
+	~Waveguide() {}
+
+	/// <summary>
+	/// Compute output from current input
+	/// 
+	/// This method steps the waveguide through one sample cycle and updates the port outputs
+	/// </summary>
+	void step() override;
+
+	/// <summary>
+	/// Set damping factor
+	/// </summary>
+	/// <param name="damp">damping factor</param>
+	void setDamping(double damp) { damping = damp; }
+
+	/// <summary>
+	/// Set sample delay
+	///
+	/// Once the storage comes from a DelayArena, the delay is limited to the maximum given to
+	/// setMaxDelay() and nothing is allocated.
+	/// </summary>
+	/// <param name="D">sample delay</param>
+	void setDelay(unsigned int D);
+
+	/// <summary>
+	/// Reserve storage for a maximum delay
+	///
+	/// The two delay lines take two regions of the arena.
+	/// </summary>
+	/// <param name="D">maximum sample delay</param>
+	/// <param name="arena">arena to take the storage from (nullptr to allocate it)</param>
+	/// <returns>false if the arena does not have enough room left</returns>
+	bool setMaxDelay(unsigned int D, DelayArena* arena = nullptr);
+
+	/// <summary>
+	/// Process a block of samples through both delay lines
+	/// 
+	/// This method runs the waveguide on its own, outside of a network, taking the port inputs
+	/// from the given buffers rather than from the linked sources. The port outputs are left
+	/// holding the values for the last sample in the block.
+	/// </summary>
+	/// <param name="in0">pointer to first port 0 (east) input sample</param>
+	/// <param name="in1">pointer to first port 1 (west) input sample</param>
+	/// <param name="out0">pointer to first port 0 output sample</param>
+	/// <param name="out1">pointer to first port 1 output sample</param>
+	/// <param name="numsamples">number of samples in the block</param>
+	void procblock(const float* in0, const float* in1, float* out0, float* out1, int numsamples);
+
+	/// <summary>
+	/// Write the damping, port outputs and delay line contents to a snapshot
+	///
+	/// The links to other elements are not part of the state.
+	/// </summary>
+	/// <param name="writer">snapshot</param>
+	void savestate(SnapshotWriter& writer) const;
+
+	/// <summary>
+	/// Restore everything written by savestate()
+	///
+	/// If any record does not match, the waveguide is left unchanged.
+	/// </summary>
+	/// <param name="reader">snapshot</param>
+	/// <returns>false if the next records are not a waveguide</returns>
+	bool loadstate(SnapshotReader& reader);
+
+private:
+	friend class MPnetwork;
+	static void saveheader(SnapshotWriter& writer, double damp, double out0, double out1);
+
+	// Records of a waveguide read from a snapshot, restored only once all of them have been read
+	struct SavedState
+	{
+		double damp, out0, out1;
+		RingBuffer<double>::SavedRing east, west;
+	};
+	static bool readstate(SnapshotReader& reader, SavedState& saved);
+	bool canrestore(const SavedState& saved) const;
+	void restorestate(const SavedState& saved);
+
+	double damping;
+	RingBuffer<double> eastbuffer;
+	RingBuffer<double> westbuffer;
+};
+
+/// <summary>
+/// Multi-port network element representing simple waveguide junction
+/// 
+/// This element is normally used as a junction among three or more waveguide elements. It
+/// can also be used to connect two waveguide elements, but this is simply equivalent to
+/// connecting the waveguides directly.
+/// </summary>
+class Junction : public MultiPort
+{
+public:
+	Junction() {};
+	~Junction() {}
+
+	/// <summary>
+	/// Compute output from current input
+	/// 
+	/// This method steps the junction through one sample cycle and updates the port outputs
+	/// </summary>
+	void step() override;
+
+	/// <summary>
+	/// Set number of ports
+	/// </summary>
+	/// <param name="numports">number of ports</param>
+	void setNumPorts(unsigned int numports);
+};
+
+
+/// <summary>
+/// Multiport element network consisting of interconnected waveguides and junctions
+/// 
+/// This class facilitates creation of networks of multiport elements. It currently supports
+/// networks of waveguides and junctions.
+/// 
+/// Once the network is connected, compile() converts it into a flat execution plan: all port
+/// values live in one contiguous state array, every connection is an integer index into it,
+/// and the delay lines share one block of memory. netstep() then runs the plan with plain
+/// loops instead of stepping each element through its virtual step() method. The output is
+/// identical either way. Changing the network after compile() discards the plan, carrying
+/// its state back into the elements.
+/// 
+/// A compiled network can also be split across several threads. Junctions only exchange
+/// signals through waveguides, so two groups of junctions joined by waveguides of delay D or
+/// more can run D samples ahead of each other. netstep(numsamples, ...) uses this slack: each
+/// thread steps its part of the network through a block of up to D samples, and the threads
+/// meet at a single barrier per block.
+/// </summary>
+class MPnetwork
+{
+public:
+	MPnetwork();
+	~MPnetwork();
+
+	// A copy of a compiled network is compiled with the same number of threads, and gets
+	// threads of its own
+	MPnetwork(const MPnetwork& other);
+	MPnetwork(MPnetwork&& other);
+	MPnetwork& operator=(const MPnetwork& other);
+	MPnetwork& operator=(MPnetwork&& other);
+
+	/// <summary>
+	/// Add junctions to the network
+	/// </summary>
+	/// <param name="numjunctions">number of junctions to add</param>
+	void addJunctions(unsigned int numjunctions);
+
+	/// <summary>
+	/// Add waveguides to the network
+	/// </summary>
+	/// <param name="numwaveguides">number of waveguides to add</param>
+	void addWaveguides(unsigned int numwaveguides);
+
+	/// <summary>
+	/// Set port count for a junction
+	/// </summary>
+	/// <param name="junctno">junction number</param>
+	/// <param name="numports">number of ports</param>
+	void setNumPorts(unsigned int junctno, unsigned int numports) { decompile(); junction[junctno].setNumPorts(numports); }
+
+	/// <summary>
+	/// Set waveguide sample delay and damping factor
+	/// </summary>
+	/// <param name="wgno">waveguide number</param>
+	/// <param name="delay">sample delay</param>
+	/// <param name="damping">damping</param>
+	void setWGparams(unsigned int wgno, unsigned int delay, double damping);
+
+	/// <summary>
+	/// Connect two junctions with a waveguide
+	/// 
+	/// Once junctions and waveguides have been added to the network, use this method
+	/// to establish the connections. Make sure all port inputs are either connected or 
+	/// grounded.
+	/// </summary>
+	/// <param name="wgno">waveguide number</param>
+	/// <param name="junct1">east junction number</param>
+	/// <param name="port1">east junction port number</param>
+	/// <param name="junct2">west junction number</param>
+	/// <param name="port2">west junction port number</param>
+	void connect(unsigned int wgno, unsigned int junct1, unsigned int port1, unsigned int junct2, unsigned int port2);
+
+	/// <summary>
+	/// Set junction input to ground (0.0)
+	/// 
+	/// Use this method if there is no input for a given port.
+	/// </summary>
+	/// <param name="junct">junction number</param>
+	/// <param name="port">port number</param>
+	void addground(unsigned int junct, unsigned int port) { decompile(); junction[junct].setGround(port); }
+
+	/// <summary>
+	/// Set junction input to source
+	/// 
+	/// Use this method for external inputs to the network.
+	/// </summary>
+	/// <param name="junct">junction number</param>
+	/// <param name="port">port number</param>
+	/// <param name="src">source</param>
+	void addsource(unsigned int junct, unsigned int port, std::shared_ptr<double> src);
+
+	/// <summary>
+	/// Add an output tap at a given junction and port
+	/// 
+	/// Taps are the outputs written by the block form of netstep().
+	/// </summary>
+	/// <param name="junct">junction number</param>
+	/// <param name="port">port number</param>
+	/// <returns>tap number</returns>
+	unsigned int addtap(unsigned int junct, unsigned int port);
+
+	/// <summary>
+	/// Get output from given junction and port
+	/// </summary>
+	/// <param name="junct">junction number</param>
+	/// <param name="port">port number</param>
+	/// <returns>output value</returns>
+	double getoutput(unsigned int junct, unsigned int port)
+	{
+		return compiled ? state[junctslot[junct] + port] : *junction[junct].getOutputPtr(port);
+	}
+
+	/// <summary>
+	/// Step every element in the network
+	/// 
+	/// This method steps the network through one sample cycle and updates all port outputs
+	/// </summary>
+	void netstep();
+
+	/// <summary>
+	/// Step the network through a block of samples
+	/// 
+	/// Sources are numbered in the order they were first passed to addsource(), and taps in
+	/// the order they were added with addtap(). A compiled network copies the input samples
+	/// straight into its plan and leaves the values held by the source pointers alone; an
+	/// uncompiled network writes each input sample through its source pointer before stepping,
+	/// so the variables behind those pointers are overwritten. A compiled network is stepped
+	/// by all of its threads, each running with the subnormal flushing mode of the calling
+	/// thread (see DenormalContext); otherwise, the elements are stepped one sample at a time.
+	/// The output is identical either way.
+	/// </summary>
+	/// <param name="numsamples">number of samples in the block</param>
+	/// <param name="insamples">array of pointers to samples for each source</param>
+	/// <param name="outsamples">array of pointers to samples for each tap</param>
+	void netstep(int numsamples, const float* const* insamples, float* const* outsamples);
+
+	/// <summary>
+	/// Compile the network into a flat execution plan
+	/// 
+	/// Call this once all elements have been added, set up and connected. The current state
+	/// of every element is carried into the plan. Unconnected inputs are treated as grounded.
+	/// 
+	/// With more than one thread, junctions are divided into contiguous ranges of junction
+	/// numbers, so number the junctions such that neighbours are close together (as in a
+	/// row-by-row mesh). The largest block stepped without synchronization is the shortest
+	/// delay among the waveguides that join different threads; see getblocklimit().
+	/// </summary>
+	/// <param name="numthreads">number of threads used by the block form of netstep()</param>
+	void compile(unsigned int numthreads = 1);
+
+	/// <summary>
+	/// Get the number of samples the threads of a compiled network can run between barriers
+	/// </summary>
+	/// <returns>samples per block (0 if not compiled)</returns>
+	unsigned int getblocklimit() { return compiled ? blocklimit : 0; }
+
+	/// <summary>
+	/// Check whether netstep() is running a compiled plan
+	/// </summary>
+	/// <returns>true if the network is compiled</returns>
+	bool iscompiled() { return compiled; }
+
+	/// <summary>
+	/// Write the state of every junction and waveguide to a snapshot
+	///
+	/// This works whether or not the network is compiled, and the snapshot may be restored into
+	/// a network of the same structure in either form. The bytes differ between the two forms,
+	/// since compiling enlarges the delay lines between threads, so compare states by restoring
+	/// them rather than by comparing snapshots. Sources are outside the network and are not saved.
+	/// </summary>
+	/// <param name="writer">snapshot</param>
+	void savestate(SnapshotWriter& writer) const;
+
+	/// <summary>
+	/// Restore everything written by savestate()
+	///
+	/// The network must already be built with the same junctions and waveguides. A compiled
+	/// network is compiled again, with the same number of threads. If any record does not
+	/// match, the state of the network is left unchanged.
+	/// </summary>
+	/// <param name="reader">snapshot</param>
+	/// <returns>false if the snapshot is not of a network of this structure</returns>
+	bool loadstate(SnapshotReader& reader);
+
+private:
+	// Delay line in one direction of a waveguide, as stored in the plan
+	struct PlanLine
+	{
+		unsigned int offset; // start of the line in delaymem
+		unsigned int mask; // capacity - 1 (capacity is a power of two)
+		unsigned int delay;
+		unsigned int input; // state index of the junction output feeding the line
+		double damping;
+		double gain; // 1 - damping
+		unsigned int element; // 2 * waveguide number + output port
+	};
+
+	// Junctions with the same number of ports; their outputs are contiguous in the state array
+	struct PlanGroup
+	{
+		unsigned int numports;
+		unsigned int numjunct;
+		unsigned int outbase; // state index of the first output
+		unsigned int inbase; // position of the first input index in junctinput
+	};
+
+	// Value copied into the state array each sample: a source, or a tap copied out of it
+	struct PlanCopy
+	{
+		unsigned int slot;
+		unsigned int index; // source or tap number
+	};
+
+	// Work done by one thread: its junctions, the lines they read and the lines they feed.
+	// Lines read by a part occupy a contiguous range of the plan.
+	struct PlanPart
+	{
+		unsigned int firstjunct, endjunct;
+		unsigned int firstgroup, endgroup;
+		unsigned int firstline, endline;
+		std::vector<unsigned int> feeds; // lines whose input is a junction of this part
+		std::vector<PlanCopy> sources;
+		std::vector<PlanCopy> taps;
+	};
+
+	void decompile();
+	void scatter(unsigned int firstgroup, unsigned int endgroup);
+	void steppart(unsigned int part, int start, int numsamples);
+	void runblocks(unsigned int part, int numsamples);
+	void worker(unsigned int part);
+	void barrier();
+	void startworkers();
+	void stopworkers();
+	template <typename N>
+	void takeplan(N&& other);
+
+	std::vector<Junction> junction;
+	std::vector<Waveguide> waveguide;
+	unsigned int numjunct;
+	unsigned int numwg;
+
+	// compiled plan
+	bool compiled;
+	std::vector<double> state; // every port output; state[0] is ground
+	std::vector<std::shared_ptr<double>> sources; // in the order of addsource()
+	std::vector<std::pair<unsigned int, unsigned int>> taps; // junction and port
+	std::vector<unsigned int> junctslot; // state index of port 0 output of each junction
+	std::vector<unsigned int> junctinput; // state index of every junction input, by group
+	std::vector<PlanGroup> groups;
+	std::vector<PlanLine> lines; // outputs at state[lineslot + line]
+	unsigned int lineslot;
+	std::vector<double> delaymem;
+	unsigned int tick; // write position shared by every delay line
+	std::vector<PlanPart> parts;
+	unsigned int blocklimit;
+
+	// inputs and outputs of the current block call
+	const float* const* callin;
+	float* const* callout;
+
+	// worker threads, one per part after the first (which runs on the calling thread); only
+	// a compiled network with more than one part has them
+	struct NetWorkers;
+	std::unique_ptr<NetWorkers> pool;
 };
\ No newline at end of file
@@ -0,0 +1,136 @@
+/*
+  ==============================================================================
+
+    OversampledSSfilter.cpp
+
+  ==============================================================================
+*/
+
+#include "OversampledSSfilter.h"
+#include "DSPkernels.h"
+#include <cmath>
+
+// Base rate samples per pass of procblock
+constexpr int OSCHUNK = 64;
+// Largest F1 used, as a fraction of the stability bound
+constexpr double OSSTABILITYMARGIN = 0.99;
+
+OversampledSSfilter::OversampledSSfilter()
+{
+	damping = 0.0;
+	Omegac = 0.0;
+	up[0].init(16);
+	up[1].init(6);
+	for (int j = 0; j < 3; j++)
+	{
+		down[0][j].init(16);
+		down[1][j].init(6);
+	}
+	setfactor(2);
+}
+
+bool OversampledSSfilter::setfactor(int factor)
+{
+	if (factor != 1 && factor != 2 && factor != 4)
+		return false;
+	this->factor = factor;
+	updateF1();
+	reset();
+	return true;
+}
+
+double OversampledSSfilter::getlatency() const
+{
+	// each stage delays by its filter length on the way up and again on the way down
+	double latency = 0.0;
+	if (factor >= 2)
+		latency += up[0].getlatency();
+	if (factor == 4)
+		latency += 0.5 * up[1].getlatency();
+	return latency;
+}
+
+void OversampledSSfilter::setdamping(double dmp)
+{
+	damping = dmp;
+	core.setdamping(dmp);
+	updateF1();
+}
+
+void OversampledSSfilter::setF1(double Omegac)
+{
+	this->Omegac = Omegac;
+	updateF1();
+}
+
+void OversampledSSfilter::updateF1()
+{
+	// The poles of the recursion stay inside the unit circle while
+	// F1 * F1 + 2 * damping * F1 < 4, that is F1 < sqrt(damping^2 + 4) - damping
+	const double limit = OSSTABILITYMARGIN * (std::sqrt(damping * damping + 4.0) - damping);
+	double omega = Omegac / factor;
+	if (2.0 * std::sin(omega / 2.0) > limit || omega > PI)
+		omega = 2.0 * std::asin(limit / 2.0);
+	core.setF1(omega);
+}
+
+void OversampledSSfilter::procblock(const float* insamples, float* hpsamples, float* bpsamples, float* lpsamples,
+	int numsamples)
+{
+	double in[OSCHUNK];
+	double mid[2 * OSCHUNK];
+	double high[4 * OSCHUNK];
+	double coreout[3][4 * OSCHUNK];
+	double out[OSCHUNK];
+	float* const outsamples[3] = { hpsamples, bpsamples, lpsamples };
+	for (int start = 0; start < numsamples; start += OSCHUNK)
+	{
+		const int len = numsamples - start < OSCHUNK ? numsamples - start : OSCHUNK;
+		convertsamples(insamples + start, in, len);
+		const double* corein = in;
+		if (factor == 2)
+		{
+			up[0].upsample(in, high, len);
+			corein = high;
+		}
+		else if (factor == 4)
+		{
+			up[0].upsample(in, mid, len);
+			up[1].upsample(mid, high, 2 * len);
+			corein = high;
+		}
+		double* coreptrs[3];
+		for (int j = 0; j < 3; j++)
+			coreptrs[j] = outsamples[j] ? coreout[j] : nullptr;
+		core.procblock(corein, coreptrs[0], coreptrs[1], coreptrs[2], factor * len);
+		for (int j = 0; j < 3; j++)
+		{
+			if (!outsamples[j])
+				continue;
+			const double* result = coreout[j];
+			if (factor == 2)
+			{
+				down[0][j].downsample(coreout[j], out, len);
+				result = out;
+			}
+			else if (factor == 4)
+			{
+				down[1][j].downsample(coreout[j], mid, 2 * len);
+				down[0][j].downsample(mid, out, len);
+				result = out;
+			}
+			convertsamples(result, outsamples[j] + start, len);
+		}
+	}
+}
+
+void OversampledSSfilter::reset()
+{
+	core.reset();
+	for (int k = 0; k < 2; k++)
+	{
+		up[k].reset();
+		for (int j = 0; j < 3; j++)
+			down[k][j].reset();
+	}
+}
@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+    OversampledSSfilter.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "HalfbandFilter.h"
+#include "SSfilter.h"
+
+/// <summary>
+/// State space filter run at two or four times the sampling rate
+///
+/// The SSfilter recursion is only stable while F1 * F1 + 2 * damping * F1 < 4, and its
+/// response is warped well before that, so high center frequencies call for a higher rate.
+/// Here only the filter core is oversampled: the input is upsampled by polyphase half-band
+/// filters (HalfbandFilter, 63 taps for the first factor of two and 23 for the second),
+/// filtered, and each output that is asked for is downsampled again. F1 at the high rate is
+/// also limited to just inside the stability bound, so the filter stays stable for any
+/// center frequency up to the Nyquist frequency and any damping.
+/// </summary>
+class OversampledSSfilter
+{
+public:
+	OversampledSSfilter();
+	~OversampledSSfilter() {}
+
+	/// <summary>
+	/// Set oversampling factor
+	///
+	/// The filter is reset.
+	/// </summary>
+	/// <param name="factor">oversampling factor (1, 2 or 4)</param>
+	/// <returns>false if the factor is not supported</returns>
+	bool setfactor(int factor);
+
+	/// <summary>
+	/// Get oversampling factor
+	/// </summary>
+	/// <returns>oversampling factor</returns>
+	int getfactor() const { return factor; }
+
+	/// <summary>
+	/// Get delay added by the half-band filters
+	/// </summary>
+	/// <returns>delay in samples at the base sampling rate</returns>
+	double getlatency() const;
+
+	/// <summary>
+	/// Set damping parameter
+	/// </summary>
+	/// <param name="dmp">damping parameter (no units)</param>
+	void setdamping(double dmp);
+
+	/// <summary>
+	/// Set center frequency
+	/// </summary>
+	/// <param name="fc">center or cutoff frequency (Hz)</param>
+	/// <param name="fs">base sampling frequency (Hz)</param>
+	void setF1(double fc, double fs) { setF1(2.0 * PI * fc / fs); }
+
+	/// <summary>
+	/// Set center frequency
+	/// </summary>
+	/// <param name="Omegac">center frequency at the base sampling rate (radians/sample)</param>
+	void setF1(double Omegac);
+
+	/// <summary>
+	/// Process a block of samples through filter
+	///
+	/// Any of the output pointers may be nullptr if that output is not needed; only the outputs
+	/// asked for are downsampled, so an output should be asked for in every block or in none.
+	/// </summary>
+	/// <param name="insamples">pointer to first input sample</param>
+	/// <param name="hpsamples">pointer to first high-pass output sample</param>
+	/// <param name="bpsamples">pointer to first band-pass output sample</param>
+	/// <param name="lpsamples">pointer to first low-pass output sample</param>
+	/// <param name="numsamples">number of samples in the block</param>
+	void procblock(const float* insamples, float* hpsamples, float* bpsamples, float* lpsamples, int numsamples);
+
+	/// <summary>
+	/// Reset filter and resampling history
+	/// </summary>
+	void reset();
+
+private:
+	void updateF1();
+
+	int factor;
+	double damping;
+	double Omegac;
+	SSfilter core;
+	// first and second factor of two: one upsampler, and a downsampler per output
+	HalfbandFilter up[2];
+	HalfbandFilter down[2][3];
+};
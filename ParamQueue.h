@@ -0,0 +1,163 @@
+/*
+  ==============================================================================
+
+    ParamQueue.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <type_traits>
+
+// Size of a cache line, to keep the two ends of a queue from sharing one
+constexpr int PARAMCACHELINE = 64;
+
+/// <summary>
+/// Wait-free queue of parameter changes from one control thread to one audio thread
+///
+/// The filter classes are not thread safe: calling LPcombfilter::setreflection() or
+/// DelayLine::setsampledelay() on one thread while another is inside step() or procblock() is
+/// a data race. Instead, the control thread pushes a small message describing the change, and
+/// the audio thread pops the messages at the start of each block and applies them, so every
+/// change lands on a block boundary. Messages are copied into a fixed array of N slots, so
+/// neither side ever allocates, locks or waits: push() fails when the queue is full and pop()
+/// when it is empty.
+///
+/// Exactly one thread may push and one thread may pop. The message type must be trivially
+/// copyable.
+/// </summary>
+template <typename T, unsigned int N = 256>
+class ParamQueue
+{
+	static_assert(std::is_trivially_copyable<T>::value, "messages must be trivially copyable");
+	static_assert(N >= 2 && (N & (N - 1)) == 0, "the number of slots must be a power of two");
+
+public:
+	ParamQueue() : writepos(0), readpos(0) {}
+	~ParamQueue() {}
+
+	/// <summary>
+	/// Add a message (control thread)
+	/// </summary>
+	/// <param name="message">message</param>
+	/// <returns>false if the queue is full</returns>
+	bool push(const T& message)
+	{
+		const unsigned int w = writepos.load(std::memory_order_relaxed);
+		if (w - readpos.load(std::memory_order_acquire) == N)
+			return false;
+		slots[w & (N - 1)] = message;
+		writepos.store(w + 1, std::memory_order_release);
+		return true;
+	}
+
+	/// <summary>
+	/// Take the oldest message (audio thread)
+	/// </summary>
+	/// <param name="message">message (output)</param>
+	/// <returns>false if the queue is empty</returns>
+	bool pop(T& message)
+	{
+		const unsigned int r = readpos.load(std::memory_order_relaxed);
+		if (r == writepos.load(std::memory_order_acquire))
+			return false;
+		message = slots[r & (N - 1)];
+		readpos.store(r + 1, std::memory_order_release);
+		return true;
+	}
+
+	/// <summary>
+	/// Apply every waiting message in order (audio thread)
+	///
+	/// Messages pushed while this runs are left for the next call, so the time taken is
+	/// bounded by the queue size.
+	/// </summary>
+	/// <param name="apply">function called with each message</param>
+	/// <returns>number of messages applied</returns>
+	template <typename F>
+	unsigned int popall(F&& apply)
+	{
+		const unsigned int r = readpos.load(std::memory_order_relaxed);
+		const unsigned int w = writepos.load(std::memory_order_acquire);
+		for (unsigned int k = r; k != w; k++)
+			apply(static_cast<const T&>(slots[k & (N - 1)]));
+		readpos.store(w, std::memory_order_release);
+		return w - r;
+	}
+
+private:
+	T slots[N];
+	alignas(PARAMCACHELINE) std::atomic<unsigned int> writepos;
+	alignas(PARAMCACHELINE) std::atomic<unsigned int> readpos;
+};
+
+/// <summary>
+/// Coefficient set handed from one control thread to one audio thread
+///
+/// For changes that touch many coefficients at once, such as redesigning every section of an
+/// SOSfilter, the control thread fills a complete new set with edit() and makes it current with
+/// publish(); the audio thread calls acquire() at the start of each block and then reads get()
+/// for the rest of the block. A set is swapped in whole, never half written. Besides the set
+/// in use and the set being edited there is a third, the latest published set, so the control
+/// thread may publish again before the audio thread has picked the last one up: neither side
+/// waits, and the audio thread always gets the newest set. Exchanging the slots is a single
+/// atomic operation, and the sets are members, so nothing is allocated.
+/// </summary>
+template <typename T>
+class ParamSwap
+{
+public:
+	ParamSwap() : editslot(1), readslot(0), latest(2) {}
+	~ParamSwap() {}
+
+	/// <summary>
+	/// Get the set being edited (control thread)
+	///
+	/// The set holds whatever it last held, not necessarily the current coefficients.
+	/// </summary>
+	/// <returns>set to fill in</returns>
+	T& edit() { return sets[editslot]; }
+
+	/// <summary>
+	/// Make the edited set the newest one (control thread)
+	/// </summary>
+	void publish()
+	{
+		editslot = latest.exchange(editslot | NEWSET, std::memory_order_acq_rel) & SLOTMASK;
+	}
+
+	/// <summary>
+	/// Swap in the newest set if one was published since the last call (audio thread)
+	/// </summary>
+	/// <returns>true if get() now returns a new set</returns>
+	bool acquire()
+	{
+		if (!(latest.load(std::memory_order_relaxed) & NEWSET))
+			return false;
+		readslot = latest.exchange(readslot, std::memory_order_acq_rel) & SLOTMASK;
+		return true;
+	}
+
+	/// <summary>
+	/// Get the current set (audio thread)
+	/// </summary>
+	/// <returns>set in use</returns>
+	const T& get() const { return sets[readslot]; }
+
+	/// <summary>
+	/// Get the current set for initialization, before the audio thread starts
+	/// </summary>
+	/// <returns>set in use</returns>
+	T& initial() { return sets[readslot]; }
+
+private:
+	static constexpr unsigned int SLOTMASK = 3;
+	static constexpr unsigned int NEWSET = 4;
+
+	T sets[3];
+	unsigned int editslot; // owned by the control thread
+	alignas(PARAMCACHELINE) unsigned int readslot; // owned by the audio thread
+	alignas(PARAMCACHELINE) std::atomic<unsigned int> latest; // slot index, and NEWSET once published
+};
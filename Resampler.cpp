@@ -0,0 +1,149 @@
+/*
+  ==============================================================================
+
+    Resampler.cpp
+
+  ==============================================================================
+*/
+
+#include "Resampler.h"
+#include "DSPkernels.h"
+#include "HalfbandFilter.h"
+#include <algorithm>
+#include <cmath>
+
+// Input samples per pass
+constexpr int RSCHUNK = 256;
+// Outputs per kernel call
+constexpr int RSBATCH = 64;
+// Kaiser window parameter, for about 80 dB of stopband attenuation
+constexpr double RSKAISERBETA = 8.0;
+// Stopband attenuation (dB) of that window, for the width of the transition band
+constexpr double RSATTENUATION = 81.3;
+
+static int gcd(int a, int b)
+{
+	while (b)
+	{
+		const int r = a % b;
+		a = b;
+		b = r;
+	}
+	return a;
+}
+
+Resampler::Resampler()
+{
+	init(48000, 48000);
+}
+
+bool Resampler::init(int inrate, int outrate, int halflength)
+{
+	if (inrate <= 0 || outrate <= 0)
+		return false;
+	const int g = gcd(inrate, outrate);
+	if (outrate / g > MAXRESAMPLEPHASES)
+		return false;
+	interp = outrate / g;
+	decim = inrate / g;
+	halflength = halflength > 0 ? halflength : 1;
+	// the filter spans halflength samples of the lower rate each side of its center
+	const long long span = (2LL * halflength * std::max(interp, decim) + interp - 1) / interp;
+	numtaps = int((span + POLYPHASETAPS - 1) / POLYPHASETAPS * POLYPHASETAPS);
+
+	// Prototype filter at L times the input rate. The transition band of the Kaiser window
+	// ends at the lower Nyquist frequency, and the cutoff is at its center.
+	const double pi = 3.141592653589793238463;
+	const int length = numtaps * interp;
+	const double center = 0.5 * (length - 1);
+	const double nyquist = pi / std::max(interp, decim);
+	const double transition = (RSATTENUATION - 7.95) / (2.285 * (length - 1));
+	const double omegac = std::max(nyquist - 0.5 * transition, 0.5 * nyquist);
+	std::vector<double> h(length);
+	double sum = 0.0;
+	for (int i = 0; i < length; i++)
+	{
+		const double t = i - center;
+		const double sinc = t == 0.0 ? omegac / pi : std::sin(omegac * t) / (pi * t);
+		h[i] = sinc * kaiserwindow(t / center, RSKAISERBETA);
+		sum += h[i];
+	}
+	// unity gain at DC for every branch on average; branch p holds taps p, p + L, ... reversed
+	const double scale = center > 0.0 ? interp / sum : 1.0;
+	rows.resize(std::size_t(interp) * numtaps);
+	for (int p = 0; p < interp; p++)
+		for (int k = 0; k < numtaps; k++)
+			rows[std::size_t(p) * numtaps + k] = scale * h[p + (numtaps - 1 - k) * interp];
+
+	history.resize(numtaps - 1 + RSCHUNK);
+	offsets.resize(RSBATCH);
+	rowptrs.resize(RSBATCH);
+	convin.resize(RSCHUNK);
+	convout.resize(getmaxoutput(RSCHUNK));
+	reset();
+	return true;
+}
+
+double Resampler::getlatency() const
+{
+	return 0.5 * (double(numtaps) * interp - 1.0) / interp;
+}
+
+int Resampler::getmaxoutput(int numsamples) const
+{
+	return int((long long)numsamples * interp / decim) + 1;
+}
+
+int Resampler::procblock(const float* insamples, int numsamples, float* outsamples)
+{
+	const DSPkernels& kernels = getkernels();
+	int numout = 0;
+	for (int start = 0; start < numsamples; start += RSCHUNK)
+	{
+		const int len = numsamples - start < RSCHUNK ? numsamples - start : RSCHUNK;
+		kernels.floattodouble(insamples + start, convin.data(), len);
+		const int count = procblock(convin.data(), len, convout.data());
+		kernels.doubletofloat(convout.data(), outsamples + numout, count);
+		numout += count;
+	}
+	return numout;
+}
+
+int Resampler::procblock(const double* insamples, int numsamples, double* outsamples)
+{
+	const DSPkernels& kernels = getkernels();
+	const int H = numtaps - 1;
+	int numout = 0;
+	for (int start = 0; start < numsamples; start += RSCHUNK)
+	{
+		const int len = numsamples - start < RSCHUNK ? numsamples - start : RSCHUNK;
+		std::copy(insamples + start, insamples + start + len, &history[H]);
+		// every output whose newest input sample is in this chunk; output n of the high rate
+		// stream is input sample n / L of branch n % L, and the outputs kept are M apart
+		while (inpos < len)
+		{
+			int count = 0;
+			while (inpos < len && count < RSBATCH)
+			{
+				offsets[count] = inpos;
+				rowptrs[count] = &rows[std::size_t(phase) * numtaps];
+				count++;
+				phase += decim;
+				inpos += phase / interp;
+				phase %= interp;
+			}
+			kernels.polyphase(history.data(), offsets.data(), rowptrs.data(), numtaps, outsamples + numout, count);
+			numout += count;
+		}
+		inpos -= len;
+		std::copy(&history[len], &history[len + H], history.begin());
+	}
+	return numout;
+}
+
+void Resampler::reset()
+{
+	std::fill(history.begin(), history.end(), 0.0);
+	inpos = 0;
+	phase = 0;
+}
@@ -0,0 +1,117 @@
+/*
+  ==============================================================================
+
+    Resampler.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <vector>
+
+// Largest number of polyphase branches (output rate divided by the greatest common divisor of
+// the two rates)
+constexpr int MAXRESAMPLEPHASES = 4096;
+
+/// <summary>
+/// Polyphase sample rate converter for any rational ratio
+///
+/// The rates are reduced to a ratio L / M (44100 to 48000 Hz is 160 / 147). Conceptually the
+/// input is upsampled by L, lowpass filtered at the lower of the two Nyquist frequencies and
+/// downsampled by M; in polyphase form only the filter outputs that are kept are computed,
+/// each one a dot product of a block of input samples with one of the L branches of a
+/// Kaiser windowed sinc. The dot products run in the DSPkernels::polyphase kernel.
+///
+/// Blocks of any length may be passed: the input is consumed completely, and each call
+/// returns as many output samples as the input so far allows, so the number of outputs of
+/// successive equal blocks differs by one from time to time. This lets a processing graph run
+/// at a rate of its own, with one Resampler on the way in and one on the way out; filters are
+/// designed once for that rate, and expensive networks such as an MPnetwork can run at a lower
+/// rate than the audio interface. An object keeps the history of one stream.
+/// </summary>
+class Resampler
+{
+public:
+	Resampler();
+	~Resampler() {}
+
+	/// <summary>
+	/// Design the converter
+	///
+	/// The stopband of the filter starts at the lower Nyquist frequency, with about 80 dB of
+	/// attenuation. With a half length of 32 the passband extends to 0.84 of the lower Nyquist
+	/// frequency (18.5 kHz from 44.1 kHz); longer filters have a narrower transition band. The
+	/// history is cleared.
+	/// </summary>
+	/// <param name="inrate">input sampling frequency (Hz)</param>
+	/// <param name="outrate">output sampling frequency (Hz)</param>
+	/// <param name="halflength">length of the filter each side of its center, in samples of the lower rate</param>
+	/// <returns>false if a rate is not positive or the ratio needs more than MAXRESAMPLEPHASES branches</returns>
+	bool init(int inrate, int outrate, int halflength = 32);
+
+	/// <summary>
+	/// Get upsampling factor of the reduced ratio
+	/// </summary>
+	/// <returns>L</returns>
+	int getinterpolation() const { return interp; }
+
+	/// <summary>
+	/// Get downsampling factor of the reduced ratio
+	/// </summary>
+	/// <returns>M</returns>
+	int getdecimation() const { return decim; }
+
+	/// <summary>
+	/// Get delay of the filter
+	/// </summary>
+	/// <returns>delay in samples at the input sampling rate</returns>
+	double getlatency() const;
+
+	/// <summary>
+	/// Get the largest number of outputs a block can produce
+	/// </summary>
+	/// <param name="numsamples">number of input samples</param>
+	/// <returns>size the output buffer needs</returns>
+	int getmaxoutput(int numsamples) const;
+
+	/// <summary>
+	/// Convert a block of samples
+	/// </summary>
+	/// <param name="insamples">pointer to first input sample</param>
+	/// <param name="numsamples">number of input samples</param>
+	/// <param name="outsamples">pointer to first output sample (room for getmaxoutput(numsamples))</param>
+	/// <returns>number of output samples</returns>
+	int procblock(const float* insamples, int numsamples, float* outsamples);
+
+	/// <summary>
+	/// Convert a block of samples
+	/// </summary>
+	/// <param name="insamples">pointer to first input sample</param>
+	/// <param name="numsamples">number of input samples</param>
+	/// <param name="outsamples">pointer to first output sample (room for getmaxoutput(numsamples))</param>
+	/// <returns>number of output samples</returns>
+	int procblock(const double* insamples, int numsamples, double* outsamples);
+
+	/// <summary>
+	/// Clear history
+	/// </summary>
+	void reset();
+
+private:
+	int interp;
+	int decim;
+	int numtaps; // per branch
+	std::vector<double> rows; // interp branches of numtaps coefficients, in input order
+	// input after numtaps - 1 samples of history
+	std::vector<double> history;
+	// input position and branch of each output of a kernel call
+	std::vector<int> offsets;
+	std::vector<const double*> rowptrs;
+	// double precision blocks for the float version
+	std::vector<double> convin;
+	std::vector<double> convout;
+	// next output: input sample (relative to the current chunk) and branch
+	int inpos;
+	int phase;
+};
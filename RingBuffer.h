@@ -0,0 +1,371 @@
+/*
+  ==============================================================================
+
+    RingBuffer.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstring>
+#include <vector>
+#include "DelayArena.h"
+#include "StateSnapshot.h"
+
+// Largest block moved in one piece by the procblock methods of the delay classes
+constexpr unsigned int RINGCHUNK = 256;
+
+/// <summary>
+/// Circular buffer used as the core of the delay line classes
+///
+/// The capacity is always a power of two, so the write position wraps with a mask rather than
+/// an integer division. The buffer provides a delayed output tap: read() returns the sample
+/// written getdelay() writes ago. For block processing, the next samples to be read or written
+/// are available as (at most) two contiguous spans, so whole blocks can be moved with memcpy or
+/// vector loads.
+///
+/// The buffer normally owns its storage and grows as needed. After reserve() with a
+/// DelayArena, the storage is a region of the arena instead and never changes again: delays
+/// are limited to the reserved capacity, so setting them never allocates.
+/// </summary>
+template <typename T>
+class RingBuffer
+{
+public:
+	/// <summary>
+	/// Part of the buffer split into at most two contiguous segments
+	/// </summary>
+	struct Span
+	{
+		T* first;
+		unsigned int firstlen;
+		T* second;
+		unsigned int secondlen;
+	};
+
+	RingBuffer()
+	{
+		owned.assign(1, T(0));
+		buffer = owned.data();
+		fixed = false;
+		mask = 0;
+		writepos = 0;
+		delay = 1;
+	}
+	~RingBuffer() {}
+
+	// A copy always owns its storage, so two buffers never share a region of an arena
+	RingBuffer(const RingBuffer& other) { copyfrom(other); }
+	RingBuffer& operator=(const RingBuffer& other)
+	{
+		if (this != &other)
+			copyfrom(other);
+		return *this;
+	}
+
+	/// <summary>
+	/// Set delay
+	///
+	/// The capacity grows to the next power of two if necessary. Samples already in the buffer are
+	/// kept, so changing the delay moves the output tap.
+	/// </summary>
+	/// <param name="D">delay in samples (at least 1)</param>
+	void setdelay(unsigned int D)
+	{
+		delay = D > 0 ? D : 1;
+		if (delay > mask + 1)
+		{
+			if (fixed)
+				delay = mask + 1;
+			else
+				grow(delay);
+		}
+	}
+
+	/// <summary>
+	/// Reserve capacity for a maximum delay
+	///
+	/// Samples already in the buffer are kept. With an arena, the storage moves to a region
+	/// of the arena and stays there; without one, the buffer grows now rather than when the
+	/// delay is set.
+	/// </summary>
+	/// <param name="maxdelay">maximum delay in samples</param>
+	/// <param name="arena">arena to take the storage from (may be nullptr)</param>
+	/// <returns>false if the arena does not have enough room left (the buffer is unchanged)</returns>
+	bool reserve(unsigned int maxdelay, DelayArena* arena = nullptr)
+	{
+		if (!arena)
+		{
+			if (maxdelay > mask + 1 && !fixed)
+				grow(maxdelay);
+			return true;
+		}
+		const std::size_t bytes = DelayArena::bytesfor<T>(maxdelay);
+		T* region = static_cast<T*>(arena->allocate(bytes));
+		if (!region)
+			return false;
+		unsigned int capacity = 1;
+		while (capacity < maxdelay)
+			capacity <<= 1;
+		relocate(region, capacity);
+		owned.clear();
+		owned.shrink_to_fit();
+		fixed = true;
+		if (delay > capacity)
+			delay = capacity;
+		return true;
+	}
+
+	/// <summary>
+	/// Get delay
+	/// </summary>
+	/// <returns>delay in samples</returns>
+	unsigned int getdelay() const { return delay; }
+
+	/// <summary>
+	/// Get capacity
+	/// </summary>
+	/// <returns>number of samples the buffer can hold</returns>
+	unsigned int getcapacity() const { return mask + 1; }
+
+	/// <summary>
+	/// Clear buffer
+	/// </summary>
+	void clear()
+	{
+		for (unsigned int n = 0; n <= mask; n++)
+			buffer[n] = T(0);
+		writepos = 0;
+	}
+
+	/// <summary>
+	/// Read delayed sample
+	/// </summary>
+	/// <returns>sample written getdelay() writes ago</returns>
+	T read() const { return buffer[(writepos - delay) & mask]; }
+
+	/// <summary>
+	/// Read sample at a given delay
+	/// </summary>
+	/// <param name="D">delay in samples (1 to capacity)</param>
+	/// <returns>sample written D writes ago</returns>
+	T read(unsigned int D) const { return buffer[(writepos - D) & mask]; }
+
+	/// <summary>
+	/// Write a sample
+	/// </summary>
+	/// <param name="x">sample</param>
+	void write(T x)
+	{
+		buffer[writepos] = x;
+		writepos = (writepos + 1) & mask;
+	}
+
+	/// <summary>
+	/// Get the delayed samples for the next block
+	///
+	/// These are the samples read() would return for the next numsamples writes, provided
+	/// numsamples does not exceed the delay.
+	/// </summary>
+	/// <param name="numsamples">number of samples (at most getdelay())</param>
+	/// <returns>span of delayed samples</returns>
+	Span readspans(unsigned int numsamples) { return spans((writepos - delay) & mask, numsamples); }
+
+	/// <summary>
+	/// Get the positions written by the next block
+	///
+	/// Fill the spans, then call advance(). Filling them does not disturb readspans(numsamples)
+	/// as long as numsamples does not exceed the delay.
+	/// </summary>
+	/// <param name="numsamples">number of samples (at most the capacity)</param>
+	/// <returns>span of positions to be written</returns>
+	Span writespans(unsigned int numsamples) { return spans(writepos, numsamples); }
+
+	/// <summary>
+	/// Move the write position on after filling writespans()
+	/// </summary>
+	/// <param name="numsamples">number of samples written</param>
+	void advance(unsigned int numsamples) { writepos = (writepos + numsamples) & mask; }
+
+	/// <summary>
+	/// Copy the delayed samples for the next block out of the buffer
+	/// </summary>
+	/// <param name="dest">destination</param>
+	/// <param name="numsamples">number of samples (at most getdelay())</param>
+	void readblock(T* dest, unsigned int numsamples)
+	{
+		Span span = readspans(numsamples);
+		std::memcpy(dest, span.first, span.firstlen * sizeof(T));
+		std::memcpy(dest + span.firstlen, span.second, span.secondlen * sizeof(T));
+	}
+
+	/// <summary>
+	/// Write a block of samples and advance
+	/// </summary>
+	/// <param name="src">samples to write</param>
+	/// <param name="numsamples">number of samples (at most the capacity)</param>
+	void writeblock(const T* src, unsigned int numsamples)
+	{
+		Span span = writespans(numsamples);
+		std::memcpy(span.first, src, span.firstlen * sizeof(T));
+		std::memcpy(span.second, src + span.firstlen, span.secondlen * sizeof(T));
+		advance(numsamples);
+	}
+
+	/// <summary>
+	/// Write the delay and the samples in the buffer to a snapshot
+	/// </summary>
+	/// <param name="writer">snapshot</param>
+	void savestate(SnapshotWriter& writer) const { savesamples(writer, buffer, mask + 1, writepos, delay); }
+
+	/// <summary>
+	/// Write a ring of samples to a snapshot in the layout of savestate()
+	///
+	/// This is for classes that keep their delay lines in storage of their own, such as a
+	/// compiled MPnetwork.
+	/// </summary>
+	/// <param name="writer">snapshot</param>
+	/// <param name="samples">first sample of the ring</param>
+	/// <param name="capacity">number of samples in the ring (a power of two)</param>
+	/// <param name="position">position of the next write</param>
+	/// <param name="D">delay in samples</param>
+	static void savesamples(SnapshotWriter& writer, const T* samples, unsigned int capacity, unsigned int position,
+		unsigned int D)
+	{
+		writer.begin(snapshottag("RING"));
+		writer.put(std::uint32_t(sizeof(T)));
+		writer.put(std::uint32_t(capacity));
+		writer.put(std::uint32_t(position & (capacity - 1)));
+		writer.put(std::uint32_t(D));
+		writer.put(samples, capacity);
+		writer.end();
+	}
+
+	/// <summary>
+	/// Ring of samples read from a snapshot by readstate(), ready to be restored
+	/// </summary>
+	struct SavedRing
+	{
+		const T* samples;
+		unsigned int capacity;
+		unsigned int position;
+		unsigned int delay;
+	};
+
+	/// <summary>
+	/// Read a ring of samples written by savestate() without restoring it
+	///
+	/// The samples are left in the snapshot, so the reader must stay valid until they are
+	/// restored. Objects with several buffers read every record first, and restore them only
+	/// once all of them have been read and fit, so a failed load changes nothing.
+	/// </summary>
+	/// <param name="reader">snapshot</param>
+	/// <param name="saved">ring read from the snapshot (output)</param>
+	/// <returns>false if the next record is not a buffer of this type</returns>
+	static bool readstate(SnapshotReader& reader, SavedRing& saved)
+	{
+		std::uint32_t size, capacity, position, D;
+		if (!reader.begin(snapshottag("RING")) || !reader.get(size) || !reader.get(capacity) || !reader.get(position)
+			|| !reader.get(D))
+			return false;
+		if (size != sizeof(T) || capacity == 0 || (capacity & (capacity - 1)) != 0 || D == 0 || D > capacity)
+			return false;
+		const T* samples = reader.getarray<T>(capacity);
+		if (!samples || !reader.end())
+			return false;
+		saved = SavedRing{ samples, capacity, position, D };
+		return true;
+	}
+
+	/// <summary>
+	/// Check that a saved ring can be restored into this buffer
+	/// </summary>
+	/// <param name="saved">ring read by readstate()</param>
+	/// <returns>false if the storage is in an arena and the saved delay is beyond its capacity</returns>
+	bool canrestore(const SavedRing& saved) const { return !fixed || saved.delay <= mask + 1; }
+
+	/// <summary>
+	/// Restore the delay and the samples of a saved ring
+	///
+	/// The buffer grows if it must to hold the saved delay. If the saved buffer is larger, only
+	/// the most recent samples that fit are restored. Check canrestore() first.
+	/// </summary>
+	/// <param name="saved">ring read by readstate()</param>
+	void restorestate(const SavedRing& saved)
+	{
+		if (saved.delay > mask + 1)
+			grow(saved.delay);
+		delay = saved.delay;
+		clear();
+		const unsigned int count = saved.capacity < mask + 1 ? saved.capacity : mask + 1;
+		for (unsigned int k = count; k >= 1; k--)
+			write(saved.samples[(saved.position - k) & (saved.capacity - 1)]);
+	}
+
+	/// <summary>
+	/// Restore the delay and the samples from a snapshot
+	///
+	/// The buffer grows if it must to hold the saved delay, unless its storage is in an arena,
+	/// in which case a saved delay beyond the capacity fails. If the saved buffer is larger,
+	/// only the most recent samples that fit are restored.
+	/// </summary>
+	/// <param name="reader">snapshot</param>
+	/// <returns>false if the next record is not a buffer of this type, or does not fit</returns>
+	bool loadstate(SnapshotReader& reader)
+	{
+		SavedRing saved;
+		if (!readstate(reader, saved) || !canrestore(saved))
+			return false;
+		restorestate(saved);
+		return true;
+	}
+
+private:
+	Span spans(unsigned int start, unsigned int numsamples)
+	{
+		unsigned int capacity = mask + 1;
+		unsigned int firstlen = capacity - start < numsamples ? capacity - start : numsamples;
+		return Span{ &buffer[start], firstlen, buffer, numsamples - firstlen };
+	}
+
+	void grow(unsigned int minsize)
+	{
+		unsigned int capacity = 1;
+		while (capacity < minsize)
+			capacity <<= 1;
+		std::vector<T> newbuffer(capacity, T(0));
+		relocate(newbuffer.data(), capacity);
+		owned.swap(newbuffer);
+	}
+
+	// Copy the samples to new storage, keeping them in the same order relative to the write
+	// position
+	void relocate(T* newbuffer, unsigned int capacity)
+	{
+		unsigned int oldsize = mask + 1;
+		unsigned int count = oldsize < capacity ? oldsize : capacity;
+		for (unsigned int k = 1; k <= count; k++)
+			newbuffer[(count - k) & (capacity - 1)] = buffer[(writepos - k) & mask];
+		buffer = newbuffer;
+		mask = capacity - 1;
+		writepos = count & mask;
+	}
+
+	void copyfrom(const RingBuffer& other)
+	{
+		owned.assign(other.buffer, other.buffer + other.mask + 1);
+		buffer = owned.data();
+		fixed = false;
+		mask = other.mask;
+		writepos = other.writepos;
+		delay = other.delay;
+	}
+
+	std::vector<T> owned; // storage, unless it is in an arena
+	T* buffer;
+	bool fixed; // storage is in an arena
+	unsigned int mask;
+	unsigned int writepos;
+	unsigned int delay;
+};
@@ -0,0 +1,177 @@
+/*
+  ==============================================================================
+
+    SIMDlanes.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+// Vectors of double precision lanes for each instruction set: lanevec128 (SSE2 or NEON,
+// 2 lanes), lanevec256 (AVX, 4 lanes) and lanevec512 (AVX-512, 8 lanes). The x86 types can
+// be used in any build: their methods carry target attributes, so they may be called from
+// kernels compiled for that instruction set (see DSPkernels.cpp) even when the rest of the
+// program is not. lanevec is the widest type enabled at compile time. Only basic arithmetic
+// is provided. Fused multiply-add is deliberately not used, so results round exactly like
+// the equivalent scalar code.
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LANES_X86
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define LANES_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(__GNUC__)
+#define LANES_TARGET(isa) __attribute__((target(isa)))
+#define LANES_INLINE inline __attribute__((always_inline))
+#elif defined(_MSC_VER)
+#define LANES_TARGET(isa)
+#define LANES_INLINE __forceinline
+#else
+#define LANES_TARGET(isa)
+#define LANES_INLINE inline
+#endif
+
+#if defined(LANES_X86)
+/// <summary>
+/// SSE2 vector of 2 double precision values
+/// </summary>
+struct lanevec128
+{
+	__m128d v;
+	static constexpr int lanes = 2;
+
+	lanevec128() {}
+	LANES_TARGET("sse2") inline lanevec128(__m128d x) : v(x) {}
+
+	/// <summary>
+	/// Set every lane to the same value
+	/// </summary>
+	/// <param name="x">value</param>
+	/// <returns>vector</returns>
+	LANES_TARGET("sse2") static inline lanevec128 broadcast(double x) { return _mm_set1_pd(x); }
+
+	/// <summary>
+	/// Load values (no alignment required)
+	/// </summary>
+	/// <param name="p">pointer to first value</param>
+	/// <returns>vector</returns>
+	LANES_TARGET("sse2") static inline lanevec128 load(const double* p) { return _mm_loadu_pd(p); }
+
+	/// <summary>
+	/// Store values (no alignment required)
+	/// </summary>
+	/// <param name="p">pointer to first value</param>
+	LANES_TARGET("sse2") inline void store(double* p) const { _mm_storeu_pd(p, v); }
+};
+
+LANES_TARGET("sse2") inline lanevec128 operator+(lanevec128 x, lanevec128 y) { return _mm_add_pd(x.v, y.v); }
+LANES_TARGET("sse2") inline lanevec128 operator-(lanevec128 x, lanevec128 y) { return _mm_sub_pd(x.v, y.v); }
+LANES_TARGET("sse2") inline lanevec128 operator*(lanevec128 x, lanevec128 y) { return _mm_mul_pd(x.v, y.v); }
+LANES_TARGET("sse2") inline lanevec128 operator/(lanevec128 x, lanevec128 y) { return _mm_div_pd(x.v, y.v); }
+// lanes of x that are NaN are replaced by the corresponding lanes of alt
+LANES_TARGET("sse2") inline lanevec128 ifnan(lanevec128 x, lanevec128 alt)
+{
+	__m128d ord = _mm_cmpord_pd(x.v, x.v);
+	return _mm_or_pd(_mm_and_pd(ord, x.v), _mm_andnot_pd(ord, alt.v));
+}
+
+/// <summary>
+/// AVX vector of 4 double precision values
+/// </summary>
+struct lanevec256
+{
+	__m256d v;
+	static constexpr int lanes = 4;
+
+	lanevec256() {}
+	LANES_TARGET("avx") inline lanevec256(__m256d x) : v(x) {}
+	LANES_TARGET("avx") static inline lanevec256 broadcast(double x) { return _mm256_set1_pd(x); }
+	LANES_TARGET("avx") static inline lanevec256 load(const double* p) { return _mm256_loadu_pd(p); }
+	LANES_TARGET("avx") inline void store(double* p) const { _mm256_storeu_pd(p, v); }
+};
+
+LANES_TARGET("avx") inline lanevec256 operator+(lanevec256 x, lanevec256 y) { return _mm256_add_pd(x.v, y.v); }
+LANES_TARGET("avx") inline lanevec256 operator-(lanevec256 x, lanevec256 y) { return _mm256_sub_pd(x.v, y.v); }
+LANES_TARGET("avx") inline lanevec256 operator*(lanevec256 x, lanevec256 y) { return _mm256_mul_pd(x.v, y.v); }
+LANES_TARGET("avx") inline lanevec256 operator/(lanevec256 x, lanevec256 y) { return _mm256_div_pd(x.v, y.v); }
+LANES_TARGET("avx") inline lanevec256 ifnan(lanevec256 x, lanevec256 alt)
+{
+	return _mm256_blendv_pd(alt.v, x.v, _mm256_cmp_pd(x.v, x.v, _CMP_ORD_Q));
+}
+
+/// <summary>
+/// AVX-512 vector of 8 double precision values
+/// </summary>
+struct lanevec512
+{
+	__m512d v;
+	static constexpr int lanes = 8;
+
+	lanevec512() {}
+	LANES_TARGET("avx512f") inline lanevec512(__m512d x) : v(x) {}
+	LANES_TARGET("avx512f") static inline lanevec512 broadcast(double x) { return _mm512_set1_pd(x); }
+	LANES_TARGET("avx512f") static inline lanevec512 load(const double* p) { return _mm512_loadu_pd(p); }
+	LANES_TARGET("avx512f") inline void store(double* p) const { _mm512_storeu_pd(p, v); }
+};
+
+LANES_TARGET("avx512f") inline lanevec512 operator+(lanevec512 x, lanevec512 y) { return _mm512_add_pd(x.v, y.v); }
+LANES_TARGET("avx512f") inline lanevec512 operator-(lanevec512 x, lanevec512 y) { return _mm512_sub_pd(x.v, y.v); }
+LANES_TARGET("avx512f") inline lanevec512 operator*(lanevec512 x, lanevec512 y) { return _mm512_mul_pd(x.v, y.v); }
+LANES_TARGET("avx512f") inline lanevec512 operator/(lanevec512 x, lanevec512 y) { return _mm512_div_pd(x.v, y.v); }
+LANES_TARGET("avx512f") inline lanevec512 ifnan(lanevec512 x, lanevec512 alt)
+{
+	return _mm512_mask_blend_pd(_mm512_cmp_pd_mask(x.v, x.v, _CMP_ORD_Q), alt.v, x.v);
+}
+
+#elif defined(LANES_NEON)
+/// <summary>
+/// NEON vector of 2 double precision values
+/// </summary>
+struct lanevec128
+{
+	float64x2_t v;
+	static constexpr int lanes = 2;
+
+	lanevec128() {}
+	lanevec128(float64x2_t x) : v(x) {}
+	static LANES_INLINE lanevec128 broadcast(double x) { return vdupq_n_f64(x); }
+	static LANES_INLINE lanevec128 load(const double* p) { return vld1q_f64(p); }
+	LANES_INLINE void store(double* p) const { vst1q_f64(p, v); }
+};
+
+LANES_INLINE lanevec128 operator+(lanevec128 x, lanevec128 y) { return vaddq_f64(x.v, y.v); }
+LANES_INLINE lanevec128 operator-(lanevec128 x, lanevec128 y) { return vsubq_f64(x.v, y.v); }
+LANES_INLINE lanevec128 operator*(lanevec128 x, lanevec128 y) { return vmulq_f64(x.v, y.v); }
+LANES_INLINE lanevec128 operator/(lanevec128 x, lanevec128 y) { return vdivq_f64(x.v, y.v); }
+LANES_INLINE lanevec128 ifnan(lanevec128 x, lanevec128 alt) { return vbslq_f64(vceqq_f64(x.v, x.v), x.v, alt.v); }
+#endif
+
+// Widest vector enabled at compile time
+#if defined(__AVX__)
+#define LANES_AVX
+typedef lanevec256 lanevec;
+constexpr int VECLANES = 4;
+#elif defined(LANES_NEON) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LANES_SSE2
+typedef lanevec128 lanevec;
+constexpr int VECLANES = 2;
+#else
+#define LANES_SCALAR
+typedef double lanevec;
+constexpr int VECLANES = 1;
+#endif
+
+// Scalar versions, so that kernels can be written once as templates over double and the
+// vector types
+LANES_INLINE double ifnan(double x, double alt) { return x == x ? x : alt; }
+template <typename T> LANES_INLINE T lanebroadcast(double x) { return T::broadcast(x); }
+template <> LANES_INLINE double lanebroadcast<double>(double x) { return x; }
+template <typename T> LANES_INLINE T laneload(const double* p) { return T::load(p); }
+template <> LANES_INLINE double laneload<double>(const double* p) { return *p; }
+template <typename T> LANES_INLINE void lanestore(double* p, const T& x) { x.store(p); }
+LANES_INLINE void lanestore(double* p, double x) { *p = x; }
+template <typename T> struct lanecount { static constexpr int value = T::lanes; };
+template <> struct lanecount<double> { static constexpr int value = 1; };
@@ -1,47 +1,389 @@
-/*
-  ==============================================================================
-
-    SOSfilter.cpp
-    Created: 26 Apr 2018 8:29:28am
-    Author:  profw
-
-  ==============================================================================
-*/
-
-#include "SOSfilter.h"
-
-SOSfilter::SOSfilter()
-{
-	sampRate = 44100.0f;
-}
-
-void SOSfilter::initsos(int numsects, double fs)
-{
-	sampRate = fs;
-	SOScascade.resize(numsects);
-	for (auto& sos : SOScascade)
-		sos = std::unique_ptr<BQfilter>(new BQfilter);
-}
-
-void SOSfilter::updateSection(int sect, FilterType ftype, double Gain, double f0, double Q)
-{
-	SOScascade[sect]->update(ftype, Gain, f0, Q, sampRate);
-}
-
-double SOSfilter::step(double sample)
-{
-	double y = sample;
-	for (auto& bq : SOScascade)
-		y = bq->step(y);
-	return y;
-}
-
-double SOSfilter::freqResponse(double freq)
-{
-	// Compute magnitude of frequency response (dB) at given frequency
-	double frmag = 0.0;
-
-	for (auto& sos : SOScascade)
-		frmag += sos->freqresp(freq, sampRate);
-	return frmag;
+/*
+  ==============================================================================
+
+    SOSfilter.cpp
+    Created: 26 Apr 2018 8:29:28am
+    Author:  profw
+
+  ==============================================================================
+*/
+
+#include "SOSfilter.h"
+#include "BQdesign.h"
+#include "DSPkernels.h"
+#include "StateSnapshot.h"
+#include <algorithm>
+#include <complex>
+
+// Length of the double precision scratch buffer used by procblock
+constexpr int SOSCHUNK = 256;
+// Number of sections run together by procblock (the most DSPkernels::soscascade takes)
+constexpr int SOSGROUP = 4;
+// Sections in a slice of DSPkernels::sosparallel
+constexpr int PARALLELSLICE = 8;
+// Frequencies, spaced evenly up to the Nyquist frequency, at which parallelsos() checks its result
+constexpr int PARALLELCHECKS = 512;
+
+static_assert(MAXSOSSECTS % PARALLELSLICE == 0, "parallel sections are stored in whole slices");
+
+SOSfilter::SOSfilter()
+{
+	sampRate = 44100.0f;
+	smoothing = 0;
+	coefcache = nullptr;
+	parallel = false;
+	direct = 0.0;
+	for (int k = 0; k < MAXSOSSECTS; k++)
+	{
+		for (int n = 0; n < 4; n++)
+			parcoefs[n][k] = 0.0;
+		pars1[k] = 0.0;
+		pars2[k] = 0.0;
+	}
+}
+
+void SOSfilter::initsos(int numsects, double fs)
+{
+	sampRate = fs;
+	parallel = false;
+	SOScascade.assign(numsects, BQfilter());
+	for (auto& sos : SOScascade)
+		sos.setsmoothing(smoothing);
+}
+
+void SOSfilter::updateSection(int sect, FilterType ftype, double Gain, double f0, double Q)
+{
+	if (coefcache)
+		SOScascade[sect].update(ftype, Gain, f0, Q, sampRate, *coefcache);
+	else
+		SOScascade[sect].update(ftype, Gain, f0, Q, sampRate);
+	if (parallel && !convert())
+		setparallel(false);
+}
+
+void SOScoefs::design(int sect, FilterType ftype, double Gain, double f0, double Q, double fs)
+{
+	designbq(ftype, Gain, f0, Q, fs, b[sect], a[sect]);
+}
+
+void SOSfilter::setcoefs(const SOScoefs& coefs)
+{
+	const int numsects = coefs.numsects < int(SOScascade.size()) ? coefs.numsects : int(SOScascade.size());
+	for (int k = 0; k < numsects; k++)
+		SOScascade[k].setcoefs(coefs.b[k], coefs.a[k]);
+	if (parallel && !convert())
+		setparallel(false);
+}
+
+void SOSfilter::getcoefs(SOScoefs& coefs) const
+{
+	coefs.numsects = int(SOScascade.size()) < MAXSOSSECTS ? int(SOScascade.size()) : MAXSOSSECTS;
+	for (int k = 0; k < coefs.numsects; k++)
+		SOScascade[k].getcoefs(coefs.b[k], coefs.a[k]);
+}
+
+bool parallelsos(const SOScoefs& cascade, SOScoefs& parallel, double& direct)
+{
+	const int numsects = cascade.numsects;
+	if (numsects < 1 || numsects > MAXSOSSECTS)
+		return false;
+
+	// With H(z) = direct + sum of z (b0 z + b1) / D(z), where D(z) = z^2 + a1 z + a2 is the
+	// denominator of a section, b0 z + b1 is the remainder of H(z) D(z) / z modulo D(z). The
+	// remainder is found in the ring of polynomials modulo D(z), where every element is
+	// u + v z, so the poles are never computed and a double pole in one section is no problem.
+	// Dividing by x = u + v z multiplies by its conjugate (u - a1 v) - v z and divides by its
+	// norm u^2 - a1 u v + a2 v^2, which is zero when x shares a root with D(z).
+	direct = 1.0;
+	for (int k = 0; k < numsects; k++)
+	{
+		const double a1 = cascade.a[k][1];
+		const double a2 = cascade.a[k][2];
+		if (a2 == 0.0)
+			return false;
+		auto multiply = [&](double& u, double& v, double x, double y) {
+			const double w = u * x - a2 * v * y;
+			v = u * y + v * x - a1 * v * y;
+			u = w;
+		};
+		double nu = 1.0, nv = 0.0; // product of the numerators
+		double du = 0.0, dv = 1.0; // z times the product of the other denominators
+		for (int j = 0; j < numsects; j++)
+		{
+			const double* b = cascade.b[j];
+			multiply(nu, nv, b[2] - b[0] * a2, b[1] - b[0] * a1);
+			if (j != k)
+				multiply(du, dv, cascade.a[j][2] - a2, cascade.a[j][1] - a1);
+		}
+		const double norm = du * du - a1 * du * dv + a2 * dv * dv;
+		if (norm == 0.0)
+			return false;
+		multiply(nu, nv, (du - a1 * dv) / norm, -dv / norm);
+		parallel.b[k][0] = nv;
+		parallel.b[k][1] = nu;
+		parallel.b[k][2] = 0.0;
+		for (int n = 0; n < 3; n++)
+			parallel.a[k][n] = cascade.a[k][n];
+		direct *= cascade.b[k][2] / a2;
+	}
+	parallel.numsects = numsects;
+
+	// Compare the two responses, also at the angle of each complex pole pair, where a section
+	// with a high Q peaks
+	typedef std::complex<double> cplx;
+	const double PI = 3.141592653589793238463;
+	for (int m = 0; m < PARALLELCHECKS + numsects; m++)
+	{
+		double omega = PI * (m + 0.5) / PARALLELCHECKS;
+		if (m >= PARALLELCHECKS)
+		{
+			const double a1 = cascade.a[m - PARALLELCHECKS][1];
+			const double a2 = cascade.a[m - PARALLELCHECKS][2];
+			if (a1 * a1 >= 4.0 * a2)
+				continue;
+			omega = acos(-0.5 * a1 / sqrt(a2));
+		}
+		const cplx w = std::polar(1.0, -omega);
+		cplx hc = 1.0, hp = direct;
+		for (int k = 0; k < numsects; k++)
+		{
+			const cplx d = (cascade.a[k][2] * w + cascade.a[k][1]) * w + 1.0;
+			hc *= ((cascade.b[k][2] * w + cascade.b[k][1]) * w + cascade.b[k][0]) / d;
+			hp += (parallel.b[k][1] * w + parallel.b[k][0]) / d;
+		}
+		if (!(std::abs(hp - hc) <= PARALLELTOLERANCE * std::abs(hc)))
+			return false;
+	}
+	return true;
+}
+
+bool SOSfilter::setparallel(bool enable)
+{
+	if (enable == parallel)
+		return true;
+	if (!enable)
+	{
+		parallel = false;
+		for (auto& sos : SOScascade)
+			sos.resetstate();
+		return true;
+	}
+	if (SOScascade.size() > MAXSOSSECTS || !convert())
+		return false;
+	for (int k = 0; k < MAXSOSSECTS; k++)
+	{
+		pars1[k] = 0.0;
+		pars2[k] = 0.0;
+	}
+	parframes.assign(SOSCHUNK * PARALLELSLICE, 0.0);
+	parallel = true;
+	return true;
+}
+
+bool SOSfilter::convert()
+{
+	// The parallel form is not interpolated, so any interpolation in progress lands on its target
+	for (auto& sos : SOScascade)
+		if (sos.rampcount > 0)
+		{
+			sos.rampcount = 1;
+			sos.advanceramp();
+		}
+	SOScoefs coefs, parcoefset;
+	getcoefs(coefs);
+	double gain;
+	if (int(SOScascade.size()) != coefs.numsects || !parallelsos(coefs, parcoefset, gain))
+		return false;
+	direct = gain;
+	for (int k = 0; k < MAXSOSSECTS; k++)
+	{
+		const bool used = k < coefs.numsects;
+		parcoefs[0][k] = used ? parcoefset.b[k][0] : 0.0;
+		parcoefs[1][k] = used ? parcoefset.b[k][1] : 0.0;
+		parcoefs[2][k] = used ? parcoefset.a[k][1] : 0.0;
+		parcoefs[3][k] = used ? parcoefset.a[k][2] : 0.0;
+	}
+	return true;
+}
+
+void SOSfilter::setsmoothing(int numsamples)
+{
+	smoothing = numsamples;
+	for (auto& sos : SOScascade)
+		sos.setsmoothing(numsamples);
+}
+
+bool SOSfilter::isramping() const
+{
+	for (auto& sos : SOScascade)
+		if (sos.isramping())
+			return true;
+	return false;
+}
+
+void SOSfilter::savestate(SnapshotWriter& writer) const
+{
+	writer.begin(snapshottag("SOSF"));
+	writer.put(std::uint32_t(SOScascade.size()));
+	writer.put(sampRate);
+	writer.put(std::int32_t(smoothing));
+	writer.put(std::int32_t(parallel));
+	writer.end();
+	for (auto& sos : SOScascade)
+		sos.savestate(writer);
+	// the parallel coefficients follow from the cascade, so only the state is saved
+	if (parallel)
+	{
+		writer.begin(snapshottag("SOSP"));
+		writer.put(pars1, SOScascade.size());
+		writer.put(pars2, SOScascade.size());
+		writer.end();
+	}
+}
+
+bool SOSfilter::loadstate(SnapshotReader& reader)
+{
+	std::uint32_t numsects;
+	double fs;
+	std::int32_t smooth, par;
+	if (!reader.begin(snapshottag("SOSF")) || !reader.get(numsects) || !reader.get(fs) || !reader.get(smooth)
+		|| !reader.get(par) || !reader.end())
+		return false;
+	// The count comes from the snapshot, so sections are added only as their records are read
+	if (par && numsects > MAXSOSSECTS)
+		return false;
+	std::vector<BQfilter> cascade;
+	for (std::uint32_t k = 0; k < numsects; k++)
+	{
+		BQfilter sos;
+		if (!sos.loadstate(reader))
+			return false;
+		cascade.push_back(sos);
+	}
+	const double* s1 = nullptr;
+	const double* s2 = nullptr;
+	if (par)
+	{
+		if (!reader.begin(snapshottag("SOSP")))
+			return false;
+		s1 = reader.getarray<double>(numsects);
+		s2 = reader.getarray<double>(numsects);
+		if (!reader.end())
+			return false;
+	}
+	// Build the filter on a copy, so it is unchanged if the parallel form cannot be rebuilt
+	SOSfilter loaded(*this);
+	loaded.sampRate = fs;
+	loaded.smoothing = smooth;
+	loaded.SOScascade.swap(cascade);
+	loaded.parallel = false;
+	if (par)
+	{
+		if (!loaded.setparallel(true))
+			return false;
+		std::copy(s1, s1 + numsects, loaded.pars1);
+		std::copy(s2, s2 + numsects, loaded.pars2);
+	}
+	*this = loaded;
+	return true;
+}
+
+double SOSfilter::step(double sample)
+{
+	if (parallel)
+	{
+		// Same arithmetic, in the same order, as the sosparallel kernel
+		double y = direct * sample;
+		const int numsects = int(SOScascade.size());
+		for (int k = 0; k < numsects; k++)
+		{
+			const double yk = parcoefs[0][k] * sample + pars1[k];
+			pars1[k] = pars2[k] + parcoefs[1][k] * sample - parcoefs[2][k] * yk;
+			pars2[k] = 0.0 - parcoefs[3][k] * yk;
+			y += yk;
+		}
+		return y;
+	}
+
+	double y = sample;
+	for (auto& bq : SOScascade)
+		y = bq.step(y);
+	return y;
+}
+
+void SOSfilter::procblock(const float* insamples, float* outsamples, int numsamples)
+{
+	// Sections are run in groups of up to SOSGROUP, sample by sample, by the soscascade kernel.
+	// Running several sections per sample lets the recursions of successive sections overlap,
+	// which a section-at-a-time loop cannot do.
+	// Samples during a coefficient interpolation go through step()
+	while (numsamples > 0 && isramping())
+	{
+		*outsamples++ = float(step(*insamples++));
+		numsamples--;
+	}
+
+	const DSPkernels& kernels = getkernels();
+	double chunk[SOSCHUNK];
+	if (parallel)
+	{
+		double outchunk[SOSCHUNK];
+		const double* coefs[4] = { parcoefs[0], parcoefs[1], parcoefs[2], parcoefs[3] };
+		for (int start = 0; start < numsamples; start += SOSCHUNK)
+		{
+			int len = numsamples - start < SOSCHUNK ? numsamples - start : SOSCHUNK;
+			kernels.floattodouble(insamples + start, chunk, len);
+			kernels.sosparallel(chunk, outchunk, parframes.data(), len, int(SOScascade.size()), coefs, pars1, pars2,
+				direct);
+			kernels.doubletofloat(outchunk, outsamples + start, len);
+		}
+		return;
+	}
+
+	double coefs[5 * SOSGROUP];
+	double z[2 * SOSGROUP];
+	const int numsects = int(SOScascade.size());
+	for (int start = 0; start < numsamples; start += SOSCHUNK)
+	{
+		int len = numsamples - start < SOSCHUNK ? numsamples - start : SOSCHUNK;
+		kernels.floattodouble(insamples + start, chunk, len);
+		for (int first = 0; first < numsects; first += SOSGROUP)
+		{
+			int count = numsects - first < SOSGROUP ? numsects - first : SOSGROUP;
+			for (int k = 0; k < count; k++)
+			{
+				const BQfilter& bq = SOScascade[first + k];
+				coefs[k] = bq.b[0];
+				coefs[SOSGROUP + k] = bq.b[1];
+				coefs[2 * SOSGROUP + k] = bq.b[2];
+				coefs[3 * SOSGROUP + k] = bq.a[1];
+				coefs[4 * SOSGROUP + k] = bq.a[2];
+				z[k] = bq.s1;
+				z[SOSGROUP + k] = bq.s2;
+			}
+			kernels.soscascade(chunk, len, coefs, z, count);
+			for (int k = 0; k < count; k++)
+			{
+				SOScascade[first + k].s1 = z[k];
+				SOScascade[first + k].s2 = z[SOSGROUP + k];
+			}
+		}
+		kernels.doubletofloat(chunk, outsamples + start, len);
+	}
+}
+
+double SOSfilter::freqResponse(double freq)
+{
+	// Compute magnitude of frequency response (dB) at given frequency
+	double frmag = 0.0;
+
+	for (auto& sos : SOScascade)
+		frmag += sos.freqresp(freq, sampRate);
+	return frmag;
+}
+
+void SOSfilter::freqResponse(const FreqGrid& grid, double* magdB, double* phase, double* grpdelay,
+	FreqScratch* scratch) const
+{
+	grid.cascaderesp(SOScascade.data(), int(SOScascade.size()), magdB, phase, grpdelay, scratch);
 }
\ No newline at end of file
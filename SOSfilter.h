@@ -1,63 +1,238 @@
-/*
-  ==============================================================================
-
-    SOSfilter.h
-    Created: 26 Apr 2018 8:29:28am
-    Author:  profw
-
-  ==============================================================================
-*/
-
-#pragma once
-
-#include "BQfilter.h"
-#include <vector>
-#include <memory>
-
-/// <summary>
-/// Cascade of second order sections.
-/// 
-/// This class implements a cascade of biquadratic filters (aka second order sections). It
-/// can be used as an equalizer.
-/// </summary>
-class SOSfilter
-{
-public:
-	SOSfilter();
-	~SOSfilter() {}
-
-	/// <summary>
-	/// Initialize the SOS cascade
-	/// </summary>
-	/// <param name="numsects">number of SOS in cascade</param>
-	/// <param name="fs">sampling frequency</param>
-	void initsos(int numsects, double fs);
-
-	/// <summary>
-	/// Update settings of SOS filter section
-	/// </summary>
-	/// <param name="sect">index of filter in cascade</param>
-	/// <param name="ftype">filter type (BASS, TREBLE, PEAK)</param>
-	/// <param name="Gain">gain (dB)</param>
-	/// <param name="f0">center or cut-off frequency (Hz)</param>
-	/// <param name="Q">Q factor (no units)</param>
-	void updateSection(int sect, FilterType ftype, double Gain, double f0, double Q);
-
-	/// <summary>
-	/// Step SOS filter through one sample period
-	/// </summary>
-	/// <param name="sample">input sample</param>
-	/// <returns>output sample</returns>
-	double step(double sample);
-
-	/// <summary>
-	/// Calculate magnitude of frequency response
-	/// </summary>
-	/// <param name="freq">frequency (Hz)</param>
-	/// <returns>magnitude of frequency response (dB)</returns>
-	double freqResponse(double freq);
-
-private:
-	double sampRate;
-	std::vector<std::unique_ptr<BQfilter>> SOScascade;
+/*
+  ==============================================================================
+
+    SOSfilter.h
+    Created: 26 Apr 2018 8:29:28am
+    Author:  profw
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "BQfilter.h"
+#include "FreqGrid.h"
+#include <vector>
+
+// Most sections in an SOScoefs set
+constexpr int MAXSOSSECTS = 32;
+
+/// <summary>
+/// Coefficients of every section of a cascade
+///
+/// A set has a fixed size and no pointers, so it can be designed on a control thread and
+/// handed to the audio thread through a ParamSwap, then applied with SOSfilter::setcoefs().
+/// </summary>
+struct SOScoefs
+{
+	int numsects;
+	double b[MAXSOSSECTS][3];
+	double a[MAXSOSSECTS][3];
+
+	/// <summary>
+	/// Design one section, as SOSfilter::updateSection() does
+	/// </summary>
+	/// <param name="sect">index of filter in cascade</param>
+	/// <param name="ftype">filter type (BASS, TREBLE, PEAK)</param>
+	/// <param name="Gain">gain (dB)</param>
+	/// <param name="f0">center or cut-off frequency (Hz)</param>
+	/// <param name="Q">Q factor (no units)</param>
+	/// <param name="fs">sampling frequency (Hz)</param>
+	void design(int sect, FilterType ftype, double Gain, double f0, double Q, double fs);
+};
+
+// Largest error of a parallel form response relative to its cascade (about 1e-5 dB)
+constexpr double PARALLELTOLERANCE = 1e-6;
+
+/// <summary>
+/// Convert a cascade of second order sections to parallel form
+///
+/// The cascade response is expanded in partial fractions over its poles, giving
+/// H(z) = direct + sum of (b0 + b1 z^-1) / (1 + a1 z^-1 + a2 z^-2), with one parallel section
+/// for each cascade section, having the same poles. The conversion fails if two sections share
+/// a pole or a section has a pole at zero (a first order section). Sections with nearly the
+/// same poles have large residues that mostly cancel, so the response of the parallel form is
+/// checked against the cascade at 512 frequencies up to the Nyquist frequency and at the angle
+/// of every pole, and the conversion fails if it differs by more than PARALLELTOLERANCE times
+/// the magnitude of the cascade response.
+/// </summary>
+/// <param name="cascade">coefficients of the cascade</param>
+/// <param name="parallel">coefficients of the parallel sections (output; b[k][2] is zero)</param>
+/// <param name="direct">gain of the direct path (output)</param>
+/// <returns>false if the cascade cannot be converted</returns>
+bool parallelsos(const SOScoefs& cascade, SOScoefs& parallel, double& direct);
+
+/// <summary>
+/// Cascade of second order sections.
+/// 
+/// This class implements a cascade of biquadratic filters (aka second order sections). It
+/// can be used as an equalizer. The sections are stored contiguously. When the number of
+/// sections is known at compile time, FixedSOSfilter is faster.
+/// </summary>
+class SOSfilter
+{
+public:
+	SOSfilter();
+	~SOSfilter() {}
+
+	/// <summary>
+	/// Initialize the SOS cascade
+	/// </summary>
+	/// <param name="numsects">number of SOS in cascade</param>
+	/// <param name="fs">sampling frequency</param>
+	void initsos(int numsects, double fs);
+
+	/// <summary>
+	/// Update settings of SOS filter section
+	/// </summary>
+	/// <param name="sect">index of filter in cascade</param>
+	/// <param name="ftype">filter type (BASS, TREBLE, PEAK)</param>
+	/// <param name="Gain">gain (dB)</param>
+	/// <param name="f0">center or cut-off frequency (Hz)</param>
+	/// <param name="Q">Q factor (no units)</param>
+	void updateSection(int sect, FilterType ftype, double Gain, double f0, double Q);
+
+	/// <summary>
+	/// Set the coefficients of every section at once
+	///
+	/// Nothing is allocated or designed, so this may be called on the audio thread at a block
+	/// boundary. Sections beyond the number in the cascade are ignored, and the coefficients
+	/// are interpolated if smoothing is enabled.
+	/// </summary>
+	/// <param name="coefs">coefficient set</param>
+	void setcoefs(const SOScoefs& coefs);
+
+	/// <summary>
+	/// Get the coefficients of every section
+	/// </summary>
+	/// <param name="coefs">coefficient set (output)</param>
+	void getcoefs(SOScoefs& coefs) const;
+
+	/// <summary>
+	/// Set coefficient smoothing for every section
+	/// 
+	/// See BQfilter::setsmoothing(). The setting also applies to sections created by initsos().
+	/// </summary>
+	/// <param name="numsamples">length of the interpolation (0 disables smoothing)</param>
+	void setsmoothing(int numsamples);
+
+	/// <summary>
+	/// Set coefficient cache
+	/// 
+	/// When a cache is set, updateSection() looks designs up in it. The cache is not owned
+	/// by the filter and may be shared by several filters on the same thread.
+	/// </summary>
+	/// <param name="cache">coefficient cache (nullptr to design every update)</param>
+	void setcoefcache(BQcoefcache* cache) { coefcache = cache; }
+
+	/// <summary>
+	/// Run the filter in parallel form
+	///
+	/// A cascade must run its sections one after another, each waiting for the output of the
+	/// last. In parallel form (see parallelsos()) every section takes the filter input, so
+	/// step() and procblock() run the sections side by side, eight at a time in SIMD lanes.
+	/// The response matches freqResponse(), which still describes the cascade, to within
+	/// PARALLELTOLERANCE. At most MAXSOSSECTS sections can be converted.
+	///
+	/// Switching either way clears the state of the form switched to. While the parallel form
+	/// is in use, coefficient changes are converted at once and are not smoothed; a change
+	/// that cannot be converted, or initsos(), switches back to the cascade. When several
+	/// sections change, setcoefs() converts once where updateSection() converts for each.
+	/// </summary>
+	/// <param name="enable">true for parallel form, false for the cascade</param>
+	/// <returns>false if the cascade cannot be converted (it is left running as a cascade)</returns>
+	bool setparallel(bool enable);
+
+	/// <summary>
+	/// Check whether the filter runs in parallel form
+	/// </summary>
+	/// <returns>true if in parallel form</returns>
+	bool isparallel() const { return parallel; }
+
+	/// <summary>
+	/// Check whether any section is interpolating its coefficients
+	/// </summary>
+	/// <returns>true while coefficients are being interpolated</returns>
+	bool isramping() const;
+
+	/// <summary>
+	/// Step SOS filter through one sample period
+	/// </summary>
+	/// <param name="sample">input sample</param>
+	/// <returns>output sample</returns>
+	double step(double sample);
+
+	/// <summary>
+	/// Process a block of samples
+	/// 
+	/// Any samples during a coefficient interpolation go through step(). The rest of the
+	/// block is run in double precision: the cascade is stepped sample by sample through
+	/// groups of up to four sections, and the parallel form (see setparallel) runs its
+	/// sections eight at a time. Either way the output matches calling step() for each sample.
+	/// </summary>
+	/// <param name="insamples">pointer to first input sample</param>
+	/// <param name="outsamples">pointer to first output sample (may be the same as insamples)</param>
+	/// <param name="numsamples">number of samples in the block</param>
+	void procblock(const float* insamples, float* outsamples, int numsamples);
+
+	/// <summary>
+	/// Process a block of samples in place
+	/// 
+	/// Note: this method modifies the input samples - they become the output samples.
+	/// </summary>
+	/// <param name="samples">pointer to first audio sample</param>
+	/// <param name="numsamples">number of samples in the block</param>
+	void procblock(float* samples, int numsamples) { procblock(samples, samples, numsamples); }
+
+	/// <summary>
+	/// Calculate magnitude of frequency response
+	/// </summary>
+	/// <param name="freq">frequency (Hz)</param>
+	/// <returns>magnitude of frequency response (dB)</returns>
+	double freqResponse(double freq);
+
+	/// <summary>
+	/// Calculate frequency response at every frequency of a grid
+	/// 
+	/// The grid should have the same sampling frequency as the filter.
+	/// </summary>
+	/// <param name="grid">frequency grid</param>
+	/// <param name="magdB">magnitude of frequency response (dB) (output)</param>
+	/// <param name="phase">phase (radians) (output, optional)</param>
+	/// <param name="grpdelay">group delay (samples) (output, optional)</param>
+	/// <param name="scratch">scratch arrays for the phase (see FreqScratch) (optional)</param>
+	void freqResponse(const FreqGrid& grid, double* magdB, double* phase = nullptr, double* grpdelay = nullptr,
+		FreqScratch* scratch = nullptr) const;
+
+	/// <summary>
+	/// Write the sampling rate and the state of every section to a snapshot
+	/// </summary>
+	/// <param name="writer">snapshot</param>
+	void savestate(SnapshotWriter& writer) const;
+
+	/// <summary>
+	/// Restore everything written by savestate()
+	///
+	/// The number of sections is set from the snapshot. The coefficient cache is not part of
+	/// the state and is left as it is.
+	/// </summary>
+	/// <param name="reader">snapshot</param>
+	/// <returns>false if the next records are not an SOS filter</returns>
+	bool loadstate(SnapshotReader& reader);
+
+private:
+	bool convert();
+
+	double sampRate;
+	int smoothing;
+	BQcoefcache* coefcache;
+	std::vector<BQfilter> SOScascade;
+
+	// parallel form: b0, b1, a1 and a2 arrays, state, and scratch for DSPkernels::sosparallel
+	bool parallel;
+	double direct;
+	double parcoefs[4][MAXSOSSECTS];
+	double pars1[MAXSOSSECTS];
+	double pars2[MAXSOSSECTS];
+	std::vector<double> parframes;
 };
\ No newline at end of file
@@ -1,32 +1,181 @@
-#include "SSfilter.h"
-
-SSfilter::SSfilter()
-{
-    hpout = 0.0;
-    bpout = 0.0;
-    lpout = 0.0;
-    damping = 0.0;
-    F1 = 0.0;
-}
-
-void SSfilter::step(double insample)
-{
-    hpout = -lpout - damping * bpout + insample;
-    bpout += F1 * hpout;
-    lpout += F1 * bpout;
-}
-
-void SSfilter::step(double insample, double Omegac)
-{
-    double f1 = 2.0 * sin(Omegac / 2.0);
-    hpout = -lpout - damping * bpout + insample;
-    bpout += f1 * hpout;
-    lpout += f1 * bpout;
-}
-
-void SSfilter::reset()
-{
-    hpout = 0.0;
-    bpout = 0.0;
-    lpout = 0.0;
-}
+#include "SSfilter.h"
+#include "StateSnapshot.h"
+
+template <typename C>
+SSfilterT<C>::SSfilterT()
+{
+    hpout = 0.0;
+    bpout = 0.0;
+    lpout = 0.0;
+    damping = 0.0;
+    F1 = 0.0;
+    controlperiod = 16;
+}
+
+template <typename C>
+void SSfilterT<C>::step(C insample)
+{
+    hpout = -lpout - damping * bpout + insample;
+    bpout += F1 * hpout;
+    lpout += F1 * bpout;
+}
+
+template <typename C>
+void SSfilterT<C>::step(C insample, C Omegac)
+{
+    C f1 = C(2.0 * sin(Omegac / 2.0));
+    hpout = -lpout - damping * bpout + insample;
+    bpout += f1 * hpout;
+    lpout += f1 * bpout;
+}
+
+template <typename C>
+template <typename SampleType>
+void SSfilterT<C>::procsamples(const SampleType* insamples, SampleType* hpsamples, SampleType* bpsamples,
+    SampleType* lpsamples, int numsamples)
+{
+    C hp = hpout;
+    C bp = bpout;
+    C lp = lpout;
+    for (int n = 0; n < numsamples; n++)
+    {
+        hp = -lp - damping * bp + C(insamples[n]);
+        bp += F1 * hp;
+        lp += F1 * bp;
+        if (hpsamples)
+            hpsamples[n] = SampleType(hp);
+        if (bpsamples)
+            bpsamples[n] = SampleType(bp);
+        if (lpsamples)
+            lpsamples[n] = SampleType(lp);
+    }
+    hpout = hp;
+    bpout = bp;
+    lpout = lp;
+}
+
+template <typename C>
+template <typename SampleType>
+void SSfilterT<C>::procramp(const SampleType* insamples, SampleType* hpsamples, SampleType* bpsamples,
+    SampleType* lpsamples, int numsamples, C target)
+{
+    // the recursion of procsamples(), with F1 stepped before each sample and hp written the
+    // way the ssfilterbank kernel computes it
+    C hp = hpout;
+    C bp = bpout;
+    C lp = lpout;
+    C f1 = F1;
+    const C df1 = (target - F1) / C(numsamples);
+    for (int n = 0; n < numsamples; n++)
+    {
+        f1 += df1;
+        hp = C(insamples[n]) - (lp + damping * bp);
+        bp += f1 * hp;
+        lp += f1 * bp;
+        if (hpsamples)
+            hpsamples[n] = SampleType(hp);
+        if (bpsamples)
+            bpsamples[n] = SampleType(bp);
+        if (lpsamples)
+            lpsamples[n] = SampleType(lp);
+    }
+    hpout = hp;
+    bpout = bp;
+    lpout = lp;
+    F1 = target;
+}
+
+template <typename C>
+template <typename SampleType>
+void SSfilterT<C>::procmodulated(const SampleType* insamples, const SampleType* Omegac, SampleType* hpsamples,
+    SampleType* bpsamples, SampleType* lpsamples, int numsamples)
+{
+    for (int start = 0; start < numsamples; start += controlperiod)
+    {
+        int len = numsamples - start < controlperiod ? numsamples - start : controlperiod;
+        procramp(insamples + start, hpsamples ? hpsamples + start : nullptr, bpsamples ? bpsamples + start : nullptr,
+            lpsamples ? lpsamples + start : nullptr, len, C(fastF1(Omegac[start + len - 1])));
+    }
+}
+
+template <typename C>
+void SSfilterT<C>::procblock(const float* insamples, float* hpsamples, float* bpsamples, float* lpsamples, int numsamples)
+{
+    procsamples(insamples, hpsamples, bpsamples, lpsamples, numsamples);
+}
+
+template <typename C>
+void SSfilterT<C>::procblock(const double* insamples, double* hpsamples, double* bpsamples, double* lpsamples,
+    int numsamples)
+{
+    procsamples(insamples, hpsamples, bpsamples, lpsamples, numsamples);
+}
+
+template <typename C>
+void SSfilterT<C>::procblock(const float* insamples, const float* Omegac, float* hpsamples, float* bpsamples,
+    float* lpsamples, int numsamples)
+{
+    procmodulated(insamples, Omegac, hpsamples, bpsamples, lpsamples, numsamples);
+}
+
+template <typename C>
+void SSfilterT<C>::procblock(const double* insamples, const double* Omegac, double* hpsamples, double* bpsamples,
+    double* lpsamples, int numsamples)
+{
+    procmodulated(insamples, Omegac, hpsamples, bpsamples, lpsamples, numsamples);
+}
+
+template <typename C>
+void SSfilterT<C>::procblock(const float* insamples, double Omegac, float* hpsamples, float* bpsamples,
+    float* lpsamples, int numsamples)
+{
+    if (numsamples > 0)
+        procramp(insamples, hpsamples, bpsamples, lpsamples, numsamples, C(2.0 * sin(Omegac / 2.0)));
+}
+
+template <typename C>
+void SSfilterT<C>::reset()
+{
+    hpout = 0.0;
+    bpout = 0.0;
+    lpout = 0.0;
+}
+
+template <typename C>
+void SSfilterT<C>::savestate(SnapshotWriter& writer) const
+{
+    writer.begin(snapshottag("SSFL"));
+    writer.put(std::uint32_t(sizeof(C)));
+    writer.put(hpout);
+    writer.put(bpout);
+    writer.put(lpout);
+    writer.put(damping);
+    writer.put(F1);
+    writer.put(std::int32_t(controlperiod));
+    writer.end();
+}
+
+template <typename C>
+bool SSfilterT<C>::loadstate(SnapshotReader& reader)
+{
+    std::uint32_t size;
+    C values[5] = {};
+    std::int32_t period = 1;
+    if (!reader.begin(snapshottag("SSFL")) || !reader.get(size) || size != sizeof(C))
+        return false;
+    for (int k = 0; k < 5; k++)
+        reader.get(values[k]);
+    reader.get(period);
+    if (!reader.end())
+        return false;
+    hpout = values[0];
+    bpout = values[1];
+    lpout = values[2];
+    damping = values[3];
+    F1 = values[4];
+    setcontrolperiod(period);
+    return true;
+}
+
+template class SSfilterT<float>;
+template class SSfilterT<double>;
@@ -1,81 +1,212 @@
-#pragma once
-
-#include <cmath>
-
-const double PI = 3.141592653589793238463;
-
-/// <summary>
-/// A simple state space filter
-/// 
-/// This class implements a simple state space filter that produces
-/// a highpass, lowpass, and bandpass output
-/// </summary>
-class SSfilter
-{
-public:
-	SSfilter();
-	~SSfilter() {}
-
-	/// <summary>
-	/// Process one sample through filter
-	/// </summary>
-	/// <param name="insample">input sample</param>
-	void step(double insample);
-
-	/// <summary>
-	/// Process one sample through filter with variable center frequency
-	/// </summary>
-	/// <param name="insample">input sample</param>
-	/// <param name="Omegac">center frequency (radians/sample)</param>
-	void step(double insample, double Omegac);
-
-	/// <summary>
-	/// Get high-pass output sample
-	/// </summary>
-	/// <returns>high-pass output sample</returns>
-	double gethp() { return hpout; }
-
-	/// <summary>
-	/// Get band-pass output sample
-	/// </summary>
-	/// <returns>band-pass output sample</returns>
-	double getbp() { return bpout; }
-
-	/// <summary>
-	/// Get low-pass output sample
-	/// </summary>
-	/// <returns>low-pass output sample</returns>
-	double getlp() { return lpout; }
-
-	/// <summary>
-	/// Set damping parameter
-	/// </summary>
-	/// <param name="dmp">damping parameter (no units)</param>
-	void setdamping(double dmp) { damping = dmp; }
-
-	/// <summary>
-	/// Set F1 parameter
-	/// </summary>
-	/// <param name="fc">center or cutoff frequency (Hz)</param>
-	/// <param name="fs">sampling frequency (Hz)</param>
-	void setF1(double fc, double fs) { F1 = 2.0 * sin(PI * fc / fs); }
-
-	/// <summary>
-	/// Set F1 parameter
-	/// </summary>
-	/// <param name="Omegac">center frequency (radians/sample)</param>
-	void setF1(double Omegac) { F1 = 2.0 * sin(Omegac / 2.0); }
-
-	/// <summary>
-	/// Reset state variables
-	/// </summary>
-	void reset();
-
-private:
-	double hpout;
-	double bpout;
-	double lpout;
-	double damping;
-	double F1;
-};
-
+#pragma once
+
+#include <cmath>
+
+class SnapshotReader;
+class SnapshotWriter;
+
+const double PI = 3.141592653589793238463;
+
+// Bound on the relative error of fastF1() over its whole range
+constexpr double FASTF1ERROR = 6e-9;
+
+/// <summary>
+/// Fast approximation of the F1 parameter, 2 sin(Omegac / 2)
+///
+/// An odd polynomial of degree 9 fitted for minimum relative error on [-PI, PI], so the
+/// center frequency is accurate to within FASTF1ERROR at low frequencies as well as high.
+/// Frequencies beyond the Nyquist frequency are limited to it.
+/// </summary>
+/// <param name="Omegac">center frequency (radians/sample)</param>
+/// <returns>F1 parameter</returns>
+inline double fastF1(double Omegac)
+{
+	const double w = Omegac < -PI ? -PI : Omegac > PI ? PI : Omegac;
+	const double w2 = w * w;
+	return w * (0.9999999946923543 + w2 * (-0.04166664173308288 + w2 * (0.0005208140842380909
+		+ w2 * (-3.0949115217203596e-06 + w2 * 1.0163814524982815e-08))));
+}
+
+/// <summary>
+/// A simple state space filter
+/// 
+/// This class implements a simple state space filter that produces
+/// a highpass, lowpass, and bandpass output. The template parameter is the type of the
+/// parameters and state variables (float or double); SSfilter is the double precision filter.
+/// </summary>
+template <typename C>
+class SSfilterT
+{
+public:
+	SSfilterT();
+	~SSfilterT() {}
+
+	/// <summary>
+	/// Process one sample through filter
+	/// </summary>
+	/// <param name="insample">input sample</param>
+	void step(C insample);
+
+	/// <summary>
+	/// Process one sample through filter with variable center frequency
+	/// </summary>
+	/// <param name="insample">input sample</param>
+	/// <param name="Omegac">center frequency (radians/sample)</param>
+	void step(C insample, C Omegac);
+
+	/// <summary>
+	/// Process a block of samples through filter
+	/// 
+	/// Any of the output pointers may be nullptr if that output is not needed. After the call,
+	/// gethp(), getbp() and getlp() return the outputs for the last sample in the block.
+	/// </summary>
+	/// <param name="insamples">pointer to first input sample</param>
+	/// <param name="hpsamples">pointer to first high-pass output sample</param>
+	/// <param name="bpsamples">pointer to first band-pass output sample</param>
+	/// <param name="lpsamples">pointer to first low-pass output sample</param>
+	/// <param name="numsamples">number of samples in the block</param>
+	void procblock(const float* insamples, float* hpsamples, float* bpsamples, float* lpsamples, int numsamples);
+
+	/// <summary>
+	/// Process a block of double precision samples through filter
+	/// </summary>
+	/// <param name="insamples">pointer to first input sample</param>
+	/// <param name="hpsamples">pointer to first high-pass output sample</param>
+	/// <param name="bpsamples">pointer to first band-pass output sample</param>
+	/// <param name="lpsamples">pointer to first low-pass output sample</param>
+	/// <param name="numsamples">number of samples in the block</param>
+	void procblock(const double* insamples, double* hpsamples, double* bpsamples, double* lpsamples, int numsamples);
+
+	/// <summary>
+	/// Process a block of samples through filter with a center frequency for each sample
+	///
+	/// The center frequency is read once per control period (see setcontrolperiod()): F1 is
+	/// found from the frequency at the end of each period with fastF1(), and ramps linearly to
+	/// it over the period. Periods start at the beginning of the block, and the last one ends
+	/// with the block. Output pointers may be nullptr.
+	/// </summary>
+	/// <param name="insamples">pointer to first input sample</param>
+	/// <param name="Omegac">pointer to first center frequency (radians/sample)</param>
+	/// <param name="hpsamples">pointer to first high-pass output sample</param>
+	/// <param name="bpsamples">pointer to first band-pass output sample</param>
+	/// <param name="lpsamples">pointer to first low-pass output sample</param>
+	/// <param name="numsamples">number of samples in the block</param>
+	void procblock(const float* insamples, const float* Omegac, float* hpsamples, float* bpsamples,
+		float* lpsamples, int numsamples);
+
+	/// <summary>
+	/// Process a block of double precision samples through filter with a center frequency for
+	/// each sample
+	/// </summary>
+	/// <param name="insamples">pointer to first input sample</param>
+	/// <param name="Omegac">pointer to first center frequency (radians/sample)</param>
+	/// <param name="hpsamples">pointer to first high-pass output sample</param>
+	/// <param name="bpsamples">pointer to first band-pass output sample</param>
+	/// <param name="lpsamples">pointer to first low-pass output sample</param>
+	/// <param name="numsamples">number of samples in the block</param>
+	void procblock(const double* insamples, const double* Omegac, double* hpsamples, double* bpsamples,
+		double* lpsamples, int numsamples);
+
+	/// <summary>
+	/// Process a block of samples through filter with a new center frequency for the block
+	///
+	/// F1 ramps linearly from its current value to the value given by setF1(Omegac), reaching
+	/// it at the last sample. Output pointers may be nullptr.
+	/// </summary>
+	/// <param name="insamples">pointer to first input sample</param>
+	/// <param name="Omegac">center frequency at the end of the block (radians/sample)</param>
+	/// <param name="hpsamples">pointer to first high-pass output sample</param>
+	/// <param name="bpsamples">pointer to first band-pass output sample</param>
+	/// <param name="lpsamples">pointer to first low-pass output sample</param>
+	/// <param name="numsamples">number of samples in the block</param>
+	void procblock(const float* insamples, double Omegac, float* hpsamples, float* bpsamples, float* lpsamples,
+		int numsamples);
+
+	/// <summary>
+	/// Set control period of the modulated procblock()
+	/// </summary>
+	/// <param name="period">samples between reads of the center frequency (at least 1)</param>
+	void setcontrolperiod(int period) { controlperiod = period > 0 ? period : 1; }
+
+	/// <summary>
+	/// Get control period of the modulated procblock()
+	/// </summary>
+	/// <returns>samples between reads of the center frequency</returns>
+	int getcontrolperiod() const { return controlperiod; }
+
+	/// <summary>
+	/// Get high-pass output sample
+	/// </summary>
+	/// <returns>high-pass output sample</returns>
+	C gethp() { return hpout; }
+
+	/// <summary>
+	/// Get band-pass output sample
+	/// </summary>
+	/// <returns>band-pass output sample</returns>
+	C getbp() { return bpout; }
+
+	/// <summary>
+	/// Get low-pass output sample
+	/// </summary>
+	/// <returns>low-pass output sample</returns>
+	C getlp() { return lpout; }
+
+	/// <summary>
+	/// Set damping parameter
+	/// </summary>
+	/// <param name="dmp">damping parameter (no units)</param>
+	void setdamping(double dmp) { damping = C(dmp); }
+
+	/// <summary>
+	/// Set F1 parameter
+	/// </summary>
+	/// <param name="fc">center or cutoff frequency (Hz)</param>
+	/// <param name="fs">sampling frequency (Hz)</param>
+	void setF1(double fc, double fs) { F1 = C(2.0 * sin(PI * fc / fs)); }
+
+	/// <summary>
+	/// Set F1 parameter
+	/// </summary>
+	/// <param name="Omegac">center frequency (radians/sample)</param>
+	void setF1(double Omegac) { F1 = C(2.0 * sin(Omegac / 2.0)); }
+
+	/// <summary>
+	/// Reset state variables
+	/// </summary>
+	void reset();
+
+	/// <summary>
+	/// Write the state variables and parameters to a snapshot
+	/// </summary>
+	/// <param name="writer">snapshot</param>
+	void savestate(SnapshotWriter& writer) const;
+
+	/// <summary>
+	/// Restore everything written by savestate()
+	/// </summary>
+	/// <param name="reader">snapshot</param>
+	/// <returns>false if the next record is not a filter of this type</returns>
+	bool loadstate(SnapshotReader& reader);
+
+private:
+	template <typename SampleType>
+	void procsamples(const SampleType* insamples, SampleType* hpsamples, SampleType* bpsamples,
+		SampleType* lpsamples, int numsamples);
+	template <typename SampleType>
+	void procmodulated(const SampleType* insamples, const SampleType* Omegac, SampleType* hpsamples,
+		SampleType* bpsamples, SampleType* lpsamples, int numsamples);
+	template <typename SampleType>
+	void procramp(const SampleType* insamples, SampleType* hpsamples, SampleType* bpsamples,
+		SampleType* lpsamples, int numsamples, C target);
+
+	C hpout;
+	C bpout;
+	C lpout;
+	C damping;
+	C F1;
+	int controlperiod;
+};
+
+typedef SSfilterT<double> SSfilter;
+
@@ -0,0 +1,126 @@
+/*
+  ==============================================================================
+
+    SSfilterBank.cpp
+
+  ==============================================================================
+*/
+
+#include "SSfilterBank.h"
+#include "DSPkernels.h"
+#include "SSfilter.h"
+#include <algorithm>
+
+// Samples per pass of procblock; control periods may span several passes
+constexpr int SSBANKCHUNK = 64;
+
+SSfilterBank::SSfilterBank()
+{
+	numchans = 0;
+	numlanes = 0;
+	controlperiod = 16;
+}
+
+void SSfilterBank::setnumchannels(int numchannels)
+{
+	numchans = numchannels;
+	numlanes = (numchannels + MAXBANKLANES - 1) / MAXBANKLANES * MAXBANKLANES;
+	// unused lanes keep zero parameters, so their output stays zero
+	for (auto* v : { &damping, &df1, &F1, &bp, &lp, &target })
+	{
+		v->resize(numlanes, 0.0);
+		for (int n = numchans; n < numlanes; n++)
+			(*v)[n] = 0.0;
+	}
+}
+
+void SSfilterBank::setF1(int channel, double fc, double fs)
+{
+	F1[channel] = 2.0 * sin(PI * fc / fs);
+}
+
+void SSfilterBank::setF1(int channel, double Omegac)
+{
+	F1[channel] = 2.0 * sin(Omegac / 2.0);
+}
+
+void SSfilterBank::resetstate()
+{
+	for (int n = 0; n < numlanes; n++)
+	{
+		bp[n] = 0.0;
+		lp[n] = 0.0;
+	}
+}
+
+void SSfilterBank::procblock(const float* const* inchannels, const float* const* Omegac, float* const* hpchannels,
+	float* const* bpchannels, float* const* lpchannels, int numsamples)
+{
+	const int groupwidth = getkernels().banklanes;
+	alignas(64) double frames[SSBANKCHUNK * MAXBANKLANES];
+	alignas(64) double bpframes[SSBANKCHUNK * MAXBANKLANES];
+	alignas(64) double lpframes[SSBANKCHUNK * MAXBANKLANES];
+	if (!Omegac)
+		std::fill(df1.begin(), df1.end(), 0.0);
+	for (int group = 0; group < numchans; group += groupwidth)
+	{
+		const int used = numchans - group < groupwidth ? numchans - group : groupwidth;
+		const DSPkernels& kernels = getbankkernels(used);
+		const int width = kernels.banklanes;
+		const double* coefs[2] = { &damping[group], &df1[group] };
+		double* state[3] = { &F1[group], &bp[group], &lp[group] };
+		for (int start = 0; start < numsamples; start += SSBANKCHUNK)
+		{
+			int len = numsamples - start < SSBANKCHUNK ? numsamples - start : SSBANKCHUNK;
+			// gather the group into interleaved frames; unused lanes are fed zeros
+			for (int k = 0; k < width; k++)
+			{
+				const float* in = k < used ? inchannels[group + k] + start : nullptr;
+				for (int n = 0; n < len; n++)
+					frames[n * width + k] = in ? in[n] : 0.0;
+			}
+
+			// split the pass at the ends of control periods
+			for (int n = 0; n < len;)
+			{
+				const int pos = start + n;
+				int periodend = (pos / controlperiod + 1) * controlperiod;
+				if (periodend > numsamples)
+					periodend = numsamples;
+				if (Omegac && pos % controlperiod == 0)
+				{
+					for (int k = 0; k < used; k++)
+					{
+						const int ch = group + k;
+						target[ch] = fastF1(Omegac[ch][periodend - 1]);
+						df1[ch] = (target[ch] - F1[ch]) / double(periodend - pos);
+					}
+				}
+				const int count = (periodend < start + len ? periodend : start + len) - pos;
+				kernels.ssfilterbank(frames + n * width, bpframes + n * width, lpframes + n * width, count, coefs,
+					state);
+				n += count;
+				if (Omegac && pos + count == periodend)
+				{
+					// land exactly on the target, as SSfilter does
+					for (int k = 0; k < used; k++)
+						F1[group + k] = target[group + k];
+				}
+			}
+
+			for (int k = 0; k < used; k++)
+			{
+				const int ch = group + k;
+				if (hpchannels)
+					for (int n = 0; n < len; n++)
+						hpchannels[ch][start + n] = float(frames[n * width + k]);
+				if (bpchannels)
+					for (int n = 0; n < len; n++)
+						bpchannels[ch][start + n] = float(bpframes[n * width + k]);
+				if (lpchannels)
+					for (int n = 0; n < len; n++)
+						lpchannels[ch][start + n] = float(lpframes[n * width + k]);
+			}
+		}
+	}
+}
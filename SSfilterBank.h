@@ -0,0 +1,102 @@
+/*
+  ==============================================================================
+
+    SSfilterBank.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <vector>
+
+/// <summary>
+/// Bank of state space filters, one per channel, stepped in SIMD lanes
+///
+/// Each channel is an SSfilter with its own damping and center frequency, intended for many
+/// modulated voices (auto-wah, filter sweeps). Channels are stepped in groups of
+/// DSPkernels::banklanes by the ssfilterbank kernel, as in BQfilterBank. The center frequency
+/// of each channel may follow a stream of one value per sample: it is read once per control
+/// period, converted with fastF1() and F1 ramps linearly to it, exactly as in the modulated
+/// SSfilter::procblock(), so each channel's outputs are identical to those of an SSfilter
+/// given the same blocks.
+/// </summary>
+class SSfilterBank
+{
+public:
+	SSfilterBank();
+	~SSfilterBank() {}
+
+	/// <summary>
+	/// Set number of channels
+	///
+	/// Parameters and state of new channels are cleared.
+	/// </summary>
+	/// <param name="numchannels">number of channels</param>
+	void setnumchannels(int numchannels);
+
+	/// <summary>
+	/// Get number of channels
+	/// </summary>
+	/// <returns>number of channels</returns>
+	int getnumchannels() const { return numchans; }
+
+	/// <summary>
+	/// Set damping parameter of one channel
+	/// </summary>
+	/// <param name="channel">channel number</param>
+	/// <param name="dmp">damping parameter (no units)</param>
+	void setdamping(int channel, double dmp) { damping[channel] = dmp; }
+
+	/// <summary>
+	/// Set F1 parameter of one channel
+	/// </summary>
+	/// <param name="channel">channel number</param>
+	/// <param name="fc">center or cutoff frequency (Hz)</param>
+	/// <param name="fs">sampling frequency (Hz)</param>
+	void setF1(int channel, double fc, double fs);
+
+	/// <summary>
+	/// Set F1 parameter of one channel
+	/// </summary>
+	/// <param name="channel">channel number</param>
+	/// <param name="Omegac">center frequency (radians/sample)</param>
+	void setF1(int channel, double Omegac);
+
+	/// <summary>
+	/// Set control period of the center frequency streams
+	/// </summary>
+	/// <param name="period">samples between reads of the center frequency (at least 1)</param>
+	void setcontrolperiod(int period) { controlperiod = period > 0 ? period : 1; }
+
+	/// <summary>
+	/// Reset the state variables of every channel
+	/// </summary>
+	void resetstate();
+
+	/// <summary>
+	/// Process a block of samples for every channel
+	///
+	/// Channel buffers are given as arrays of pointers, as in a JUCE AudioBuffer. Any of the
+	/// output arrays may be nullptr if that output is not needed, and an output pointer for a
+	/// channel may be the same as its input pointer.
+	/// </summary>
+	/// <param name="inchannels">array of numchannels pointers to input samples</param>
+	/// <param name="Omegac">array of numchannels pointers to center frequencies (radians/sample),
+	/// or nullptr to keep the frequencies set by setF1()</param>
+	/// <param name="hpchannels">array of numchannels pointers to high-pass output samples</param>
+	/// <param name="bpchannels">array of numchannels pointers to band-pass output samples</param>
+	/// <param name="lpchannels">array of numchannels pointers to low-pass output samples</param>
+	/// <param name="numsamples">number of samples in the block</param>
+	void procblock(const float* const* inchannels, const float* const* Omegac, float* const* hpchannels,
+		float* const* bpchannels, float* const* lpchannels, int numsamples);
+
+private:
+	int numchans;
+	int numlanes; // numchans rounded up to a whole number of lane groups
+	int controlperiod;
+	// parameters and state, one entry per lane
+	std::vector<double> damping, df1;
+	std::vector<double> F1, bp, lp;
+	std::vector<double> target; // F1 at the end of the current control period
+};
@@ -0,0 +1,241 @@
+/*
+  ==============================================================================
+
+    StateSnapshot.cpp
+
+  ==============================================================================
+*/
+
+#include "StateSnapshot.h"
+#include <cstdio>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Snapshot header: tag, version, sample position and total size
+constexpr std::uint32_t SNAPSHOTMAGIC = snapshottag("ACSS");
+constexpr std::size_t SNAPSHOTHEADER = 24;
+constexpr std::size_t RECORDHEADER = 8;
+constexpr std::size_t SNAPSHOTALIGN = 8;
+
+SnapshotWriter::SnapshotWriter(unsigned long long position)
+{
+	clear(position);
+}
+
+void SnapshotWriter::clear(unsigned long long position)
+{
+	bytes.assign(SNAPSHOTHEADER, 0);
+	const std::uint32_t magic = SNAPSHOTMAGIC;
+	const std::uint64_t pos = position;
+	std::memcpy(&bytes[0], &magic, 4);
+	std::memcpy(&bytes[4], &SNAPSHOTVERSION, 4);
+	std::memcpy(&bytes[8], &pos, 8);
+	setsize();
+	recordstart = 0;
+}
+
+void SnapshotWriter::begin(std::uint32_t tag)
+{
+	if (recordstart)
+		end();
+	recordstart = bytes.size();
+	bytes.resize(recordstart + RECORDHEADER, 0);
+	std::memcpy(&bytes[recordstart], &tag, 4);
+}
+
+void SnapshotWriter::end()
+{
+	if (!recordstart)
+		return;
+	const std::uint32_t payload = std::uint32_t(bytes.size() - recordstart - RECORDHEADER);
+	std::memcpy(&bytes[recordstart + 4], &payload, 4);
+	align();
+	recordstart = 0;
+	setsize();
+}
+
+bool SnapshotWriter::save(const char* filename) const
+{
+	FILE* file = std::fopen(filename, "wb");
+	if (!file)
+		return false;
+	const bool written = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+	return std::fclose(file) == 0 && written;
+}
+
+void SnapshotWriter::putbytes(const void* src, std::size_t count)
+{
+	if (count == 0)
+		return;
+	const std::size_t at = bytes.size();
+	bytes.resize(at + count);
+	std::memcpy(&bytes[at], src, count);
+}
+
+void SnapshotWriter::align()
+{
+	bytes.resize((bytes.size() + SNAPSHOTALIGN - 1) / SNAPSHOTALIGN * SNAPSHOTALIGN, 0);
+}
+
+void SnapshotWriter::setsize()
+{
+	const std::uint64_t total = bytes.size();
+	std::memcpy(&bytes[16], &total, 8);
+}
+
+SnapshotReader::SnapshotReader()
+{
+	base = nullptr;
+	length = 0;
+	pos = 0;
+	recordend = 0;
+	position = 0;
+	ok = false;
+	mapping = nullptr;
+	mapsize = 0;
+}
+
+SnapshotReader::SnapshotReader(const void* data, std::size_t size) : SnapshotReader()
+{
+	attach(data, size);
+}
+
+SnapshotReader::~SnapshotReader()
+{
+	unmap();
+}
+
+bool SnapshotReader::open(const char* filename)
+{
+	unmap();
+	attach(nullptr, 0);
+#if defined(_WIN32)
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER filesize;
+	HANDLE view = nullptr;
+	if (GetFileSizeEx(file, &filesize) && filesize.QuadPart > 0)
+		view = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (!view)
+		return false;
+	mapping = MapViewOfFile(view, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(view);
+	if (!mapping)
+		return false;
+	mapsize = std::size_t(filesize.QuadPart);
+#else
+	const int file = ::open(filename, O_RDONLY);
+	if (file < 0)
+		return false;
+	struct stat info;
+	void* block = MAP_FAILED;
+	if (fstat(file, &info) == 0 && info.st_size > 0)
+		block = mmap(nullptr, std::size_t(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (block == MAP_FAILED)
+		return false;
+	mapping = block;
+	mapsize = std::size_t(info.st_size);
+#endif
+	return attach(mapping, mapsize);
+}
+
+void SnapshotReader::rewind()
+{
+	attach(base, length);
+}
+
+bool SnapshotReader::begin(std::uint32_t tag)
+{
+	end();
+	if (!ok || length - pos < RECORDHEADER)
+		return ok = false;
+	std::uint32_t recordtag, payload;
+	std::memcpy(&recordtag, base + pos, 4);
+	std::memcpy(&payload, base + pos + 4, 4);
+	if (recordtag != tag || payload > length - pos - RECORDHEADER)
+		return ok = false;
+	pos += RECORDHEADER;
+	recordend = pos + payload;
+	return true;
+}
+
+bool SnapshotReader::end()
+{
+	if (!ok)
+		return false;
+	pos = (recordend + SNAPSHOTALIGN - 1) / SNAPSHOTALIGN * SNAPSHOTALIGN;
+	if (pos > length)
+		pos = length;
+	recordend = pos;
+	return true;
+}
+
+bool SnapshotReader::attach(const void* data, std::size_t size)
+{
+	base = static_cast<const char*>(data);
+	length = size;
+	pos = SNAPSHOTHEADER;
+	recordend = pos;
+	position = 0;
+	ok = false;
+	if (!base || length < SNAPSHOTHEADER)
+		return false;
+	std::uint32_t magic, version;
+	std::uint64_t pos64, total;
+	std::memcpy(&magic, base, 4);
+	std::memcpy(&version, base + 4, 4);
+	std::memcpy(&pos64, base + 8, 8);
+	std::memcpy(&total, base + 16, 8);
+	// a snapshot written with the other byte order fails the tag check
+	if (magic != SNAPSHOTMAGIC || version != SNAPSHOTVERSION || total < SNAPSHOTHEADER || total > length)
+		return false;
+	length = std::size_t(total);
+	position = pos64;
+	return ok = true;
+}
+
+const char* SnapshotReader::take(std::size_t count)
+{
+	if (!ok || count > recordend - pos)
+	{
+		ok = false;
+		return nullptr;
+	}
+	const char* src = base + pos;
+	pos += count;
+	return src;
+}
+
+void SnapshotReader::align()
+{
+	if (!ok)
+		return;
+	const std::size_t aligned = (pos + SNAPSHOTALIGN - 1) / SNAPSHOTALIGN * SNAPSHOTALIGN;
+	pos = aligned < recordend ? aligned : recordend;
+}
+
+void SnapshotReader::unmap()
+{
+	if (mapping)
+	{
+#if defined(_WIN32)
+		UnmapViewOfFile(mapping);
+#else
+		munmap(mapping, mapsize);
+#endif
+	}
+	mapping = nullptr;
+	mapsize = 0;
+}
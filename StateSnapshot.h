@@ -0,0 +1,227 @@
+/*
+  ==============================================================================
+
+    StateSnapshot.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+// Version of the snapshot format written by SnapshotWriter
+constexpr std::uint32_t SNAPSHOTVERSION = 1;
+
+/// <summary>
+/// Make a record tag from four characters
+/// </summary>
+/// <param name="name">tag name</param>
+/// <returns>tag</returns>
+constexpr std::uint32_t snapshottag(const char (&name)[5])
+{
+	return std::uint32_t(std::uint8_t(name[0])) | std::uint32_t(std::uint8_t(name[1])) << 8 |
+		std::uint32_t(std::uint8_t(name[2])) << 16 | std::uint32_t(std::uint8_t(name[3])) << 24;
+}
+
+/// <summary>
+/// Binary snapshot of the state of a set of filters and networks
+///
+/// A snapshot records everything an object needs to carry on exactly where it was: state
+/// variables, delay line contents and parameters. For offline rendering with random access,
+/// take a snapshot every few seconds; to seek, restore the nearest earlier one and render
+/// forward from there, rather than from the start of the file.
+///
+/// The format is a 24 byte header (tag "ACSS", version, sample position and total size)
+/// followed by one record per object: a four character tag, the payload size, and the payload
+/// in native byte order, padded to a multiple of 8 bytes. Arrays start on 8 byte boundaries,
+/// so a snapshot file can be mapped into memory and read in place (see SnapshotReader::open()).
+/// Objects write their records with savestate() and read them back, in the same order, with
+/// loadstate(); nothing is written for external connections such as MPnetwork sources.
+/// </summary>
+class SnapshotWriter
+{
+public:
+	/// <summary>
+	/// Start a snapshot
+	/// </summary>
+	/// <param name="position">sample position the snapshot belongs to</param>
+	explicit SnapshotWriter(unsigned long long position = 0);
+	~SnapshotWriter() {}
+
+	/// <summary>
+	/// Discard the records and start again
+	/// </summary>
+	/// <param name="position">sample position the snapshot belongs to</param>
+	void clear(unsigned long long position = 0);
+
+	/// <summary>
+	/// Start a record (records are not nested)
+	/// </summary>
+	/// <param name="tag">record tag</param>
+	void begin(std::uint32_t tag);
+
+	/// <summary>
+	/// Add a value to the current record
+	/// </summary>
+	/// <param name="value">value</param>
+	template <typename V>
+	void put(const V& value)
+	{
+		static_assert(std::is_trivially_copyable<V>::value, "values must be trivially copyable");
+		putbytes(&value, sizeof(V));
+	}
+
+	/// <summary>
+	/// Add an array to the current record, starting on an 8 byte boundary
+	/// </summary>
+	/// <param name="values">first value</param>
+	/// <param name="count">number of values</param>
+	template <typename V>
+	void put(const V* values, std::size_t count)
+	{
+		static_assert(std::is_trivially_copyable<V>::value, "values must be trivially copyable");
+		align();
+		putbytes(values, count * sizeof(V));
+	}
+
+	/// <summary>
+	/// Finish the current record
+	/// </summary>
+	void end();
+
+	/// <summary>
+	/// Get the snapshot
+	/// </summary>
+	/// <returns>pointer to the first byte</returns>
+	const void* data() const { return bytes.data(); }
+
+	/// <summary>
+	/// Get the size of the snapshot
+	/// </summary>
+	/// <returns>size (bytes)</returns>
+	std::size_t size() const { return bytes.size(); }
+
+	/// <summary>
+	/// Write the snapshot to a file
+	/// </summary>
+	/// <param name="filename">file name</param>
+	/// <returns>false if the file could not be written</returns>
+	bool save(const char* filename) const;
+
+private:
+	void putbytes(const void* src, std::size_t count);
+	void align();
+	void setsize();
+
+	std::vector<char> bytes;
+	std::size_t recordstart;
+};
+
+/// <summary>
+/// Reader of a snapshot made by SnapshotWriter
+///
+/// The reader works on the snapshot where it lies, either in memory or in a file mapped by
+/// open(); nothing is copied until an object takes its values. Every method returns false
+/// once the snapshot turns out not to match what is asked for, and keeps doing so, so an
+/// object can read all of its values and check once.
+/// </summary>
+class SnapshotReader
+{
+public:
+	SnapshotReader();
+
+	/// <summary>
+	/// Read a snapshot in memory
+	/// </summary>
+	/// <param name="data">snapshot (must stay valid while it is read)</param>
+	/// <param name="size">size (bytes)</param>
+	SnapshotReader(const void* data, std::size_t size);
+	~SnapshotReader();
+	SnapshotReader(const SnapshotReader&) = delete;
+	SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+	/// <summary>
+	/// Map a snapshot file into memory
+	/// </summary>
+	/// <param name="filename">file name</param>
+	/// <returns>false if the file could not be mapped or is not a snapshot</returns>
+	bool open(const char* filename);
+
+	/// <summary>
+	/// Check that the snapshot is valid and nothing has failed to read
+	/// </summary>
+	/// <returns>true if valid</returns>
+	bool isvalid() const { return ok; }
+
+	/// <summary>
+	/// Get the sample position the snapshot belongs to
+	/// </summary>
+	/// <returns>sample position</returns>
+	unsigned long long getposition() const { return position; }
+
+	/// <summary>
+	/// Go back to the first record
+	/// </summary>
+	void rewind();
+
+	/// <summary>
+	/// Start reading the next record
+	/// </summary>
+	/// <param name="tag">tag the record must have</param>
+	/// <returns>false if the next record has another tag</returns>
+	bool begin(std::uint32_t tag);
+
+	/// <summary>
+	/// Take a value from the current record
+	/// </summary>
+	/// <param name="value">value (output)</param>
+	/// <returns>false if the record has no more values</returns>
+	template <typename V>
+	bool get(V& value)
+	{
+		static_assert(std::is_trivially_copyable<V>::value, "values must be trivially copyable");
+		const char* src = take(sizeof(V));
+		if (src)
+			std::memcpy(&value, src, sizeof(V));
+		return src != nullptr;
+	}
+
+	/// <summary>
+	/// Take an array from the current record, in place
+	/// </summary>
+	/// <param name="count">number of values</param>
+	/// <returns>pointer to the first value in the snapshot, or nullptr if the record is too short</returns>
+	template <typename V>
+	const V* getarray(std::size_t count)
+	{
+		static_assert(std::is_trivially_copyable<V>::value, "values must be trivially copyable");
+		align();
+		return reinterpret_cast<const V*>(take(count * sizeof(V)));
+	}
+
+	/// <summary>
+	/// Finish the current record, skipping anything not read
+	/// </summary>
+	/// <returns>false if anything failed since the record began</returns>
+	bool end();
+
+private:
+	bool attach(const void* data, std::size_t size);
+	const char* take(std::size_t count);
+	void align();
+	void unmap();
+
+	const char* base;
+	std::size_t length;
+	std::size_t pos;
+	std::size_t recordend;
+	unsigned long long position;
+	bool ok;
+	void* mapping;
+	std::size_t mapsize;
+};
@@ -0,0 +1,124 @@
+/*
+  ==============================================================================
+
+    TaskPool.cpp
+
+  ==============================================================================
+*/
+
+#include "TaskPool.h"
+#include "DenormalContext.h"
+
+// Pool and queue of the current thread, if it is a pool thread
+static thread_local const TaskPool* currentpool = nullptr;
+static thread_local unsigned int currentqueue = 0;
+
+TaskPool::TaskPool(unsigned int numthreads)
+{
+	if (numthreads == 0)
+		numthreads = std::thread::hardware_concurrency();
+	if (numthreads == 0)
+		numthreads = 1;
+	queued = 0;
+	stopping = false;
+	for (unsigned int k = 0; k < numthreads; k++)
+		queues.emplace_back(new Queue);
+	for (unsigned int k = 1; k < numthreads; k++)
+		threads.emplace_back(&TaskPool::worker, this, k);
+}
+
+TaskPool::~TaskPool()
+{
+	{
+		std::lock_guard<std::mutex> guard(sleeplock);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (auto& thread : threads)
+		thread.join();
+}
+
+void TaskPool::submit(TaskGroup& group, std::function<void()> task)
+{
+	group.pending.fetch_add(1, std::memory_order_relaxed);
+	Queue& queue = *queues[queueindex()];
+	{
+		std::lock_guard<std::mutex> guard(queue.lock);
+		queue.tasks.push_back(Task{ std::move(task), &group, DenormalContext::isthreadflushing() });
+	}
+	{
+		// taking the lock orders the count against a worker about to sleep
+		std::lock_guard<std::mutex> guard(sleeplock);
+		queued.fetch_add(1, std::memory_order_relaxed);
+	}
+	wake.notify_one();
+}
+
+void TaskPool::wait(TaskGroup& group)
+{
+	const unsigned int self = queueindex();
+	while (!group.isdone())
+	{
+		if (!runone(self))
+			std::this_thread::yield();
+	}
+}
+
+bool TaskPool::runone(unsigned int self)
+{
+	Task task;
+	bool found = false;
+	{
+		// newest task of our own queue first
+		Queue& own = *queues[self];
+		std::lock_guard<std::mutex> guard(own.lock);
+		if (!own.tasks.empty())
+		{
+			task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+			found = true;
+		}
+	}
+	// otherwise steal the oldest task of another queue
+	for (unsigned int k = 1; !found && k < queues.size(); k++)
+	{
+		Queue& other = *queues[(self + k) % queues.size()];
+		std::lock_guard<std::mutex> guard(other.lock);
+		if (!other.tasks.empty())
+		{
+			task = std::move(other.tasks.front());
+			other.tasks.pop_front();
+			found = true;
+		}
+	}
+	if (!found)
+		return false;
+	queued.fetch_sub(1, std::memory_order_relaxed);
+	{
+		// A waiting thread may itself be flushing, so the mode is set either way
+		DenormalContext context(task.flush ? DenormalMode::FLUSH : DenormalMode::NOFLUSH);
+		task.run();
+	}
+	task.group->pending.fetch_sub(1, std::memory_order_release);
+	return true;
+}
+
+void TaskPool::worker(unsigned int self)
+{
+	currentpool = this;
+	currentqueue = self;
+	for (;;)
+	{
+		if (runone(self))
+			continue;
+		std::unique_lock<std::mutex> guard(sleeplock);
+		wake.wait(guard, [this]() { return stopping || queued.load(std::memory_order_relaxed) > 0; });
+		if (stopping)
+			return;
+	}
+}
+
+unsigned int TaskPool::queueindex() const
+{
+	return currentpool == this ? currentqueue : 0;
+}
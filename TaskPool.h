@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+
+    TaskPool.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// Set of tasks that can be waited for together
+/// </summary>
+class TaskGroup
+{
+public:
+	TaskGroup() : pending(0) {}
+
+	/// <summary>
+	/// Check whether every task of the group has finished
+	/// </summary>
+	/// <returns>true when no task is pending</returns>
+	bool isdone() const { return pending.load(std::memory_order_acquire) == 0; }
+
+private:
+	friend class TaskPool;
+	std::atomic<int> pending;
+};
+
+/// <summary>
+/// Work-stealing thread pool
+///
+/// Each thread has its own queue of tasks. A thread takes the newest task from its own queue,
+/// and when that is empty steals the oldest task from another queue, so large tasks that
+/// spawn subtasks keep them close while idle threads take work away. A thread waiting for a
+/// group runs queued tasks until the group is done, so tasks may wait for subtasks without
+/// tying up a thread. The thread calling wait() counts as one of the pool's threads. Each task
+/// runs with the subnormal number handling (see DenormalContext) of the thread that queued it.
+/// </summary>
+class TaskPool
+{
+public:
+	/// <summary>
+	/// Create a pool
+	/// </summary>
+	/// <param name="numthreads">number of threads, including the one calling wait() (0 for one per core)</param>
+	explicit TaskPool(unsigned int numthreads = 0);
+	~TaskPool();
+	TaskPool(const TaskPool&) = delete;
+	TaskPool& operator=(const TaskPool&) = delete;
+
+	/// <summary>
+	/// Queue a task
+	/// </summary>
+	/// <param name="group">group the task belongs to</param>
+	/// <param name="task">task</param>
+	void submit(TaskGroup& group, std::function<void()> task);
+
+	/// <summary>
+	/// Run tasks until every task of a group has finished
+	/// </summary>
+	/// <param name="group">group to wait for</param>
+	void wait(TaskGroup& group);
+
+	/// <summary>
+	/// Get number of threads
+	/// </summary>
+	/// <returns>number of threads (including the waiting thread)</returns>
+	unsigned int getnumthreads() const { return unsigned(queues.size()); }
+
+private:
+	struct Task
+	{
+		std::function<void()> run;
+		TaskGroup* group;
+		bool flush; // submitting thread flushed subnormal numbers to zero
+	};
+	struct Queue
+	{
+		std::mutex lock;
+		std::deque<Task> tasks;
+	};
+
+	bool runone(unsigned int self);
+	void worker(unsigned int self);
+	unsigned int queueindex() const;
+
+	// queue 0 belongs to threads outside the pool
+	std::vector<std::unique_ptr<Queue>> queues;
+	std::vector<std::thread> threads;
+	std::atomic<int> queued;
+	std::mutex sleeplock;
+	std::condition_variable wake;
+	bool stopping;
+};
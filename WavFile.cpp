@@ -0,0 +1,642 @@
+/*
+  ==============================================================================
+
+    WavFile.cpp
+
+  ==============================================================================
+*/
+
+#include "WavFile.h"
+#include "DSPkernels.h"
+#include <cstring>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Samples are stored little-endian, as on every processor the kernels are compiled for
+
+int samplebytes(SampleFormat format)
+{
+	switch (format)
+	{
+	case SampleFormat::INT16: return 2;
+	case SampleFormat::INT24: return 3;
+	case SampleFormat::INT32: return 4;
+	case SampleFormat::FLOAT32: return 4;
+	case SampleFormat::FLOAT64: return 8;
+	}
+	return 0;
+}
+
+//==============================================================================
+MappedFile::MappedFile()
+{
+	handle = invalidhandle();
+#if defined(_WIN32)
+	mapping = nullptr;
+#endif
+	base = nullptr;
+	length = 0;
+	writable = false;
+}
+
+bool MappedFile::openread(const char* filename)
+{
+	close();
+	writable = false;
+#if defined(_WIN32)
+	handle = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	LARGE_INTEGER filesize;
+	if (handle == invalidhandle() || !GetFileSizeEx(handle, &filesize))
+	{
+		close();
+		return false;
+	}
+	length = static_cast<unsigned long long>(filesize.QuadPart);
+#else
+	handle = ::open(filename, O_RDONLY);
+	struct stat info;
+	if (handle == invalidhandle() || fstat(handle, &info) != 0)
+	{
+		close();
+		return false;
+	}
+	length = static_cast<unsigned long long>(info.st_size);
+#endif
+	if (!map())
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+bool MappedFile::opencreate(const char* filename, unsigned long long size)
+{
+	close();
+	writable = true;
+#if defined(_WIN32)
+	handle = CreateFileA(filename, GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+		FILE_ATTRIBUTE_NORMAL, nullptr);
+#else
+	handle = ::open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+#endif
+	if (handle == invalidhandle() || !resize(size))
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+bool MappedFile::resize(unsigned long long size)
+{
+	if (!writable || handle == invalidhandle())
+		return false;
+	unmap();
+#if defined(_WIN32)
+	LARGE_INTEGER end;
+	end.QuadPart = static_cast<LONGLONG>(size);
+	if (!SetFilePointerEx(handle, end, nullptr, FILE_BEGIN) || !SetEndOfFile(handle))
+		return false;
+#else
+	if (ftruncate(handle, static_cast<off_t>(size)) != 0)
+		return false;
+#endif
+	length = size;
+	return map();
+}
+
+void MappedFile::close()
+{
+	unmap();
+	if (handle != invalidhandle())
+	{
+#if defined(_WIN32)
+		CloseHandle(handle);
+#else
+		::close(handle);
+#endif
+	}
+	handle = invalidhandle();
+	length = 0;
+}
+
+bool MappedFile::map()
+{
+	// an empty file cannot be mapped, but is still open
+	if (length == 0)
+		return true;
+#if defined(_WIN32)
+	mapping = CreateFileMappingA(handle, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY,
+		DWORD(length >> 32), DWORD(length & 0xffffffff), nullptr);
+	if (!mapping)
+		return false;
+	base = static_cast<unsigned char*>(MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0));
+#else
+	void* p = mmap(nullptr, std::size_t(length), writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED,
+		handle, 0);
+	base = p == MAP_FAILED ? nullptr : static_cast<unsigned char*>(p);
+	// files are streamed front to back, so pages already used can be dropped early
+	if (base)
+		madvise(base, std::size_t(length), MADV_SEQUENTIAL);
+#endif
+	return base != nullptr;
+}
+
+void MappedFile::unmap()
+{
+#if defined(_WIN32)
+	if (base)
+		UnmapViewOfFile(base);
+	if (mapping)
+		CloseHandle(mapping);
+	mapping = nullptr;
+#else
+	if (base)
+		munmap(base, std::size_t(length));
+#endif
+	base = nullptr;
+}
+
+//==============================================================================
+BufferedWriter::BufferedWriter()
+{
+	fp = nullptr;
+	fill = 0;
+	written = 0;
+	ok = false;
+}
+
+bool BufferedWriter::open(const char* filename, std::size_t buffersize)
+{
+	close();
+	fp = fopen(filename, "wb");
+	if (!fp)
+		return false;
+	// the buffer here replaces the one in the C library
+	setvbuf(fp, nullptr, _IONBF, 0);
+	buffer.resize(buffersize > 0 ? buffersize : 1);
+	fill = 0;
+	written = 0;
+	ok = true;
+	return true;
+}
+
+bool BufferedWriter::write(const void* src, std::size_t numbytes)
+{
+	if (!fp)
+		return false;
+	const unsigned char* bytes = static_cast<const unsigned char*>(src);
+	if (fill + numbytes > buffer.size())
+	{
+		flush();
+		// blocks at least as large as the buffer go straight to the file
+		if (numbytes >= buffer.size())
+		{
+			if (fwrite(bytes, 1, numbytes, fp) != numbytes)
+				ok = false;
+			written += numbytes;
+			return ok;
+		}
+	}
+	std::memcpy(buffer.data() + fill, bytes, numbytes);
+	fill += numbytes;
+	return ok;
+}
+
+bool BufferedWriter::patch(unsigned long long offset, const void* src, std::size_t numbytes)
+{
+	if (!fp || !flush())
+		return false;
+#if defined(_WIN32)
+	bool moved = _fseeki64(fp, static_cast<long long>(offset), SEEK_SET) == 0;
+#else
+	bool moved = fseeko(fp, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+	if (!moved || fwrite(src, 1, numbytes, fp) != numbytes)
+		ok = false;
+#if defined(_WIN32)
+	_fseeki64(fp, 0, SEEK_END);
+#else
+	fseeko(fp, 0, SEEK_END);
+#endif
+	return ok;
+}
+
+bool BufferedWriter::close()
+{
+	if (!fp)
+		return false;
+	flush();
+	if (fclose(fp) != 0)
+		ok = false;
+	fp = nullptr;
+	return ok;
+}
+
+bool BufferedWriter::flush()
+{
+	if (fill > 0 && fwrite(buffer.data(), 1, fill, fp) != fill)
+		ok = false;
+	written += fill;
+	fill = 0;
+	return ok;
+}
+
+//==============================================================================
+// Little-endian header fields
+static unsigned int get16(const unsigned char* p) { return p[0] | p[1] << 8; }
+static unsigned int get32(const unsigned char* p) { return get16(p) | get16(p + 2) << 16; }
+static unsigned long long get64(const unsigned char* p)
+{
+	return get32(p) | static_cast<unsigned long long>(get32(p + 4)) << 32;
+}
+static void put16(unsigned char* p, unsigned int x)
+{
+	p[0] = static_cast<unsigned char>(x);
+	p[1] = static_cast<unsigned char>(x >> 8);
+}
+static void put32(unsigned char* p, unsigned int x)
+{
+	put16(p, x & 0xffff);
+	put16(p + 2, x >> 16);
+}
+static void put64(unsigned char* p, unsigned long long x)
+{
+	put32(p, static_cast<unsigned int>(x));
+	put32(p + 4, static_cast<unsigned int>(x >> 32));
+}
+
+constexpr unsigned int WAVE_FORMAT_PCM = 1;
+constexpr unsigned int WAVE_FORMAT_IEEE_FLOAT = 3;
+constexpr unsigned int WAVE_FORMAT_EXTENSIBLE = 0xfffe;
+// Tail of the KSDATAFORMAT_SUBTYPE GUIDs, after the two byte format tag
+static const unsigned char SUBTYPE_TAIL[14] = { 0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xaa,
+	0x00, 0x38, 0x9b, 0x71 };
+
+WavReader::WavReader()
+{
+	samples = nullptr;
+	numchannels = 0;
+	sampRate = 0.0;
+	format = SampleFormat::INT16;
+	numframes = 0;
+	position = 0;
+}
+
+bool WavReader::open(const char* filename)
+{
+	close();
+	if (!file.openread(filename) || file.size() < 12)
+		return false;
+	const unsigned char* p = file.data();
+	const unsigned long long filesize = file.size();
+	const bool rf64 = !std::memcmp(p, "RF64", 4);
+	if ((!rf64 && std::memcmp(p, "RIFF", 4)) || std::memcmp(p + 8, "WAVE", 4))
+		return false;
+
+	// Walk the chunks, taking the format and the location of the samples
+	unsigned long long ds64datasize = 0;
+	unsigned long long dataoffset = 0, datasize = 0;
+	bool havefmt = false, havedata = false;
+	unsigned int tag = 0, bits = 0, blockalign = 0;
+	unsigned long long pos = 12;
+	while (pos + 8 <= filesize && !(havefmt && havedata))
+	{
+		const unsigned char* chunk = p + pos;
+		unsigned long long size = get32(chunk + 4);
+		const unsigned long long avail = filesize - pos - 8;
+		if (!std::memcmp(chunk, "ds64", 4) && size >= 16 && avail >= 16)
+			ds64datasize = get64(chunk + 16);
+		else if (!std::memcmp(chunk, "fmt ", 4) && size >= 16 && avail >= 16)
+		{
+			tag = get16(chunk + 8);
+			numchannels = int(get16(chunk + 10));
+			sampRate = double(get32(chunk + 12));
+			blockalign = get16(chunk + 20);
+			bits = get16(chunk + 22);
+			if (tag == WAVE_FORMAT_EXTENSIBLE && size >= 40 && avail >= 40)
+			{
+				if (std::memcmp(chunk + 34, SUBTYPE_TAIL, sizeof(SUBTYPE_TAIL)))
+					return false;
+				tag = get16(chunk + 32);
+			}
+			havefmt = true;
+		}
+		else if (!std::memcmp(chunk, "data", 4))
+		{
+			if (rf64 && size == 0xffffffff)
+				size = ds64datasize;
+			dataoffset = pos + 8;
+			// a file whose writer did not finish has a short or missing length
+			datasize = size < avail && size > 0 ? size : avail;
+			havedata = true;
+		}
+		pos += 8 + size + (size & 1);
+	}
+	if (!havefmt || !havedata || numchannels < 1)
+		return false;
+
+	if (tag == WAVE_FORMAT_PCM && bits == 16)
+		format = SampleFormat::INT16;
+	else if (tag == WAVE_FORMAT_PCM && bits == 24)
+		format = SampleFormat::INT24;
+	else if (tag == WAVE_FORMAT_PCM && bits == 32)
+		format = SampleFormat::INT32;
+	else if (tag == WAVE_FORMAT_IEEE_FLOAT && bits == 32)
+		format = SampleFormat::FLOAT32;
+	else if (tag == WAVE_FORMAT_IEEE_FLOAT && bits == 64)
+		format = SampleFormat::FLOAT64;
+	else
+		return false;
+	if (blockalign != unsigned(numchannels * samplebytes(format)))
+		return false;
+
+	samples = p + dataoffset;
+	numframes = datasize / blockalign;
+	position = 0;
+	return true;
+}
+
+void WavReader::close()
+{
+	file.close();
+	samples = nullptr;
+	numchannels = 0;
+	numframes = 0;
+	position = 0;
+}
+
+int WavReader::read(float* const* channels, int maxframes)
+{
+	if (maxframes <= 0 || position >= numframes)
+		return 0;
+	const int count = numframes - position < unsigned(maxframes) ? int(numframes - position) : maxframes;
+	const int numsamples = count * numchannels;
+	const std::size_t numbytes = std::size_t(numsamples) * samplebytes(format);
+	const unsigned char* src = samples + position * numchannels * samplebytes(format);
+	position += count;
+
+	// Convert into the interleaved buffer (or straight into the output for one channel)
+	const DSPkernels& kernels = getkernels();
+	if (interleaved.size() < std::size_t(numsamples))
+		interleaved.resize(numsamples);
+	float* dest = numchannels == 1 ? channels[0] : interleaved.data();
+	if (format == SampleFormat::FLOAT32)
+		std::memcpy(dest, src, numbytes);
+	else
+	{
+		// samples in the file need not be aligned, so they are copied before conversion
+		if (raw.size() < std::size_t(numsamples) * 8)
+			raw.resize(std::size_t(numsamples) * 8);
+		switch (format)
+		{
+		case SampleFormat::INT16:
+			std::memcpy(raw.data(), src, numbytes);
+			kernels.int16tofloat(reinterpret_cast<const short*>(raw.data()), dest, numsamples);
+			break;
+		case SampleFormat::INT24:
+		{
+			int* wide = reinterpret_cast<int*>(raw.data());
+			for (int n = 0; n < numsamples; n++, src += 3)
+				wide[n] = int(static_cast<unsigned int>(src[0]) << 8 | static_cast<unsigned int>(src[1]) << 16
+					| static_cast<unsigned int>(src[2]) << 24);
+			kernels.int32tofloat(wide, dest, numsamples);
+			break;
+		}
+		case SampleFormat::INT32:
+			std::memcpy(raw.data(), src, numbytes);
+			kernels.int32tofloat(reinterpret_cast<const int*>(raw.data()), dest, numsamples);
+			break;
+		default:
+			std::memcpy(raw.data(), src, numbytes);
+			kernels.doubletofloat(reinterpret_cast<const double*>(raw.data()), dest, numsamples);
+			break;
+		}
+	}
+	if (numchannels > 1)
+	{
+		for (int ch = 0; ch < numchannels; ch++)
+		{
+			float* out = channels[ch];
+			const float* in = interleaved.data() + ch;
+			for (int n = 0; n < count; n++)
+				out[n] = in[n * numchannels];
+		}
+	}
+	return count;
+}
+
+//==============================================================================
+// Header layout written by WavWriter: RIFF header, JUNK chunk reserving room for a ds64
+// chunk, fmt chunk, data chunk header
+constexpr unsigned int RIFFSIZE_OFFSET = 4;
+constexpr unsigned int JUNK_OFFSET = 12;
+constexpr unsigned int DS64_BODY = 28;
+constexpr unsigned int FMT_OFFSET = JUNK_OFFSET + 8 + DS64_BODY;
+// Initial size and smallest growth of a mapped output file (bytes)
+constexpr unsigned long long MAPGROWTH = 1ull << 24;
+
+WavWriter::WavWriter()
+{
+	mapped = true;
+	isopen = false;
+	ok = false;
+	numchannels = 0;
+	format = SampleFormat::FLOAT32;
+	datastart = 0;
+	position = 0;
+	numframes = 0;
+}
+
+bool WavWriter::open(const char* filename, int numchans, double fs, SampleFormat fmt, bool usemap)
+{
+	close();
+	if (numchans < 1)
+		return false;
+	mapped = usemap;
+	numchannels = numchans;
+	format = fmt;
+	numframes = 0;
+	position = 0;
+	if (usemap ? !file.opencreate(filename, MAPGROWTH) : !stream.open(filename))
+		return false;
+	isopen = true;
+	ok = true;
+
+	const bool isfloat = fmt == SampleFormat::FLOAT32 || fmt == SampleFormat::FLOAT64;
+	const unsigned int tag = isfloat ? WAVE_FORMAT_IEEE_FLOAT : WAVE_FORMAT_PCM;
+	const unsigned int bytes = unsigned(samplebytes(fmt));
+	// more than two channels need the extensible format; float needs the cbSize field
+	const bool extensible = numchans > 2;
+	const unsigned int fmtsize = extensible ? 40 : isfloat ? 18 : 16;
+	unsigned char header[FMT_OFFSET + 8 + 40 + 8] = {};
+	std::memcpy(header, "RIFF", 4);
+	std::memcpy(header + 8, "WAVE", 4);
+	std::memcpy(header + JUNK_OFFSET, "JUNK", 4);
+	put32(header + JUNK_OFFSET + 4, DS64_BODY);
+	unsigned char* f = header + FMT_OFFSET;
+	std::memcpy(f, "fmt ", 4);
+	put32(f + 4, fmtsize);
+	put16(f + 8, extensible ? WAVE_FORMAT_EXTENSIBLE : tag);
+	put16(f + 10, unsigned(numchans));
+	put32(f + 12, unsigned(fs + 0.5));
+	put32(f + 16, unsigned(fs + 0.5) * unsigned(numchans) * bytes);
+	put16(f + 20, unsigned(numchans) * bytes);
+	put16(f + 22, 8 * bytes);
+	if (extensible)
+	{
+		put16(f + 24, 22);
+		put16(f + 26, 8 * bytes);
+		put32(f + 28, numchans <= 18 ? (1u << numchans) - 1 : 0);
+		put16(f + 32, tag);
+		std::memcpy(f + 34, SUBTYPE_TAIL, sizeof(SUBTYPE_TAIL));
+	}
+	unsigned char* d = f + 8 + fmtsize;
+	std::memcpy(d, "data", 4);
+	datastart = (d + 8) - header;
+	return put(header, std::size_t(datastart));
+}
+
+bool WavWriter::write(const float* const* channels, int numframes)
+{
+	if (!isopen || numframes <= 0)
+		return ok;
+	const int numsamples = numframes * numchannels;
+	const std::size_t numbytes = std::size_t(numsamples) * samplebytes(format);
+	const float* src = channels[0];
+	if (numchannels > 1)
+	{
+		if (interleaved.size() < std::size_t(numsamples))
+			interleaved.resize(numsamples);
+		for (int ch = 0; ch < numchannels; ch++)
+		{
+			const float* in = channels[ch];
+			float* out = interleaved.data() + ch;
+			for (int n = 0; n < numframes; n++)
+				out[n * numchannels] = in[n];
+		}
+		src = interleaved.data();
+	}
+	this->numframes += numframes;
+	if (format == SampleFormat::FLOAT32)
+		return put(src, numbytes);
+
+	const DSPkernels& kernels = getkernels();
+	if (raw.size() < std::size_t(numsamples) * 8)
+		raw.resize(std::size_t(numsamples) * 8);
+	switch (format)
+	{
+	case SampleFormat::INT16:
+		kernels.floattoint16(src, reinterpret_cast<short*>(raw.data()), numsamples);
+		break;
+	case SampleFormat::INT24:
+	{
+		unsigned char* out = raw.data();
+		for (int n = 0; n < numsamples; n++, out += 3)
+		{
+			double x = double(src[n]) * 8388608.0;
+			x = x < -8388608.0 ? -8388608.0 : x;
+			x = x > 8388607.0 ? 8388607.0 : x;
+			const unsigned int v = static_cast<unsigned int>(int(x < 0.0 ? x - 0.5 : x + 0.5));
+			out[0] = static_cast<unsigned char>(v);
+			out[1] = static_cast<unsigned char>(v >> 8);
+			out[2] = static_cast<unsigned char>(v >> 16);
+		}
+		break;
+	}
+	case SampleFormat::INT32:
+		kernels.floattoint32(src, reinterpret_cast<int*>(raw.data()), numsamples);
+		break;
+	default:
+		kernels.floattodouble(src, reinterpret_cast<double*>(raw.data()), numsamples);
+		break;
+	}
+	return put(raw.data(), numbytes);
+}
+
+bool WavWriter::close()
+{
+	if (!isopen)
+		return false;
+	isopen = false;
+	unsigned long long datasize = position - datastart;
+	if (datasize & 1)
+	{
+		const unsigned char pad = 0;
+		put(&pad, 1);
+	}
+	const unsigned long long filesize = position;
+	unsigned char size32[4];
+	if (filesize - 8 > 0xffffffffull)
+	{
+		// RF64: the JUNK chunk becomes the ds64 chunk holding the 64 bit sizes
+		unsigned char ds64[8 + DS64_BODY] = {};
+		std::memcpy(ds64, "ds64", 4);
+		put32(ds64 + 4, DS64_BODY);
+		put64(ds64 + 8, filesize - 8);
+		put64(ds64 + 16, datasize);
+		put64(ds64 + 24, numframes);
+		patch(0, "RF64", 4);
+		put32(size32, 0xffffffff);
+		patch(RIFFSIZE_OFFSET, size32, 4);
+		patch(JUNK_OFFSET, ds64, sizeof(ds64));
+		patch(datastart - 4, size32, 4);
+	}
+	else
+	{
+		put32(size32, unsigned(filesize - 8));
+		patch(RIFFSIZE_OFFSET, size32, 4);
+		put32(size32, unsigned(datasize));
+		patch(datastart - 4, size32, 4);
+	}
+	if (mapped)
+	{
+		if (!file.resize(filesize))
+			ok = false;
+		file.close();
+	}
+	else if (!stream.close())
+		ok = false;
+	return ok;
+}
+
+bool WavWriter::put(const void* src, std::size_t numbytes)
+{
+	if (!mapped)
+	{
+		position += numbytes;
+		return ok = stream.write(src, numbytes) && ok;
+	}
+	if (position + numbytes > file.size())
+	{
+		// grow geometrically (up to 1 GB at a time), so remapping stays rare
+		unsigned long long step = file.size() < (1ull << 30) ? file.size() : (1ull << 30);
+		unsigned long long capacity = file.size() + step;
+		if (capacity < position + numbytes + MAPGROWTH)
+			capacity = position + numbytes + MAPGROWTH;
+		if (!file.resize(capacity))
+			return ok = false;
+	}
+	std::memcpy(file.data() + position, src, numbytes);
+	position += numbytes;
+	return ok;
+}
+
+bool WavWriter::patch(unsigned long long offset, const void* src, std::size_t numbytes)
+{
+	if (!mapped)
+		return ok = stream.patch(offset, src, numbytes) && ok;
+	std::memcpy(file.data() + offset, src, numbytes);
+	return ok;
+}
@@ -0,0 +1,299 @@
+/*
+  ==============================================================================
+
+    WavFile.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+/// <summary>
+/// Sample formats of WAV files
+/// </summary>
+enum class SampleFormat { INT16, INT24, INT32, FLOAT32, FLOAT64 };
+
+/// <summary>
+/// Get the size of one sample
+/// </summary>
+/// <param name="format">sample format</param>
+/// <returns>bytes per sample</returns>
+int samplebytes(SampleFormat format);
+
+/// <summary>
+/// File mapped into memory
+///
+/// Pages are read from or written to the file by the operating system as they are touched,
+/// so files much larger than physical memory can be processed.
+/// </summary>
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile() { close(); }
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	/// <summary>
+	/// Map an existing file for reading
+	/// </summary>
+	/// <param name="filename">file name</param>
+	/// <returns>true if successful</returns>
+	bool openread(const char* filename);
+
+	/// <summary>
+	/// Create (or truncate) a file and map it for writing
+	/// </summary>
+	/// <param name="filename">file name</param>
+	/// <param name="size">initial size (bytes)</param>
+	/// <returns>true if successful</returns>
+	bool opencreate(const char* filename, unsigned long long size);
+
+	/// <summary>
+	/// Change the size of a file opened with opencreate()
+	///
+	/// The file is remapped, so pointers returned by data() before the call become invalid.
+	/// </summary>
+	/// <param name="size">new size (bytes)</param>
+	/// <returns>true if successful</returns>
+	bool resize(unsigned long long size);
+
+	/// <summary>
+	/// Unmap and close the file
+	/// </summary>
+	void close();
+
+	unsigned char* data() { return base; }
+	const unsigned char* data() const { return base; }
+	unsigned long long size() const { return length; }
+
+private:
+	bool map();
+	void unmap();
+#if defined(_WIN32)
+	static void* invalidhandle() { return reinterpret_cast<void*>(-1); }
+	void* handle;
+	void* mapping;
+#else
+	static int invalidhandle() { return -1; }
+	int handle;
+#endif
+	unsigned char* base;
+	unsigned long long length;
+	bool writable;
+};
+
+/// <summary>
+/// Binary file writer with a large buffer
+///
+/// Used where a file cannot be mapped (pipes, some network file systems). Data is passed to
+/// the operating system in large writes rather than sample by sample.
+/// </summary>
+class BufferedWriter
+{
+public:
+	BufferedWriter();
+	~BufferedWriter() { close(); }
+	BufferedWriter(const BufferedWriter&) = delete;
+	BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+	/// <summary>
+	/// Create (or truncate) a file
+	/// </summary>
+	/// <param name="filename">file name</param>
+	/// <param name="buffersize">buffer size (bytes)</param>
+	/// <returns>true if successful</returns>
+	bool open(const char* filename, std::size_t buffersize = 1 << 20);
+
+	/// <summary>
+	/// Append data
+	/// </summary>
+	/// <param name="src">data</param>
+	/// <param name="numbytes">number of bytes</param>
+	/// <returns>true if successful</returns>
+	bool write(const void* src, std::size_t numbytes);
+
+	/// <summary>
+	/// Overwrite data already written (e.g. a header)
+	/// </summary>
+	/// <param name="offset">position in the file (bytes)</param>
+	/// <param name="src">data</param>
+	/// <param name="numbytes">number of bytes</param>
+	/// <returns>true if successful</returns>
+	bool patch(unsigned long long offset, const void* src, std::size_t numbytes);
+
+	/// <summary>
+	/// Write out the buffer and close the file
+	/// </summary>
+	/// <returns>true if every write succeeded</returns>
+	bool close();
+
+	/// <summary>
+	/// Get number of bytes written
+	/// </summary>
+	/// <returns>file size (bytes)</returns>
+	unsigned long long size() const { return written + fill; }
+
+private:
+	bool flush();
+
+	FILE* fp;
+	std::vector<unsigned char> buffer;
+	std::size_t fill;
+	unsigned long long written;
+	bool ok;
+};
+
+/// <summary>
+/// WAV (and RF64) file reader
+///
+/// The file is mapped into memory and samples are converted to float a block at a time, so
+/// files of any length can be streamed. PCM (16, 24 and 32 bit) and IEEE float (32 and 64 bit)
+/// files are supported, including WAVE_FORMAT_EXTENSIBLE headers.
+/// </summary>
+class WavReader
+{
+public:
+	WavReader();
+	~WavReader() {}
+
+	/// <summary>
+	/// Open a file and read its header
+	/// </summary>
+	/// <param name="filename">file name</param>
+	/// <returns>true if the file is a supported WAV or RF64 file</returns>
+	bool open(const char* filename);
+
+	/// <summary>
+	/// Close the file
+	/// </summary>
+	void close();
+
+	int getnumchannels() const { return numchannels; }
+	double getsamplerate() const { return sampRate; }
+	SampleFormat getformat() const { return format; }
+	unsigned long long getnumframes() const { return numframes; }
+	unsigned long long getposition() const { return position; }
+
+	/// <summary>
+	/// Move the read position
+	/// </summary>
+	/// <param name="frame">frame number (clipped to the length of the file)</param>
+	void seek(unsigned long long frame) { position = frame < numframes ? frame : numframes; }
+
+	/// <summary>
+	/// Read a block of frames
+	/// </summary>
+	/// <param name="channels">array of getnumchannels() pointers to output samples</param>
+	/// <param name="maxframes">number of frames wanted</param>
+	/// <returns>number of frames read (less than maxframes at the end of the file)</returns>
+	int read(float* const* channels, int maxframes);
+
+private:
+	MappedFile file;
+	const unsigned char* samples;
+	int numchannels;
+	double sampRate;
+	SampleFormat format;
+	unsigned long long numframes;
+	unsigned long long position;
+	std::vector<unsigned char> raw;
+	std::vector<float> interleaved;
+};
+
+/// <summary>
+/// WAV (and RF64) file writer
+///
+/// Samples are converted from float a block at a time and written through a memory map that
+/// grows as needed, or through a BufferedWriter. Space for an RF64 header is reserved, so a
+/// file that grows past 4 GB is finished as RF64; smaller files are plain WAV files.
+/// </summary>
+class WavWriter
+{
+public:
+	WavWriter();
+	~WavWriter() { close(); }
+
+	/// <summary>
+	/// Create a file and write its header
+	/// </summary>
+	/// <param name="filename">file name</param>
+	/// <param name="numchans">number of channels</param>
+	/// <param name="fs">sampling frequency (Hz)</param>
+	/// <param name="fmt">sample format</param>
+	/// <param name="usemap">true to write through a memory map, false to use a BufferedWriter</param>
+	/// <returns>true if successful</returns>
+	bool open(const char* filename, int numchans, double fs, SampleFormat fmt = SampleFormat::FLOAT32,
+		bool usemap = true);
+
+	/// <summary>
+	/// Write a block of frames
+	///
+	/// Integer formats are rounded to nearest and clipped.
+	/// </summary>
+	/// <param name="channels">array of numchans pointers to samples</param>
+	/// <param name="numframes">number of frames</param>
+	/// <returns>true if successful</returns>
+	bool write(const float* const* channels, int numframes);
+
+	/// <summary>
+	/// Complete the header and close the file
+	/// </summary>
+	/// <returns>true if the file was written successfully</returns>
+	bool close();
+
+	unsigned long long getnumframes() const { return numframes; }
+
+private:
+	bool put(const void* src, std::size_t numbytes);
+	bool patch(unsigned long long offset, const void* src, std::size_t numbytes);
+
+	MappedFile file;
+	BufferedWriter stream;
+	bool mapped;
+	bool isopen;
+	bool ok;
+	int numchannels;
+	SampleFormat format;
+	unsigned long long datastart;
+	unsigned long long position;
+	unsigned long long numframes;
+	std::vector<float> interleaved;
+	std::vector<unsigned char> raw;
+};
+
+/// <summary>
+/// Stream a file through a processing chain
+///
+/// Blocks of blocksize frames are read, passed to chain(channels, numframes), and written,
+/// so only one block is held in memory. chain may be any callable taking (float* const*, int)
+/// and processing the block in place, e.g. a lambda calling procblock() on a set of filters.
+/// </summary>
+/// <param name="in">open reader</param>
+/// <param name="out">open writer with the same number of channels</param>
+/// <param name="chain">processing chain</param>
+/// <param name="blocksize">frames per block</param>
+/// <returns>number of frames rendered</returns>
+template <typename Chain>
+unsigned long long renderfile(WavReader& in, WavWriter& out, Chain&& chain, int blocksize = 4096)
+{
+	const int numchannels = in.getnumchannels();
+	std::vector<float> block(std::size_t(numchannels) * blocksize);
+	std::vector<float*> channels(numchannels);
+	for (int ch = 0; ch < numchannels; ch++)
+		channels[ch] = block.data() + std::size_t(ch) * blocksize;
+	unsigned long long total = 0;
+	int numframes;
+	while ((numframes = in.read(channels.data(), blocksize)) > 0)
+	{
+		chain(channels.data(), numframes);
+		if (!out.write(channels.data(), numframes))
+			break;
+		total += numframes;
+	}
+	return total;
+}
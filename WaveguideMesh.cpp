@@ -0,0 +1,167 @@
+/*
+  ==============================================================================
+
+    WaveguideMesh.cpp
+
+  ==============================================================================
+*/
+
+#include "WaveguideMesh.h"
+#include "DSPkernels.h"
+#include <algorithm>
+#include <cmath>
+
+// Bytes of mesh state a band of rows may touch, to stay within a typical L2 cache
+constexpr int MESHBANDBYTES = 512 * 1024;
+
+WaveguideMesh::WaveguideMesh()
+{
+	init(2, 2);
+}
+
+bool WaveguideMesh::init(int nx, int ny, int nz)
+{
+	if (nx < 2 || ny < 2 || nz < 1)
+		return false;
+	this->nx = nx;
+	this->ny = ny;
+	this->nz = nz;
+	numaxes = nz > 1 ? 3 : 2;
+	numjunct = nx * ny * nz;
+	for (auto& buffer : waves)
+		for (int d = 0; d < 6; d++)
+			buffer[d].assign(d < 2 * numaxes ? numjunct : 0, 0.0);
+	current = 0;
+	pressure.assign(numjunct, 0.0);
+	for (int axis = 0; axis < 3; axis++)
+		damping[axis].assign(axis < numaxes ? numjunct : 0, 0.0);
+	setreflection(1.0);
+	sources.clear();
+	taps.clear();
+
+	// a row is touched in both wave buffers, the pressures and the dampings; a 3D band works
+	// on three planes at once
+	const int rowbytes = nx * int(sizeof(double)) * (4 * numaxes + 1 + numaxes);
+	bandrows = std::max(1, std::min(ny, MESHBANDBYTES / (rowbytes * (numaxes == 3 ? 3 : 1))));
+	return true;
+}
+
+int WaveguideMesh::junctionsfor(double length, double fs, int dimensions, double speed)
+{
+	const double spacing = speed * std::sqrt(double(dimensions)) / fs;
+	return std::max(2, int(std::lround(length / spacing)) + 1);
+}
+
+void WaveguideMesh::setreflection(double G)
+{
+	for (auto& g : Gamma)
+		g = G;
+}
+
+void WaveguideMesh::setdamping(double damp)
+{
+	for (int axis = 0; axis < numaxes; axis++)
+		std::fill(damping[axis].begin(), damping[axis].end(), damp);
+}
+
+unsigned int WaveguideMesh::addsource(int x, int y, int z)
+{
+	sources.push_back(MeshPoint{ z * ny + y, x });
+	return unsigned(sources.size() - 1);
+}
+
+unsigned int WaveguideMesh::addtap(int x, int y, int z)
+{
+	taps.push_back(MeshPoint{ z * ny + y, x });
+	return unsigned(taps.size() - 1);
+}
+
+void WaveguideMesh::procblock(int numsamples, const float* const* insamples, float* const* outsamples)
+{
+	for (int n = 0; n < numsamples; n++)
+		step(insamples, outsamples, n);
+}
+
+void WaveguideMesh::reset()
+{
+	for (auto& buffer : waves)
+		for (auto& wave : buffer)
+			std::fill(wave.begin(), wave.end(), 0.0);
+	std::fill(pressure.begin(), pressure.end(), 0.0);
+}
+
+void WaveguideMesh::step(const float* const* insamples, float* const* outsamples, int n)
+{
+	// Each band also computes the pressures of the rows either side of it, which its edge rows
+	// need; the neighbouring band computes the same values again
+	for (int y0 = 0; y0 < ny; y0 += bandrows)
+	{
+		const int y1 = std::min(ny, y0 + bandrows);
+		const int p0 = std::max(0, y0 - 1);
+		const int p1 = std::min(ny, y1 + 1);
+		computepressure(0, p0, p1, insamples, n);
+		for (int z = 0; z < nz; z++)
+		{
+			if (z + 1 < nz)
+				computepressure(z + 1, p0, p1, insamples, n);
+			updatewaves(z, y0, y1);
+		}
+	}
+	for (unsigned int k = 0; k < taps.size(); k++)
+		outsamples[k][n] = float(pressure[taps[k].row * nx + taps[k].x]);
+	current = 1 - current;
+}
+
+void WaveguideMesh::computepressure(int z, int yfirst, int yend, const float* const* insamples, int n)
+{
+	const DSPkernels& kernels = getkernels();
+	const int numwaves = 2 * numaxes;
+	const int first = index(0, yfirst, z);
+	const int len = (yend - yfirst) * nx;
+	const double* in[6];
+	for (int d = 0; d < numwaves; d++)
+		in[d] = waves[current][d].data() + first;
+	kernels.meshpressure(in, numwaves, pressure.data() + first, len);
+	const int rowfirst = z * ny + yfirst;
+	const int rowend = z * ny + yend;
+	for (unsigned int k = 0; k < sources.size(); k++)
+		if (sources[k].row >= rowfirst && sources[k].row < rowend)
+			pressure[sources[k].row * nx + sources[k].x] += insamples[k][n];
+}
+
+void WaveguideMesh::updatewaves(int z, int yfirst, int yend)
+{
+	const DSPkernels& kernels = getkernels();
+	const std::vector<double>* prev = waves[current];
+	std::vector<double>* next = waves[1 - current];
+	const double* P = pressure.data();
+	const int strides[3] = { 1, nx, nx * ny };
+	for (int y = yfirst; y < yend; y++)
+	{
+		const int b = index(0, y, z);
+		// x: the ends of the row are on the west and east faces
+		kernels.meshwave(&next[0][b + 1], &prev[0][b + 1], P + b, &prev[1][b], &damping[0][b], nx - 1);
+		kernels.meshwave(&next[1][b], &prev[1][b], P + b + 1, &prev[0][b + 1], &damping[0][b], nx - 1);
+		next[0][b] = Gamma[0] * (P[b] - prev[0][b]);
+		next[1][b + nx - 1] = Gamma[1] * (P[b + nx - 1] - prev[1][b + nx - 1]);
+		// y and z: whole rows, unless the row is on a face
+		const int coord[3] = { 0, y, z };
+		const int size[3] = { nx, ny, nz };
+		for (int axis = 1; axis < numaxes; axis++)
+		{
+			const int lo = 2 * axis;
+			const int hi = lo + 1;
+			const int s = strides[axis];
+			if (coord[axis] > 0)
+				kernels.meshwave(&next[lo][b], &prev[lo][b], P + b - s, &prev[hi][b - s], &damping[axis][b - s], nx);
+			else
+				for (int x = b; x < b + nx; x++)
+					next[lo][x] = Gamma[lo] * (P[x] - prev[lo][x]);
+			if (coord[axis] < size[axis] - 1)
+				kernels.meshwave(&next[hi][b], &prev[hi][b], P + b + s, &prev[lo][b + s], &damping[axis][b], nx);
+			else
+				for (int x = b; x < b + nx; x++)
+					next[hi][x] = Gamma[hi] * (P[x] - prev[hi][x]);
+		}
+	}
+}
@@ -0,0 +1,183 @@
+/*
+  ==============================================================================
+
+    WaveguideMesh.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <vector>
+
+// Boundary faces of a WaveguideMesh: the low and high end of each axis
+enum class MeshFace
+{
+	WEST,		// x = 0
+	EAST,		// x = nx - 1
+	SOUTH,		// y = 0
+	NORTH,		// y = ny - 1
+	FLOOR,		// z = 0
+	CEILING		// z = nz - 1
+};
+
+/// <summary>
+/// Rectilinear 2D or 3D digital waveguide mesh
+///
+/// Every junction of an nx by ny (by nz) grid is joined to each of its four (six) neighbours
+/// by a waveguide of one sample, with the one pole loss of Waveguide, and scatters the waves
+/// arriving at it as a Junction does. The outward ports of the junctions on each face of the
+/// grid are terminated by a Reflector with the far side grounded, so a wave leaving the mesh
+/// comes back scaled by the reflection coefficient of that face one sample later. Sources add
+/// to the pressure of a junction, 2 * (sum of the arriving waves) / number of ports, and taps
+/// read it.
+///
+/// Built from MPnetwork elements, a room sized mesh would take millions of junctions linked by
+/// shared pointers. Here the waves arriving from each direction are held in one dense array
+/// per direction, and a step is a stencil over those arrays: the pressure of a row of
+/// junctions, then the new arriving waves of a row from the pressures and waves of the
+/// neighbouring rows, in the DSPkernels::meshpressure and DSPkernels::meshwave kernels. The
+/// grid is swept in bands of rows small enough for the rows in use to stay in the cache, and in
+/// a 3D mesh each band is swept plane by plane, computing the pressures of a plane just before
+/// the waves of the plane below need them.
+///
+/// Along an axis a rectilinear mesh carries sound at 1 / sqrt(dimensions) junction spacings
+/// per sample, so for a speed of sound c and sampling frequency fs the spacing is
+/// c * sqrt(dimensions) / fs; see junctionsfor().
+/// </summary>
+class WaveguideMesh
+{
+public:
+	WaveguideMesh();
+	~WaveguideMesh() {}
+
+	/// <summary>
+	/// Build the mesh
+	///
+	/// Waveguides start lossless and faces fully reflecting (coefficient 1); sources and taps
+	/// are removed and the mesh is silent.
+	/// </summary>
+	/// <param name="nx">number of junctions along x (at least 2)</param>
+	/// <param name="ny">number of junctions along y (at least 2)</param>
+	/// <param name="nz">number of junctions along z (1 for a 2D mesh)</param>
+	/// <returns>false if a dimension is too small</returns>
+	bool init(int nx, int ny, int nz = 1);
+
+	/// <summary>
+	/// Get the number of junctions needed to span a length
+	/// </summary>
+	/// <param name="length">length (m)</param>
+	/// <param name="fs">sampling frequency (Hz)</param>
+	/// <param name="dimensions">2 or 3</param>
+	/// <param name="speed">speed of sound (m/s)</param>
+	/// <returns>number of junctions</returns>
+	static int junctionsfor(double length, double fs, int dimensions, double speed = 343.0);
+
+	/// <summary>
+	/// Get number of dimensions
+	/// </summary>
+	/// <returns>2 or 3</returns>
+	int getdimensions() const { return numaxes; }
+
+	/// <summary>
+	/// Get number of junctions
+	/// </summary>
+	/// <returns>nx * ny * nz</returns>
+	int getnumjunctions() const { return numjunct; }
+
+	/// <summary>
+	/// Set reflection coefficient of every face
+	/// </summary>
+	/// <param name="G">reflection coefficient</param>
+	void setreflection(double G);
+
+	/// <summary>
+	/// Set reflection coefficient of one face
+	/// </summary>
+	/// <param name="face">face</param>
+	/// <param name="G">reflection coefficient</param>
+	void setreflection(MeshFace face, double G) { Gamma[int(face)] = G; }
+
+	/// <summary>
+	/// Set damping of every waveguide
+	/// </summary>
+	/// <param name="damp">damping factor</param>
+	void setdamping(double damp);
+
+	/// <summary>
+	/// Set damping of one waveguide
+	/// </summary>
+	/// <param name="axis">axis of the waveguide (0 for x, 1 for y, 2 for z)</param>
+	/// <param name="x">x of the junction at the low end of the waveguide</param>
+	/// <param name="y">y of the junction at the low end of the waveguide</param>
+	/// <param name="z">z of the junction at the low end of the waveguide</param>
+	/// <param name="damp">damping factor</param>
+	void setdamping(int axis, int x, int y, int z, double damp) { damping[axis][index(x, y, z)] = damp; }
+
+	/// <summary>
+	/// Add an external input at a junction
+	/// </summary>
+	/// <param name="x">x of the junction</param>
+	/// <param name="y">y of the junction</param>
+	/// <param name="z">z of the junction</param>
+	/// <returns>source number</returns>
+	unsigned int addsource(int x, int y, int z = 0);
+
+	/// <summary>
+	/// Add an output tap at a junction
+	/// </summary>
+	/// <param name="x">x of the junction</param>
+	/// <param name="y">y of the junction</param>
+	/// <param name="z">z of the junction</param>
+	/// <returns>tap number</returns>
+	unsigned int addtap(int x, int y, int z = 0);
+
+	/// <summary>
+	/// Step the mesh through a block of samples
+	/// </summary>
+	/// <param name="numsamples">number of samples in the block</param>
+	/// <param name="insamples">array of pointers to samples for each source</param>
+	/// <param name="outsamples">array of pointers to samples for each tap (the junction pressure)</param>
+	void procblock(int numsamples, const float* const* insamples, float* const* outsamples);
+
+	/// <summary>
+	/// Get the pressure of a junction in the last step
+	/// </summary>
+	/// <param name="x">x of the junction</param>
+	/// <param name="y">y of the junction</param>
+	/// <param name="z">z of the junction</param>
+	/// <returns>pressure</returns>
+	double getpressure(int x, int y, int z = 0) const { return pressure[index(x, y, z)]; }
+
+	/// <summary>
+	/// Silence the mesh
+	/// </summary>
+	void reset();
+
+private:
+	struct MeshPoint
+	{
+		int row; // z * ny + y
+		int x;
+	};
+
+	int index(int x, int y, int z) const { return (z * ny + y) * nx + x; }
+	void step(const float* const* insamples, float* const* outsamples, int n);
+	void computepressure(int z, int yfirst, int yend, const float* const* insamples, int n);
+	void updatewaves(int z, int yfirst, int yend);
+
+	int nx, ny, nz;
+	int numaxes;
+	int numjunct;
+	int bandrows; // rows per band of a sweep
+	double Gamma[6];
+	// waves arriving at each junction from the low (2 * axis) and high (2 * axis + 1) side of
+	// each axis, for the last step and the next
+	std::vector<double> waves[2][6];
+	int current;
+	std::vector<double> pressure;
+	// damping of the waveguide from each junction to its neighbour on the high side of each axis
+	std::vector<double> damping[3];
+	std::vector<MeshPoint> sources;
+	std::vector<MeshPoint> taps;
+};
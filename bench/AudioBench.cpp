@@ -0,0 +1,681 @@
+/*
+  ==============================================================================
+
+    AudioBench.cpp
+
+    Throughput benchmarks for every DSP class, reported in ns/sample and
+    samples/s. Delay lengths, section counts, channel counts and network sizes
+    are swept, and the results can be written as CSV or JSON for comparison
+    across releases. Only the standard library is used. Build together with
+    the library sources, e.g.
+    g++ -O2 -pthread -I.. AudioBench.cpp ../BQfilter.cpp ../BQdesign.cpp ...
+
+    Usage: AudioBench [--csv file] [--json file] [--filter text] [--time seconds]
+
+    The instruction set of the DSP kernels can be lowered with the
+    AUDIOCLASSES_ISA environment variable (scalar, sse2, avx2 or avx512), so
+    every path can be measured on the same machine.
+
+  ==============================================================================
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BQdesign.h"
+#include "BQfilter.h"
+#include "BQfilterBank.h"
+#include "Convolver.h"
+#include "FDNreverb.h"
+#include "CPUfeatures.h"
+#include "DelayLine.h"
+#include "DenormalContext.h"
+#include "FixedSOSfilter.h"
+#include "FreqGrid.h"
+#include "LPAPfilter.h"
+#include "LPcombBank.h"
+#include "LPcombfilter.h"
+#include "MultiPort.h"
+#include "OversampledSSfilter.h"
+#include "Resampler.h"
+#include "SIMDlanes.h"
+#include "SOSfilter.h"
+#include "SSfilter.h"
+#include "SSfilterBank.h"
+#include "WaveguideMesh.h"
+#include "BenchCommon.h"
+
+
+/// <summary>
+/// One benchmark measurement
+/// </summary>
+struct BenchResult
+{
+	std::string name; // class or function
+	std::string method; // how it was driven (step, procblock, ...)
+	std::string param; // swept parameter, e.g. "delay=4096"
+	std::string unit; // what one "sample" is
+	double nspersample;
+	double samplespersec;
+};
+
+/// <summary>
+/// Runs benchmarks and collects their results
+/// </summary>
+class BenchRunner
+{
+public:
+	BenchRunner(double seconds, const std::string& filt) : mintime(seconds), filter(filt) {}
+
+	/// <summary>
+	/// Time a processing function
+	///
+	/// The function is called repeatedly until the minimum time has passed, and the fastest
+	/// of NUMTRIALS such runs is reported.
+	/// </summary>
+	/// <param name="name">class or function name</param>
+	/// <param name="method">method benchmarked</param>
+	/// <param name="param">swept parameter ("" if none)</param>
+	/// <param name="unit">what is counted as one sample</param>
+	/// <param name="samplespercall">samples processed by each call of proc</param>
+	/// <param name="proc">function to time</param>
+	template <typename Proc>
+	void run(const std::string& name, const std::string& method, const std::string& param, const std::string& unit,
+		double samplespercall, Proc proc)
+	{
+		std::string label = name + " " + method + " " + param;
+		if (!filter.empty() && label.find(filter) == std::string::npos)
+			return;
+		double best = measurerate(proc, samplespercall, mintime);
+		BenchResult res{ name, method, param, unit, 1e9 / best, best };
+		printf("%-16s %-12s %-16s %10.2f ns/%-8s %10.2f M/s\n", name.c_str(), method.c_str(), param.c_str(),
+			res.nspersample, unit.c_str(), best * 1e-6);
+		fflush(stdout);
+		results.push_back(res);
+	}
+
+	/// <summary>
+	/// Write results as comma separated values
+	/// </summary>
+	/// <param name="filename">output file</param>
+	/// <returns>true if the file was written</returns>
+	bool writecsv(const char* filename)
+	{
+		FILE* fp = fopen(filename, "w");
+		if (!fp)
+			return false;
+		fprintf(fp, "name,method,param,unit,ns_per_sample,samples_per_sec\n");
+		for (auto& res : results)
+			fprintf(fp, "%s,%s,%s,%s,%.4f,%.1f\n", res.name.c_str(), res.method.c_str(), res.param.c_str(),
+				res.unit.c_str(), res.nspersample, res.samplespersec);
+		fclose(fp);
+		return true;
+	}
+
+	/// <summary>
+	/// Write results as JSON
+	/// </summary>
+	/// <param name="filename">output file</param>
+	/// <returns>true if the file was written</returns>
+	bool writejson(const char* filename)
+	{
+		FILE* fp = fopen(filename, "w");
+		if (!fp)
+			return false;
+		fprintf(fp, "{\n  \"blocksize\": %d,\n  \"simdlanes\": %d,\n  \"isa\": \"%s\",\n  \"threads\": %u,\n",
+			BLOCKSIZE, VECLANES, isaname(getisa()), std::thread::hardware_concurrency());
+#ifdef __VERSION__
+		fprintf(fp, "  \"compiler\": \"%s\",\n", __VERSION__);
+#endif
+		fprintf(fp, "  \"results\": [\n");
+		for (unsigned int k = 0; k < results.size(); k++)
+		{
+			auto& res = results[k];
+			fprintf(fp, "    {\"name\": \"%s\", \"method\": \"%s\", \"param\": \"%s\", \"unit\": \"%s\", "
+				"\"ns_per_sample\": %.4f, \"samples_per_sec\": %.1f}%s\n", res.name.c_str(), res.method.c_str(),
+				res.param.c_str(), res.unit.c_str(), res.nspersample, res.samplespersec,
+				k + 1 < results.size() ? "," : "");
+		}
+		fprintf(fp, "  ]\n}\n");
+		fclose(fp);
+		return true;
+	}
+
+private:
+	double mintime;
+	std::string filter;
+	std::vector<BenchResult> results;
+};
+
+static std::string param(const char* name, long value)
+{
+	return std::string(name) + "=" + std::to_string(value);
+}
+
+/// <summary>
+/// Benchmark step() and procblock() of a single channel filter
+/// </summary>
+template <typename Filter>
+void stepandblock(BenchRunner& bench, const char* name, const std::string& prm, Filter& filt)
+{
+	bench.run(name, "step", prm, "sample", BLOCKSIZE, [&]() {
+		for (int n = 0; n < BLOCKSIZE; n++)
+			output[n] = float(filt.step(input[n]));
+		sink = output[BLOCKSIZE - 1];
+	});
+	bench.run(name, "procblock", prm, "sample", BLOCKSIZE, [&]() {
+		filt.procblock(input.data(), output.data(), BLOCKSIZE);
+		sink = output[BLOCKSIZE - 1];
+	});
+}
+
+/// <summary>
+/// Benchmark procblock() of a feedback structure on the end of a decaying tail, without
+/// protection against subnormal numbers, flushing them to zero, and injecting noise
+/// </summary>
+template <typename Filter, typename T>
+void decaytail(BenchRunner& bench, const char* name, const std::string& prm, Filter& filt, const std::vector<T>& tail)
+{
+	std::vector<T> block(BLOCKSIZE);
+	bench.run(name, "tail", prm, "sample", BLOCKSIZE, [&]() {
+		std::copy(tail.begin(), tail.end(), block.begin());
+		filt.procblock(block.data(), BLOCKSIZE);
+		sink = block[BLOCKSIZE - 1];
+	});
+	if (DenormalContext::canflush())
+		bench.run(name, "tail-flush", prm, "sample", BLOCKSIZE, [&]() {
+			DenormalContext context(DenormalMode::FLUSH);
+			std::copy(tail.begin(), tail.end(), block.begin());
+			filt.procblock(block.data(), BLOCKSIZE);
+			sink = block[BLOCKSIZE - 1];
+		});
+	bench.run(name, "tail-inject", prm, "sample", BLOCKSIZE, [&]() {
+		DenormalContext context(DenormalMode::INJECT);
+		std::copy(tail.begin(), tail.end(), block.begin());
+		context.inject(block.data(), BLOCKSIZE);
+		filt.procblock(block.data(), BLOCKSIZE);
+		sink = block[BLOCKSIZE - 1];
+	});
+}
+
+/// <summary>
+/// Waveguide driven through step(), so its double precision state sees double precision input
+/// </summary>
+struct WaveguideTail
+{
+	Waveguide wg;
+	std::shared_ptr<double> src0 = std::make_shared<double>(0.0);
+	std::shared_ptr<double> src1 = std::make_shared<double>(0.0);
+
+	void procblock(double* samples, int numsamples)
+	{
+		for (int n = 0; n < numsamples; n++)
+		{
+			*src0 = samples[n];
+			*src1 = samples[numsamples - 1 - n];
+			wg.step();
+			samples[n] = *wg.getOutputPtr(0);
+		}
+	}
+};
+
+static void setsections(FilterType* type, double* gain, double* f0, int numsects)
+{
+	for (int k = 0; k < numsects; k++)
+	{
+		type[k] = k == 0 ? FilterType::BASS : k == numsects - 1 ? FilterType::TREBLE : FilterType::PEAK;
+		gain[k] = k % 2 ? -3.0 : 4.0;
+		f0[k] = 50.0 * std::pow(2.0, 8.0 * (k + 0.5) / numsects);
+	}
+}
+
+template <int N>
+void fixedsos(BenchRunner& bench)
+{
+	FilterType type[N];
+	double gain[N], f0[N];
+	setsections(type, gain, f0, N);
+	FixedSOSfilter<N> filt;
+	filt.initsos(N, 48000.0);
+	for (int k = 0; k < N; k++)
+		filt.updateSection(k, type[k], gain[k], f0[k], 1.0);
+	stepandblock(bench, "FixedSOSfilter", param("sections", N), filt);
+}
+
+/// <summary>
+/// Build a square mesh of 4-port junctions joined by waveguides, grounded at the edges
+/// </summary>
+static void buildmesh(MPnetwork& net, int size, unsigned int mindelay, std::shared_ptr<double> src)
+{
+	net.addJunctions(size * size);
+	net.addWaveguides(2 * size * (size - 1));
+	for (int j = 0; j < size * size; j++)
+		net.setNumPorts(j, 4);
+	int wg = 0;
+	// ports are 0 north, 1 east, 2 south, 3 west
+	for (int row = 0; row < size; row++)
+		for (int col = 0; col < size; col++)
+		{
+			int j = row * size + col;
+			if (col + 1 < size)
+			{
+				net.setWGparams(wg, mindelay + (j * 13) % 29, 0.1);
+				net.connect(wg++, j, 1, j + 1, 3);
+			}
+			if (row + 1 < size)
+			{
+				net.setWGparams(wg, mindelay + (j * 7) % 31, 0.2);
+				net.connect(wg++, j, 2, j + size, 0);
+			}
+			if (row == 0 && col > 0)
+				net.addground(j, 0);
+			if (row == size - 1)
+				net.addground(j, 2);
+			if (col == 0)
+				net.addground(j, 3);
+			if (col == size - 1)
+				net.addground(j, 1);
+		}
+	net.addsource(0, 0, src);
+	net.addtap(size * size - 1, 1);
+}
+
+int main(int argc, char* argv[])
+{
+	const char* csvfile = nullptr;
+	const char* jsonfile = nullptr;
+	std::string filter;
+	double seconds = 0.5;
+	for (int k = 1; k < argc; k++)
+	{
+		if (!std::strcmp(argv[k], "--csv") && k + 1 < argc)
+			csvfile = argv[++k];
+		else if (!std::strcmp(argv[k], "--json") && k + 1 < argc)
+			jsonfile = argv[++k];
+		else if (!std::strcmp(argv[k], "--filter") && k + 1 < argc)
+			filter = argv[++k];
+		else if (!std::strcmp(argv[k], "--time") && k + 1 < argc)
+			seconds = std::atof(argv[++k]);
+		else
+		{
+			printf("usage: %s [--csv file] [--json file] [--filter text] [--time seconds]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	printf("instruction set: %s (detected %s)\n", isaname(getisa()), isaname(detectisa()));
+	printf("flush to zero: %s\n", DenormalContext::canflush() ? "available" : "not available");
+	fillinput();
+	BenchRunner bench(seconds, filter);
+
+	// Biquad design and filtering
+	bench.run("designbq", "design", "", "design", 1, [&]() {
+		double b[3], a[3];
+		designbq(FilterType::PEAK, 6.0, 1000.0 + sink * 1e-9, 2.0, 48000.0, b, a);
+		sink = b[0];
+	});
+	BQfilter bq;
+	bq.update(FilterType::PEAK, 6.0, 1000.0, 2.0, 48000.0);
+	stepandblock(bench, "BQfilter", "", bq);
+	BQfilterT<float> bqf;
+	bqf.update(FilterType::PEAK, 6.0, 1000.0, 2.0, 48000.0);
+	stepandblock(bench, "BQfilter", "precision=float", bqf);
+
+	// Cascades: section count sweep
+	for (int numsects : { 1, 2, 4, 8, 16 })
+	{
+		std::vector<FilterType> type(numsects);
+		std::vector<double> gain(numsects), f0(numsects);
+		setsections(type.data(), gain.data(), f0.data(), numsects);
+		SOSfilter sos;
+		sos.initsos(numsects, 48000.0);
+		for (int k = 0; k < numsects; k++)
+			sos.updateSection(k, type[k], gain[k], f0[k], 1.0);
+		stepandblock(bench, "SOSfilter", param("sections", numsects), sos);
+		SOSfilter parsos;
+		parsos.initsos(numsects, 48000.0);
+		for (int k = 0; k < numsects; k++)
+			parsos.updateSection(k, type[k], gain[k], f0[k], 1.0);
+		if (parsos.setparallel(true))
+			stepandblock(bench, "SOSfilter", param("sections", numsects) + " parallel", parsos);
+
+		FreqGrid grid;
+		grid.setloggrid(20.0, 20000.0, 512, 48000.0);
+		std::vector<double> magdB(512);
+		bench.run("FreqGrid", "cascaderesp", param("sections", numsects), "freq", 512, [&]() {
+			sos.freqResponse(grid, magdB.data());
+			sink = magdB[511];
+		});
+	}
+	fixedsos<2>(bench);
+	fixedsos<4>(bench);
+	fixedsos<8>(bench);
+
+	// Multichannel: channel count sweep, separate filters versus the bank
+	for (int numchans : { 1, 2, 4, 8, 16, 32, 64, 128 })
+	{
+		std::vector<std::vector<float>> chanbufs(numchans, input);
+		std::vector<float*> chanptrs;
+		for (auto& buf : chanbufs)
+			chanptrs.push_back(buf.data());
+		std::vector<BQfilter> chanfilts(numchans);
+		BQfilterBank bank;
+		bank.setnumchannels(numchans);
+		for (int ch = 0; ch < numchans; ch++)
+		{
+			chanfilts[ch].update(FilterType::PEAK, 6.0, 1000.0 + 10.0 * ch, 2.0, 48000.0);
+			bank.update(ch, FilterType::PEAK, 6.0, 1000.0 + 10.0 * ch, 2.0, 48000.0);
+		}
+		bench.run("BQfilter", "channels", param("channels", numchans), "ch-sample", double(numchans) * BLOCKSIZE, [&]() {
+			for (int ch = 0; ch < numchans; ch++)
+				chanfilts[ch].procblock(chanptrs[ch], BLOCKSIZE);
+			sink = chanptrs[0][0];
+		});
+		bench.run("BQfilterBank", "procblock", param("channels", numchans), "ch-sample", double(numchans) * BLOCKSIZE, [&]() {
+			bank.procblock(chanptrs.data(), BLOCKSIZE);
+			sink = chanptrs[0][0];
+		});
+	}
+
+	// Delay based classes: delay length sweep
+	for (int delay : { 16, 256, 4096, 65536, 1048576 })
+	{
+		DelayLine dl;
+		dl.setsampledelay(delay);
+		dl.setdamping(0.3);
+		stepandblock(bench, "DelayLine", param("delay", delay), dl);
+
+		DelayLineT<float> dlf;
+		dlf.setsampledelay(delay);
+		dlf.setdamping(0.3);
+		stepandblock(bench, "DelayLine", param("delay", delay) + ",precision=float", dlf);
+
+		LPcombfilter comb;
+		comb.setdelay(delay);
+		comb.setdamping(0.3);
+		comb.setreflection(0.8);
+		stepandblock(bench, "LPcombfilter", param("delay", delay), comb);
+
+		LPAPfilter ap;
+		ap.setdelay(delay);
+		ap.setdamping(0.3);
+		ap.setreflection(0.5);
+		stepandblock(bench, "LPAPfilter", param("delay", delay), ap);
+
+		Waveguide wg;
+		auto src0 = std::make_shared<double>(0.0);
+		auto src1 = std::make_shared<double>(0.0);
+		wg.setDelay(delay);
+		wg.setDamping(0.3);
+		wg.setInputPtr(0, src0);
+		wg.setInputPtr(1, src1);
+		bench.run("Waveguide", "step", param("delay", delay), "sample", BLOCKSIZE, [&]() {
+			for (int n = 0; n < BLOCKSIZE; n++)
+			{
+				*src0 = input[n];
+				*src1 = input[BLOCKSIZE - 1 - n];
+				wg.step();
+				output[n] = float(*wg.getOutputPtr(0));
+				output2[n] = float(*wg.getOutputPtr(1));
+			}
+			sink = output[BLOCKSIZE - 1];
+		});
+		bench.run("Waveguide", "procblock", param("delay", delay), "sample", BLOCKSIZE, [&]() {
+			wg.procblock(input.data(), input.data(), output.data(), output2.data(), BLOCKSIZE);
+			sink = output[BLOCKSIZE - 1];
+		});
+	}
+
+	// Parallel combs with a common input (Freeverb delays): separate filters versus the bank
+	{
+		const int freeverb[8] = { 1557, 1617, 1491, 1422, 1277, 1356, 1188, 1116 };
+		std::vector<LPcombfilter> combs(8);
+		LPcombBank combbank;
+		combbank.setnumcombs(8);
+		for (int k = 0; k < 8; k++)
+		{
+			combs[k].setdelay(freeverb[k]);
+			combs[k].setdamping(0.2);
+			combs[k].setreflection(0.84);
+			combbank.setdelay(k, freeverb[k]);
+			combbank.setdamping(k, 0.2);
+			combbank.setreflection(k, 0.84);
+		}
+		bench.run("LPcombfilter", "parallel", param("combs", 8), "sample", BLOCKSIZE, [&]() {
+			for (int n = 0; n < BLOCKSIZE; n++)
+			{
+				double sum = 0.0;
+				for (auto& comb : combs)
+					sum += comb.step(input[n]);
+				output[n] = float(sum);
+			}
+			sink = output[BLOCKSIZE - 1];
+		});
+		stepandblock(bench, "LPcombBank", param("combs", 8), combbank);
+	}
+
+	// Decaying tails: the input is scaled into the subnormal range of the state of each
+	// structure (float for the comb and allpass filters, double for the others), where the
+	// state stays for the long end of a tail after the input falls silent
+	std::vector<float> tailf(BLOCKSIZE);
+	std::vector<double> taild(BLOCKSIZE);
+	for (int n = 0; n < BLOCKSIZE; n++)
+	{
+		tailf[n] = input[n] * 1e-40f;
+		taild[n] = input[n] * 1e-310;
+	}
+	{
+		const std::string prm = param("delay", 256);
+		LPcombfilter comb;
+		comb.setdelay(256);
+		comb.setdamping(0.3);
+		comb.setreflection(0.8);
+		decaytail(bench, "LPcombfilter", prm, comb, tailf);
+		LPAPfilter ap;
+		ap.setdelay(256);
+		ap.setdamping(0.3);
+		ap.setreflection(0.5);
+		decaytail(bench, "LPAPfilter", prm, ap, tailf);
+		DelayLine dl;
+		dl.setsampledelay(256);
+		dl.setdamping(0.3);
+		decaytail(bench, "DelayLine", prm, dl, taild);
+		WaveguideTail wgt;
+		wgt.wg.setDelay(256);
+		wgt.wg.setDamping(0.3);
+		wgt.wg.setInputPtr(0, wgt.src0);
+		wgt.wg.setInputPtr(1, wgt.src1);
+		decaytail(bench, "Waveguide", prm, wgt, taild);
+	}
+
+	// Reverb: number of delay lines
+	for (int numlines : { 8, 16 })
+	{
+		FDNreverb fdn;
+		fdn.init(numlines);
+		fdn.setdamping(0.3);
+		fdn.setdecaytime(96000.0);
+		stepandblock(bench, "FDNreverb", param("lines", numlines), fdn);
+	}
+
+	// State variable filter
+	SSfilter ss;
+	ss.setdamping(0.5);
+	ss.setF1(1000.0, 48000.0);
+	bench.run("SSfilter", "step", "", "sample", BLOCKSIZE, [&]() {
+		for (int n = 0; n < BLOCKSIZE; n++)
+		{
+			ss.step(input[n]);
+			output[n] = float(ss.getlp());
+		}
+		sink = output[BLOCKSIZE - 1];
+	});
+	bench.run("SSfilter", "procblock", "", "sample", BLOCKSIZE, [&]() {
+		ss.procblock(input.data(), output2.data(), nullptr, output.data(), BLOCKSIZE);
+		sink = output[BLOCKSIZE - 1];
+	});
+
+	// Modulated center frequency: sin() per sample versus the control rate ramp
+	std::vector<float> sweep(BLOCKSIZE);
+	for (int n = 0; n < BLOCKSIZE; n++)
+		sweep[n] = float(0.05 + 0.04 * std::sin(2.0 * PI * n / BLOCKSIZE));
+	bench.run("SSfilter", "step-modulated", "", "sample", BLOCKSIZE, [&]() {
+		for (int n = 0; n < BLOCKSIZE; n++)
+		{
+			ss.step(input[n], sweep[n]);
+			output[n] = float(ss.getlp());
+		}
+		sink = output[BLOCKSIZE - 1];
+	});
+	for (int period : { 1, 16, 64 })
+	{
+		ss.setcontrolperiod(period);
+		bench.run("SSfilter", "procblock-modulated", param("period", period), "sample", BLOCKSIZE, [&]() {
+			ss.procblock(input.data(), sweep.data(), nullptr, nullptr, output.data(), BLOCKSIZE);
+			sink = output[BLOCKSIZE - 1];
+		});
+	}
+
+	// Oversampled filter core: factor sweep
+	for (int factor : { 1, 2, 4 })
+	{
+		OversampledSSfilter oss;
+		oss.setfactor(factor);
+		oss.setdamping(0.5);
+		oss.setF1(15000.0, 48000.0);
+		bench.run("OversampledSSfilter", "procblock", param("factor", factor), "sample", BLOCKSIZE, [&]() {
+			oss.procblock(input.data(), nullptr, nullptr, output.data(), BLOCKSIZE);
+			sink = output[BLOCKSIZE - 1];
+		});
+	}
+
+	// Sample rate conversion: common ratios, timed per input sample
+	const int ratepairs[][2] = { { 44100, 48000 }, { 48000, 44100 }, { 48000, 96000 }, { 96000, 48000 } };
+	for (auto& rates : ratepairs)
+	{
+		Resampler rs;
+		rs.init(rates[0], rates[1]);
+		std::vector<float> converted(rs.getmaxoutput(BLOCKSIZE));
+		bench.run("Resampler", "procblock", param("from", rates[0]) + "," + param("to", rates[1]), "sample",
+			BLOCKSIZE, [&]() {
+			int count = rs.procblock(input.data(), BLOCKSIZE, converted.data());
+			sink = converted[count - 1];
+		});
+	}
+
+	// Modulated voices: separate filters versus the bank
+	for (int numchans : { 4, 16, 64 })
+	{
+		std::vector<std::vector<float>> chanbufs(numchans, input);
+		std::vector<float*> chanptrs;
+		std::vector<const float*> sweepptrs(numchans, sweep.data());
+		for (auto& buf : chanbufs)
+			chanptrs.push_back(buf.data());
+		std::vector<SSfilter> voices(numchans);
+		SSfilterBank bank;
+		bank.setnumchannels(numchans);
+		for (int ch = 0; ch < numchans; ch++)
+		{
+			voices[ch].setdamping(0.5);
+			bank.setdamping(ch, 0.5);
+		}
+		bench.run("SSfilter", "channels-modulated", param("channels", numchans), "ch-sample",
+			double(numchans) * BLOCKSIZE, [&]() {
+			for (int ch = 0; ch < numchans; ch++)
+				voices[ch].procblock(input.data(), sweep.data(), nullptr, nullptr, chanptrs[ch], BLOCKSIZE);
+			sink = chanptrs[0][0];
+		});
+		bench.run("SSfilterBank", "procblock-modulated", param("channels", numchans), "ch-sample",
+			double(numchans) * BLOCKSIZE, [&]() {
+			bank.procblock(chanptrs.data(), sweepptrs.data(), nullptr, nullptr, chanptrs.data(), BLOCKSIZE);
+			sink = chanptrs[0][0];
+		});
+	}
+
+	// Convolution: impulse response length sweep, uniform and non-uniform partitions
+	for (int irlength : { 1024, 16384, 131072 })
+	{
+		std::vector<float> ir(irlength);
+		for (int n = 0; n < irlength; n++)
+			ir[n] = input[n % BLOCKSIZE] * float(std::exp(-4.0 * n / irlength));
+		for (int maxpart : { BLOCKSIZE, 16 * BLOCKSIZE })
+		{
+			Convolver conv;
+			conv.init(ir.data(), irlength, BLOCKSIZE, maxpart);
+			bench.run("Convolver", maxpart > BLOCKSIZE ? "nonuniform" : "uniform", param("ir", irlength), "sample",
+				BLOCKSIZE, [&]() {
+				conv.procblock(input.data(), output.data(), BLOCKSIZE);
+				sink = output[BLOCKSIZE - 1];
+			});
+		}
+	}
+
+	// Waveguide meshes: network size sweep. One sample is one step of the whole network.
+	const unsigned int numthreads = std::thread::hardware_concurrency();
+	for (int size : { 4, 8, 16, 32, 64 })
+	{
+		auto src = std::make_shared<double>(0.0);
+		const float* in = input.data();
+		float* out = output.data();
+		MPnetwork mesh;
+		buildmesh(mesh, size, 8, src);
+		bench.run("MPnetwork", "elements", param("mesh", size), "step", BLOCKSIZE, [&]() {
+			mesh.netstep(BLOCKSIZE, &in, &out);
+			sink = output[BLOCKSIZE - 1];
+		});
+		mesh.compile();
+		bench.run("MPnetwork", "compiled", param("mesh", size), "step", BLOCKSIZE, [&]() {
+			mesh.netstep(BLOCKSIZE, &in, &out);
+			sink = output[BLOCKSIZE - 1];
+		});
+		if (numthreads > 1)
+		{
+			mesh.compile(numthreads);
+			bench.run("MPnetwork", "threads=" + std::to_string(numthreads), param("mesh", size), "step", BLOCKSIZE, [&]() {
+				mesh.netstep(BLOCKSIZE, &in, &out);
+				sink = output[BLOCKSIZE - 1];
+			});
+		}
+	}
+
+	// Rectilinear meshes: grid size sweep in 2D and 3D, up to the 10 m room of AudioClasses
+	// at 44.1 kHz in 2D. Large meshes are stepped fewer times per call.
+	const int meshsizes[][3] = { { 64, 64, 1 }, { 256, 256, 1 }, { 0, 0, 1 }, { 16, 16, 16 }, { 32, 32, 32 },
+		{ 64, 64, 64 } };
+	for (auto& dims : meshsizes)
+	{
+		const bool room = dims[0] == 0;
+		const int nx = room ? WaveguideMesh::junctionsfor(10.0, 44100.0, 2) : dims[0];
+		const int ny = room ? nx : dims[1];
+		WaveguideMesh grid;
+		grid.init(nx, ny, dims[2]);
+		grid.setdamping(0.1);
+		grid.setreflection(0.9);
+		grid.addsource(nx / 3, ny / 2, dims[2] / 2);
+		grid.addtap(nx - 2, ny / 3, dims[2] / 2);
+		const int numsteps = std::max(1, std::min(BLOCKSIZE, (1 << 20) / grid.getnumjunctions()));
+		const float* in = input.data();
+		float* out = output.data();
+		std::string prm = std::to_string(nx) + "x" + std::to_string(ny);
+		if (dims[2] > 1)
+			prm += "x" + std::to_string(dims[2]);
+		bench.run("WaveguideMesh", room ? "room" : "procblock", "mesh=" + prm, "junction",
+			double(grid.getnumjunctions()) * numsteps, [&]() {
+			grid.procblock(numsteps, &in, &out);
+			sink = output[numsteps - 1];
+		});
+	}
+
+	if (csvfile && !bench.writecsv(csvfile))
+		printf("could not write %s\n", csvfile);
+	if (jsonfile && !bench.writejson(jsonfile))
+		printf("could not write %s\n", jsonfile);
+	return 0;
+}
@@ -0,0 +1,69 @@
+/*
+  ==============================================================================
+
+    BenchCommon.h
+
+    Block buffers, test signal and timing loop shared by the benchmark
+    programs. Each benchmark is a single source file, so the buffers are
+    defined here rather than in a separate translation unit.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+constexpr int BLOCKSIZE = 512;
+constexpr int NUMTRIALS = 5;
+
+static std::vector<float> input(BLOCKSIZE);
+static std::vector<float> output(BLOCKSIZE);
+static std::vector<float> output2(BLOCKSIZE);
+static volatile double sink; // results are stored here so they are not optimized away
+
+/// <summary>
+/// Fill the input block with a full scale test signal, the same on every run
+/// </summary>
+inline void fillinput()
+{
+	for (int n = 0; n < BLOCKSIZE; n++)
+		input[n] = float((n * 7919) % 2001 - 1000) / 1000.0f;
+}
+
+/// <summary>
+/// Measure the throughput of a processing function
+///
+/// The function is called repeatedly until the minimum time has passed, and the fastest of
+/// NUMTRIALS such runs is reported.
+/// </summary>
+/// <param name="proc">function to time</param>
+/// <param name="samplespercall">samples processed by each call of proc</param>
+/// <param name="mintime">minimum time spent on all of the runs (seconds)</param>
+/// <returns>samples per second</returns>
+template <typename Proc>
+double measurerate(Proc proc, double samplespercall, double mintime)
+{
+	proc(); // warm up caches and branch predictors
+	double best = 0.0;
+	long calls = 1;
+	for (int trial = 0; trial < NUMTRIALS; trial++)
+	{
+		double secs = 0.0;
+		long done = 0;
+		auto start = std::chrono::steady_clock::now();
+		while (secs < mintime / NUMTRIALS)
+		{
+			for (long k = 0; k < calls; k++)
+				proc();
+			done += calls;
+			secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			if (secs < mintime / NUMTRIALS / 10)
+				calls *= 2;
+		}
+		double rate = done * samplespercall / secs;
+		best = rate > best ? rate : best;
+	}
+	return best;
+}
@@ -0,0 +1,329 @@
+/*
+  ==============================================================================
+
+    BlockBench.cpp
+
+    Compares the throughput of the per-sample step() loop with the block
+    procblock() method for each class, and the element-by-element netstep() of
+    an MPnetwork mesh with its compiled plan (single and multithreaded), and
+    checks that the worker threads of a compiled network follow the subnormal
+    flushing mode of the calling thread, and that a compiled network can be
+    copied and moved. Build together with the library sources,
+    e.g. g++ -O2 -I.. BlockBench.cpp ../BQfilter.cpp ../SOSfilter.cpp ...
+
+  ==============================================================================
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include "BQfilter.h"
+#include "BQfilterBank.h"
+#include "DenormalContext.h"
+#include "DelayLine.h"
+#include "FixedSOSfilter.h"
+#include "LPAPfilter.h"
+#include "LPcombfilter.h"
+#include "MultiPort.h"
+#include "SOSfilter.h"
+#include "SSfilter.h"
+#include "BenchCommon.h"
+
+// Minimum time spent timing each method (seconds)
+constexpr double BLOCKTIME = 0.25;
+
+/// <summary>
+/// Time a processing function and report samples per second
+/// </summary>
+/// <param name="name">label for the output line</param>
+/// <param name="proc">function that processes one block of samples</param>
+/// <param name="blocksize">number of samples processed by each call of proc</param>
+template <typename Proc>
+double timeblocks(const char* name, Proc proc, int blocksize = BLOCKSIZE)
+{
+	double rate = measurerate(proc, blocksize, BLOCKTIME);
+	sink = output[BLOCKSIZE - 1];
+	printf("  %-10s %12.1f Msamples/s\n", name, rate * 1e-6);
+	return rate;
+}
+
+template <typename Filter>
+void compare(const char* name, Filter& stepfilt, Filter& blockfilt)
+{
+	printf("%s\n", name);
+	double steprate = timeblocks("step()", [&]() {
+		for (int n = 0; n < BLOCKSIZE; n++)
+			output[n] = float(stepfilt.step(input[n]));
+	});
+	double blockrate = timeblocks("procblock()", [&]() {
+		blockfilt.procblock(input.data(), output.data(), BLOCKSIZE);
+	});
+	printf("  speedup    %12.2fx\n", blockrate / steprate);
+}
+
+/// <summary>
+/// Build a square mesh of 4-port junctions joined by waveguides, grounded at the edges
+/// </summary>
+/// <param name="net">network (empty)</param>
+/// <param name="size">number of junctions along each side</param>
+/// <param name="src">source feeding the corner junction</param>
+void buildmesh(MPnetwork& net, int size, std::shared_ptr<double> src)
+{
+	net.addJunctions(size * size);
+	net.addWaveguides(2 * size * (size - 1));
+	int wg = 0;
+	for (int j = 0; j < size * size; j++)
+		net.setNumPorts(j, 4);
+	// ports are 0 north, 1 east, 2 south, 3 west
+	for (int row = 0; row < size; row++)
+		for (int col = 0; col < size; col++)
+		{
+			int j = row * size + col;
+			if (col + 1 < size)
+			{
+				net.setWGparams(wg, 1 + (j * 13) % 29, 0.1);
+				net.connect(wg++, j, 1, j + 1, 3);
+			}
+			if (row + 1 < size)
+			{
+				net.setWGparams(wg, 2 + (j * 7) % 31, 0.2);
+				net.connect(wg++, j, 2, j + size, 0);
+			}
+			if (row == 0 && col > 0)
+				net.addground(j, 0);
+			if (row == size - 1)
+				net.addground(j, 2);
+			if (col == 0)
+				net.addground(j, 3);
+			if (col == size - 1)
+				net.addground(j, 1);
+		}
+	net.addsource(0, 0, src);
+}
+
+int main()
+{
+	fillinput();
+
+	BQfilter bq[2];
+	for (auto& f : bq)
+		f.update(FilterType::PEAK, 6.0, 1000.0, 2.0, 48000.0);
+	compare("BQfilter", bq[0], bq[1]);
+
+	SOSfilter sos[2];
+	for (auto& f : sos)
+	{
+		f.initsos(4, 48000.0);
+		f.updateSection(0, FilterType::BASS, 3.0, 100.0, 0.7);
+		f.updateSection(1, FilterType::PEAK, -4.0, 500.0, 2.0);
+		f.updateSection(2, FilterType::PEAK, 2.0, 2000.0, 1.0);
+		f.updateSection(3, FilterType::TREBLE, -3.0, 8000.0, 0.7);
+	}
+	compare("SOSfilter (4 sections)", sos[0], sos[1]);
+
+	FixedSOSfilter<4> fixedsos[2];
+	for (auto& f : fixedsos)
+	{
+		f.initsos(4, 48000.0);
+		f.updateSection(0, FilterType::BASS, 3.0, 100.0, 0.7);
+		f.updateSection(1, FilterType::PEAK, -4.0, 500.0, 2.0);
+		f.updateSection(2, FilterType::PEAK, 2.0, 2000.0, 1.0);
+		f.updateSection(3, FilterType::TREBLE, -3.0, 8000.0, 0.7);
+	}
+	compare("FixedSOSfilter<4>", fixedsos[0], fixedsos[1]);
+
+	DelayLine dl[2];
+	for (auto& f : dl)
+	{
+		f.setsampledelay(1447);
+		f.setdamping(0.3);
+	}
+	compare("DelayLine", dl[0], dl[1]);
+
+	LPcombfilter comb[2];
+	for (auto& f : comb)
+	{
+		f.setdelay(1447);
+		f.setdamping(0.3);
+		f.setreflection(0.8);
+	}
+	compare("LPcombfilter", comb[0], comb[1]);
+
+	LPAPfilter ap[2];
+	for (auto& f : ap)
+	{
+		f.setdelay(341);
+		f.setdamping(0.3);
+		f.setreflection(0.5);
+	}
+	compare("LPAPfilter", ap[0], ap[1]);
+
+	SSfilter ss[2];
+	for (auto& f : ss)
+	{
+		f.setdamping(0.5);
+		f.setF1(1000.0, 48000.0);
+	}
+	printf("SSfilter\n");
+	double steprate = timeblocks("step()", [&]() {
+		for (int n = 0; n < BLOCKSIZE; n++)
+		{
+			ss[0].step(input[n]);
+			output[n] = float(ss[0].getlp());
+		}
+	});
+	double blockrate = timeblocks("procblock()", [&]() {
+		ss[1].procblock(input.data(), nullptr, nullptr, output.data(), BLOCKSIZE);
+	});
+	printf("  speedup    %12.2fx\n", blockrate / steprate);
+
+	Waveguide wg[2];
+	auto src0 = std::make_shared<double>(0.0);
+	auto src1 = std::make_shared<double>(0.0);
+	for (auto& f : wg)
+	{
+		f.setDelay(1447);
+		f.setDamping(0.3);
+		f.setInputPtr(0, src0);
+		f.setInputPtr(1, src1);
+	}
+	printf("Waveguide\n");
+	steprate = timeblocks("step()", [&]() {
+		for (int n = 0; n < BLOCKSIZE; n++)
+		{
+			*src0 = input[n];
+			*src1 = input[BLOCKSIZE - 1 - n];
+			wg[0].step();
+			output[n] = float(*wg[0].getOutputPtr(0));
+			output2[n] = float(*wg[0].getOutputPtr(1));
+		}
+	});
+	blockrate = timeblocks("procblock()", [&]() {
+		wg[1].procblock(input.data(), input.data(), output.data(), output2.data(), BLOCKSIZE);
+	});
+	printf("  speedup    %12.2fx\n", blockrate / steprate);
+
+	// Waveguide mesh: elements stepped one by one versus the compiled plan, on one thread
+	// and split across MESHTHREADS threads
+	constexpr int MESHSIZE = 32;
+	constexpr int MESHSTEPS = BLOCKSIZE / 16;
+	constexpr int MESHTHREADS = 4;
+	MPnetwork mesh[3];
+	auto meshsrc = std::make_shared<double>(0.0);
+	for (auto& net : mesh)
+	{
+		buildmesh(net, MESHSIZE, meshsrc);
+		net.addtap(0, 0);
+	}
+	mesh[1].compile();
+	mesh[2].compile(MESHTHREADS);
+	printf("MPnetwork (%dx%d mesh, rates in junction updates/s)\n", MESHSIZE, MESHSIZE);
+	steprate = timeblocks("elements", [&]() {
+		for (int n = 0; n < MESHSTEPS; n++)
+		{
+			*meshsrc = input[n];
+			mesh[0].netstep();
+			output[n] = float(mesh[0].getoutput(0, 0));
+		}
+	}, MESHSTEPS * MESHSIZE * MESHSIZE);
+	blockrate = timeblocks("compiled", [&]() {
+		for (int n = 0; n < MESHSTEPS; n++)
+		{
+			*meshsrc = input[n];
+			mesh[1].netstep();
+			output[n] = float(mesh[1].getoutput(0, 0));
+		}
+	}, MESHSTEPS * MESHSIZE * MESHSIZE);
+	printf("  speedup    %12.2fx\n", blockrate / steprate);
+	const float* meshin = input.data();
+	float* meshout = output.data();
+	blockrate = timeblocks("threads", [&]() {
+		mesh[2].netstep(MESHSTEPS, &meshin, &meshout);
+	}, MESHSTEPS * MESHSIZE * MESHSIZE);
+	printf("  speedup    %12.2fx (%d threads, %u samples per barrier)\n", blockrate / steprate, MESHTHREADS,
+		mesh[2].getblocklimit());
+
+	// Subnormal flushing in the worker threads: a subnormal float fed to the far corner, which
+	// is stepped by the last thread, reaches the junction output unless that thread flushes
+	if (DenormalContext::canflush())
+	{
+		constexpr int FLUSHSIZE = 8;
+		constexpr int CORNER = FLUSHSIZE * FLUSHSIZE - 1;
+		const float zeros[1] = { 0.0f };
+		const float tiny[1] = { 1e-40f };
+		const float* flushin[2] = { zeros, tiny };
+		double corner[2];
+		for (int flush = 0; flush < 2; flush++)
+		{
+			MPnetwork net;
+			buildmesh(net, FLUSHSIZE, meshsrc);
+			net.addsource(CORNER, 1, std::make_shared<double>(0.0));
+			net.compile(MESHTHREADS);
+			if (flush)
+			{
+				DenormalContext context(DenormalMode::FLUSH);
+				net.netstep(1, flushin, nullptr);
+			}
+			else
+				net.netstep(1, flushin, nullptr);
+			corner[flush] = net.getoutput(CORNER, 1);
+		}
+		const bool ok = corner[0] != 0.0 && corner[1] == 0.0;
+		printf("MPnetwork (%d threads) subnormal flushing in worker threads: %s\n", MESHTHREADS,
+			ok ? "ok" : "FAILED");
+		if (!ok)
+			return 1;
+	}
+
+	// A copy of a compiled network carries on from the same state on threads of its own, and
+	// a network moved into place keeps its plan
+	{
+		MPnetwork original;
+		buildmesh(original, MESHSIZE, meshsrc);
+		original.addtap(0, 0);
+		original.compile(MESHTHREADS);
+		original.netstep(MESHSTEPS, &meshin, &meshout);
+		MPnetwork copy(original);
+		MPnetwork moved;
+		moved = MPnetwork(original);
+		std::vector<float> copyout(MESHSTEPS), movedout(MESHSTEPS);
+		float* copyptr = copyout.data();
+		float* movedptr = movedout.data();
+		original.netstep(MESHSTEPS, &meshin, &meshout);
+		copy.netstep(MESHSTEPS, &meshin, &copyptr);
+		moved.netstep(MESHSTEPS, &meshin, &movedptr);
+		const bool ok = copy.iscompiled() && moved.iscompiled()
+			&& std::equal(copyout.begin(), copyout.end(), output.begin())
+			&& std::equal(movedout.begin(), movedout.end(), output.begin());
+		printf("MPnetwork (%d threads) copy and move of a compiled network: %s\n", MESHTHREADS, ok ? "ok" : "FAILED");
+		if (!ok)
+			return 1;
+	}
+
+	// Multichannel EQ: one BQfilter per channel versus the SIMD bank
+	constexpr int NUMCHANS = 32;
+	std::vector<std::vector<float>> chanbufs(NUMCHANS, input);
+	std::vector<float*> chanptrs;
+	for (auto& buf : chanbufs)
+		chanptrs.push_back(buf.data());
+	std::vector<BQfilter> chanfilts(NUMCHANS);
+	BQfilterBank bank;
+	bank.setnumchannels(NUMCHANS);
+	for (int ch = 0; ch < NUMCHANS; ch++)
+	{
+		chanfilts[ch].update(FilterType::PEAK, 6.0, 1000.0, 2.0, 48000.0);
+		bank.update(ch, FilterType::PEAK, 6.0, 1000.0, 2.0, 48000.0);
+	}
+	printf("BQfilterBank (%d channels, rates in frames/s)\n", NUMCHANS);
+	steprate = timeblocks("BQfilter", [&]() {
+		for (int ch = 0; ch < NUMCHANS; ch++)
+			chanfilts[ch].procblock(chanptrs[ch], BLOCKSIZE);
+	});
+	blockrate = timeblocks("bank", [&]() {
+		bank.procblock(chanptrs.data(), BLOCKSIZE);
+	});
+	printf("  speedup    %12.2fx\n", blockrate / steprate);
+
+	return 0;
+}
@@ -0,0 +1,520 @@
+/*
+  ==============================================================================
+
+    BatchRender.cpp
+
+    Offline batch renderer. Every input file is streamed through a processing
+    chain read from a text file and written to the output directory under the
+    same name. Files, and the channels within each file, are spread across a
+    work-stealing thread pool. Each channel is processed in order by its own
+    copy of the chain, so the output is bit-identical for any number of
+    threads. Build together with the library sources, e.g.
+    g++ -O2 -pthread -I.. BatchRender.cpp ../SOSfilter.cpp ../BQfilter.cpp ...
+
+    Usage: BatchRender -c chain.txt [-o outdir] [-j threads] [-l listfile]
+                       [--format int16|int24|int32|float32|float64]
+                       [--block frames] [--rate Hz] [input.wav ...]
+
+    With --rate the chain runs at that sampling rate whatever the rate of the
+    file: each channel is converted to it on the way in and back to the file's
+    rate on the way out (Resampler), and the delay of the conversion is
+    removed (to the nearest frame), so one chain file serves sources at 44.1, 48 or 96 kHz alike.
+    Delays in the chain file are then in samples at the chain rate.
+
+    Chain file: one stage per line, applied in series; '#' starts a comment.
+        eq bass|treble|peak <gain dB> <f0 Hz> <Q>   (consecutive eq lines form
+                                                     one SOSfilter cascade)
+        comb <delay samples> <damping> <reflection>
+        allpass <delay samples> <damping> <reflection>
+        delay <delay samples> <damping>
+        gain <linear gain>
+        parallel ... end    (each stage inside is a branch fed the same input;
+                             the branch outputs are summed)
+
+  ==============================================================================
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "DelayLine.h"
+#include "LPAPfilter.h"
+#include "LPcombfilter.h"
+#include "Resampler.h"
+#include "SOSfilter.h"
+#include "TaskPool.h"
+#include "WavFile.h"
+
+//==============================================================================
+// Chain description
+
+struct EQsection
+{
+	FilterType type;
+	double gain, f0, Q;
+};
+
+struct StageSpec
+{
+	enum Kind { EQ, COMB, ALLPASS, DELAY, GAIN, PARALLEL } kind;
+	std::vector<EQsection> sections; // EQ
+	int delay = 0;
+	double damping = 0.0, reflection = 0.0, gain = 1.0;
+	std::vector<StageSpec> branches; // PARALLEL
+};
+
+static bool parseerror(const char* filename, int line, const char* message)
+{
+	fprintf(stderr, "%s:%d: %s\n", filename, line, message);
+	return false;
+}
+
+static bool parsechain(const char* filename, std::vector<StageSpec>& chain)
+{
+	std::ifstream file(filename);
+	if (!file)
+	{
+		fprintf(stderr, "cannot read %s\n", filename);
+		return false;
+	}
+	std::vector<StageSpec>* target = &chain;
+	std::string text;
+	for (int line = 1; std::getline(file, text); line++)
+	{
+		text = text.substr(0, text.find('#'));
+		std::istringstream words(text);
+		std::string word;
+		if (!(words >> word))
+			continue;
+		StageSpec stage;
+		if (word == "eq")
+		{
+			std::string type;
+			EQsection sect;
+			if (!(words >> type >> sect.gain >> sect.f0 >> sect.Q))
+				return parseerror(filename, line, "expected: eq <type> <gain> <f0> <Q>");
+			if (type == "bass")
+				sect.type = FilterType::BASS;
+			else if (type == "treble")
+				sect.type = FilterType::TREBLE;
+			else if (type == "peak")
+				sect.type = FilterType::PEAK;
+			else
+				return parseerror(filename, line, "eq type must be bass, treble or peak");
+			// consecutive sections form one cascade (except as parallel branches)
+			if (target == &chain && !target->empty() && target->back().kind == StageSpec::EQ)
+			{
+				target->back().sections.push_back(sect);
+				continue;
+			}
+			stage.kind = StageSpec::EQ;
+			stage.sections.push_back(sect);
+		}
+		else if (word == "comb" || word == "allpass")
+		{
+			stage.kind = word == "comb" ? StageSpec::COMB : StageSpec::ALLPASS;
+			if (!(words >> stage.delay >> stage.damping >> stage.reflection) || stage.delay < 1)
+				return parseerror(filename, line, "expected: comb|allpass <delay> <damping> <reflection>");
+		}
+		else if (word == "delay")
+		{
+			stage.kind = StageSpec::DELAY;
+			if (!(words >> stage.delay >> stage.damping) || stage.delay < 1)
+				return parseerror(filename, line, "expected: delay <delay> <damping>");
+		}
+		else if (word == "gain")
+		{
+			stage.kind = StageSpec::GAIN;
+			if (!(words >> stage.gain))
+				return parseerror(filename, line, "expected: gain <gain>");
+		}
+		else if (word == "parallel")
+		{
+			if (target != &chain)
+				return parseerror(filename, line, "parallel sections cannot be nested");
+			stage.kind = StageSpec::PARALLEL;
+			chain.push_back(stage);
+			target = &chain.back().branches;
+			continue;
+		}
+		else if (word == "end")
+		{
+			if (target == &chain)
+				return parseerror(filename, line, "end without parallel");
+			target = &chain;
+			continue;
+		}
+		else
+			return parseerror(filename, line, "unknown stage");
+		target->push_back(stage);
+	}
+	if (target != &chain)
+		return parseerror(filename, 0, "parallel without end");
+	if (chain.empty())
+		return parseerror(filename, 0, "empty chain");
+	return true;
+}
+
+//==============================================================================
+// Processing chain for one channel
+
+class Stage
+{
+public:
+	virtual ~Stage() {}
+	virtual void procblock(float* samples, int numsamples) = 0;
+};
+
+// Adapter for the filter classes, which all provide procblock(float*, int)
+template <typename Filter>
+class FilterStage : public Stage
+{
+public:
+	Filter filter;
+	void procblock(float* samples, int numsamples) override { filter.procblock(samples, numsamples); }
+};
+
+class GainStage : public Stage
+{
+public:
+	explicit GainStage(double g) : gain(float(g)) {}
+	void procblock(float* samples, int numsamples) override
+	{
+		for (int n = 0; n < numsamples; n++)
+			samples[n] *= gain;
+	}
+
+private:
+	float gain;
+};
+
+class ParallelStage : public Stage
+{
+public:
+	ParallelStage(std::vector<std::unique_ptr<Stage>> b, int blocksize)
+		: branches(std::move(b)), input(blocksize), branch(blocksize)
+	{
+	}
+	void procblock(float* samples, int numsamples) override
+	{
+		std::copy(samples, samples + numsamples, input.begin());
+		for (int n = 0; n < numsamples; n++)
+			samples[n] = 0.0f;
+		for (auto& stage : branches)
+		{
+			std::copy(input.begin(), input.begin() + numsamples, branch.begin());
+			stage->procblock(branch.data(), numsamples);
+			for (int n = 0; n < numsamples; n++)
+				samples[n] += branch[n];
+		}
+	}
+
+private:
+	std::vector<std::unique_ptr<Stage>> branches;
+	std::vector<float> input, branch;
+};
+
+static std::unique_ptr<Stage> buildstage(const StageSpec& spec, double fs, int blocksize)
+{
+	switch (spec.kind)
+	{
+	case StageSpec::EQ:
+	{
+		auto stage = new FilterStage<SOSfilter>;
+		stage->filter.initsos(int(spec.sections.size()), fs);
+		for (unsigned int k = 0; k < spec.sections.size(); k++)
+		{
+			const EQsection& sect = spec.sections[k];
+			stage->filter.updateSection(int(k), sect.type, sect.gain, sect.f0, sect.Q);
+		}
+		return std::unique_ptr<Stage>(stage);
+	}
+	case StageSpec::COMB:
+	{
+		auto stage = new FilterStage<LPcombfilter>;
+		stage->filter.setdelay(spec.delay);
+		stage->filter.setdamping(spec.damping);
+		stage->filter.setreflection(spec.reflection);
+		return std::unique_ptr<Stage>(stage);
+	}
+	case StageSpec::ALLPASS:
+	{
+		auto stage = new FilterStage<LPAPfilter>;
+		stage->filter.setdelay(spec.delay);
+		stage->filter.setdamping(spec.damping);
+		stage->filter.setreflection(spec.reflection);
+		return std::unique_ptr<Stage>(stage);
+	}
+	case StageSpec::DELAY:
+	{
+		auto stage = new FilterStage<DelayLine>;
+		stage->filter.setsampledelay(spec.delay);
+		stage->filter.setdamping(spec.damping);
+		return std::unique_ptr<Stage>(stage);
+	}
+	case StageSpec::GAIN:
+		return std::unique_ptr<Stage>(new GainStage(spec.gain));
+	case StageSpec::PARALLEL:
+	{
+		std::vector<std::unique_ptr<Stage>> branches;
+		for (auto& branch : spec.branches)
+			branches.push_back(buildstage(branch, fs, blocksize));
+		return std::unique_ptr<Stage>(new ParallelStage(std::move(branches), blocksize));
+	}
+	}
+	return nullptr;
+}
+
+typedef std::vector<std::unique_ptr<Stage>> Chain;
+
+static Chain buildchain(const std::vector<StageSpec>& spec, double fs, int blocksize)
+{
+	Chain chain;
+	for (auto& stage : spec)
+		chain.push_back(buildstage(stage, fs, blocksize));
+	return chain;
+}
+
+//==============================================================================
+// Rendering
+
+struct FileJob
+{
+	std::string input, output;
+	bool ok = false;
+	unsigned long long numframes = 0;
+	int numchannels = 0;
+	double seconds = 0.0;
+};
+
+// Frames read and processed between writes: the channels of a segment are processed in
+// parallel, then the segment is written
+constexpr int SEGMENTBLOCKS = 16;
+
+static void renderjob(FileJob& job, const std::vector<StageSpec>& spec, TaskPool& pool, int blocksize,
+	bool sameformat, SampleFormat format, int rate)
+{
+	auto start = std::chrono::steady_clock::now();
+	WavReader in;
+	WavWriter out;
+	if (!in.open(job.input.c_str()))
+	{
+		fprintf(stderr, "cannot read %s\n", job.input.c_str());
+		return;
+	}
+	const int numchannels = in.getnumchannels();
+	const int filerate = int(in.getsamplerate());
+	const bool convert = rate > 0 && rate != filerate;
+	const int segment = blocksize * SEGMENTBLOCKS;
+
+	// conversion to the chain rate and back, per channel
+	std::vector<Resampler> into(convert ? numchannels : 0), outof(convert ? numchannels : 0);
+	std::vector<std::vector<float>> inner(into.size()), outer(into.size());
+	unsigned long long skip = 0;
+	for (unsigned int ch = 0; ch < into.size(); ch++)
+	{
+		if (!into[ch].init(filerate, rate) || !outof[ch].init(rate, filerate))
+		{
+			fprintf(stderr, "cannot convert %s from %d Hz to %d Hz\n", job.input.c_str(), filerate, rate);
+			return;
+		}
+		inner[ch].resize(into[ch].getmaxoutput(segment));
+		outer[ch].resize(outof[ch].getmaxoutput(int(inner[ch].size())));
+	}
+	if (convert)
+		skip = (unsigned long long)std::lround(into[0].getlatency() + outof[0].getlatency() * filerate / rate);
+
+	if (!out.open(job.output.c_str(), numchannels, in.getsamplerate(), sameformat ? in.getformat() : format))
+	{
+		fprintf(stderr, "cannot write %s\n", job.output.c_str());
+		return;
+	}
+	std::vector<Chain> chains;
+	for (int ch = 0; ch < numchannels; ch++)
+		chains.push_back(buildchain(spec, convert ? rate : filerate, blocksize));
+
+	std::vector<float> buffer(std::size_t(numchannels) * segment);
+	std::vector<float*> channels(numchannels);
+	for (int ch = 0; ch < numchannels; ch++)
+		channels[ch] = buffer.data() + std::size_t(ch) * segment;
+	std::vector<float*> outchannels(numchannels);
+	std::vector<int> produced(numchannels);
+
+	// the chain always sees blocks of blocksize frames (whatever the thread count)
+	auto runchain = [&](int ch, float* samples, int len) {
+		for (int first = 0; first < len; first += blocksize)
+		{
+			int n = len - first < blocksize ? len - first : blocksize;
+			for (auto& stage : chains[ch])
+				stage->procblock(samples + first, n);
+		}
+	};
+	unsigned long long framesread = 0;
+	for (;;)
+	{
+		int numframes = in.read(channels.data(), segment);
+		if (numframes > 0)
+			framesread += numframes;
+		else if (convert && job.numframes < framesread)
+		{
+			// push silence through the converters until the delayed end comes out
+			numframes = segment;
+			std::fill(buffer.begin(), buffer.end(), 0.0f);
+		}
+		else
+			break;
+		auto process = [&, numframes](int ch) {
+			if (!convert)
+			{
+				runchain(ch, channels[ch], numframes);
+				return;
+			}
+			const int len = into[ch].procblock(channels[ch], numframes, inner[ch].data());
+			runchain(ch, inner[ch].data(), len);
+			produced[ch] = outof[ch].procblock(inner[ch].data(), len, outer[ch].data());
+		};
+		TaskGroup group;
+		for (int ch = 1; ch < numchannels; ch++)
+			pool.submit(group, [&process, ch]() { process(ch); });
+		process(0);
+		pool.wait(group);
+		int first = 0;
+		int count = numframes;
+		if (convert)
+		{
+			// every channel produces the same number of frames
+			first = int(std::min<unsigned long long>(skip, produced[0]));
+			skip -= first;
+			count = int(std::min<unsigned long long>(produced[0] - first, framesread - job.numframes));
+		}
+		for (int ch = 0; ch < numchannels; ch++)
+			outchannels[ch] = (convert ? outer[ch].data() : channels[ch]) + first;
+		if (!out.write(outchannels.data(), count))
+			break;
+		job.numframes += count;
+	}
+	job.ok = out.close();
+	job.numchannels = numchannels;
+	job.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static std::string basename(const std::string& path)
+{
+	std::string::size_type slash = path.find_last_of("/\\");
+	return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+static int usage(const char* program)
+{
+	printf("usage: %s -c chain.txt [-o outdir] [-j threads] [-l listfile]\n"
+		"       [--format int16|int24|int32|float32|float64] [--block frames] [--rate Hz] [input.wav ...]\n",
+		program);
+	return 1;
+}
+
+int main(int argc, char* argv[])
+{
+	const char* chainfile = nullptr;
+	std::string outdir = ".";
+	unsigned int numthreads = 0;
+	int blocksize = 1024;
+	int rate = 0;
+	bool sameformat = true;
+	SampleFormat format = SampleFormat::FLOAT32;
+	std::vector<std::string> inputs;
+	for (int k = 1; k < argc; k++)
+	{
+		if (!std::strcmp(argv[k], "-c") && k + 1 < argc)
+			chainfile = argv[++k];
+		else if (!std::strcmp(argv[k], "-o") && k + 1 < argc)
+			outdir = argv[++k];
+		else if (!std::strcmp(argv[k], "-j") && k + 1 < argc)
+			numthreads = unsigned(std::atoi(argv[++k]));
+		else if (!std::strcmp(argv[k], "--block") && k + 1 < argc)
+			blocksize = std::atoi(argv[++k]);
+		else if (!std::strcmp(argv[k], "--rate") && k + 1 < argc)
+			rate = std::atoi(argv[++k]);
+		else if (!std::strcmp(argv[k], "-l") && k + 1 < argc)
+		{
+			std::ifstream list(argv[++k]);
+			if (!list)
+			{
+				fprintf(stderr, "cannot read %s\n", argv[k]);
+				return 1;
+			}
+			std::string name;
+			while (std::getline(list, name))
+				if (!name.empty() && name[0] != '#')
+					inputs.push_back(name);
+		}
+		else if (!std::strcmp(argv[k], "--format") && k + 1 < argc)
+		{
+			const char* names[] = { "int16", "int24", "int32", "float32", "float64" };
+			const char* name = argv[++k];
+			sameformat = false;
+			int f = 0;
+			while (f < 5 && std::strcmp(name, names[f]))
+				f++;
+			if (f == 5)
+				return usage(argv[0]);
+			format = SampleFormat(f);
+		}
+		else if (argv[k][0] == '-')
+			return usage(argv[0]);
+		else
+			inputs.push_back(argv[k]);
+	}
+	if (!chainfile || inputs.empty() || blocksize < 1 || rate < 0)
+		return usage(argv[0]);
+	std::vector<StageSpec> spec;
+	if (!parsechain(chainfile, spec))
+		return 1;
+
+	std::vector<FileJob> jobs(inputs.size());
+	for (unsigned int k = 0; k < inputs.size(); k++)
+	{
+		jobs[k].input = inputs[k];
+		jobs[k].output = outdir + "/" + basename(inputs[k]);
+		if (jobs[k].output == jobs[k].input)
+		{
+			fprintf(stderr, "output would overwrite %s\n", inputs[k].c_str());
+			return 1;
+		}
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	TaskPool pool(numthreads);
+	TaskGroup all;
+	for (auto& job : jobs)
+		pool.submit(all, [&]() { renderjob(job, spec, pool, blocksize, sameformat, format, rate); });
+	pool.wait(all);
+	double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	int failed = 0;
+	unsigned long long totalsamples = 0;
+	for (auto& job : jobs)
+	{
+		if (!job.ok)
+		{
+			failed++;
+			printf("%-40s FAILED\n", job.input.c_str());
+			continue;
+		}
+		const double samples = double(job.numframes) * job.numchannels;
+		totalsamples += job.numframes * job.numchannels;
+		printf("%-40s %12llu frames %3d ch %9.3f s %10.2f Msamples/s\n", job.input.c_str(), job.numframes,
+			job.numchannels, job.seconds, job.seconds > 0.0 ? samples / job.seconds * 1e-6 : 0.0);
+	}
+	printf("%u files, %llu samples, %u threads, %.3f s wall, %.2f Msamples/s\n", unsigned(jobs.size()),
+		totalsamples, pool.getnumthreads(), wall, wall > 0.0 ? double(totalsamples) / wall * 1e-6 : 0.0);
+	return failed ? 1 : 0;
+}